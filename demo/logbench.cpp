@@ -26,37 +26,93 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+// Benchmark for logging.
+//
+// For each appender and number of threads the threads log a number of
+// messages at an enabled level (info) and at a disabled level (debug).
+// The results are printed as csv to stdout: throughput, latency
+// percentiles of a single log call and the time spent waiting for the log
+// mutex. The file appenders write logbench.log and logbench.ring into the
+// current directory; the log output of the fd appender goes to stderr, so
+// run e.g.:
+//
+//   logbench -t 1,4,8 -A fd,file,udp 2>/dev/null
+//
+
 #include <cxxtools/log.h>
+#include <cxxtools/log/cxxtools.h>
 #include <cxxtools/smartptr.h>
 #include <cxxtools/refcounted.h>
+#include <cxxtools/serializationinfo.h>
+#include <cxxtools/net/udp.h>
+#include <cxxtools/mutex.h>
+#include <cxxtools/condition.h>
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <stdexcept>
 #include <cxxtools/arg.h>
 #include <cxxtools/thread.h>
+#include <cxxtools/convert.h>
 #include <sys/time.h>
-#include <iomanip>
+#include <time.h>
+#include <unistd.h>
 
 namespace bench
 {
   log_define("bench")
 
+  unsigned long long now()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+  }
+
+  // lets the logging threads start at the same time
+  class StartSignal
+  {
+      cxxtools::Mutex mutex;
+      cxxtools::Condition cond;
+      bool started;
+
+    public:
+      StartSignal()
+        : started(false)
+        { }
+
+      void wait()
+      {
+        cxxtools::MutexLock lock(mutex);
+        while (!started)
+          cond.wait(lock);
+      }
+
+      void start()
+      {
+        cxxtools::MutexLock lock(mutex);
+        started = true;
+        cond.broadcast();
+      }
+  };
+
   class Logtester : public cxxtools::RefCounted
   {
       cxxtools::AttachedThread thread;
+      StartSignal& startSignal;
       unsigned long count;
-      unsigned long loops;
-      unsigned long enabled;
+      bool enabled;
 
     public:
-      Logtester(unsigned long count_,
-                unsigned long loops_,
-                unsigned long enabled_)
+      // duration of each log call in nanoseconds
+      std::vector<unsigned> latencies;
+
+      Logtester(StartSignal& startSignal_, unsigned long count_, bool enabled_)
         : thread( cxxtools::callable(*this, &Logtester::run) ),
+          startSignal(startSignal_),
           count(count_),
-          loops(loops_),
           enabled(enabled_)
-          { }
+          { latencies.reserve(count); }
 
       void start()
       { thread.start(); }
@@ -64,86 +120,247 @@ namespace bench
       void join()
       { thread.join(); }
 
-      void setCount(unsigned long count_)   { count = count_; }
-      void setLoops(unsigned long loops_)   { loops = loops_; }
-      void setEnabled(bool sw = true)       { enabled = sw; }
-
       void run();
   };
 
   void Logtester::run()
   {
-    for (unsigned long l = 0; l < loops; ++l)
+    startSignal.wait();
+
+    if (enabled)
+    {
+      for (unsigned long i = 0; i < count; ++i)
+      {
+        unsigned long long t0 = now();
+        log_info("info message " << i);
+        latencies.push_back(static_cast<unsigned>(now() - t0));
+      }
+    }
+    else
     {
-      if (enabled)
-        for (unsigned long i = 0; i < count; ++i)
-          log_fatal("fatal message");
-      else
-        for (unsigned long i = 0; i < count; ++i)
-          log_debug("info message");
+      for (unsigned long i = 0; i < count; ++i)
+      {
+        unsigned long long t0 = now();
+        log_debug("debug message " << i);
+        latencies.push_back(static_cast<unsigned>(now() - t0));
+      }
     }
   }
-}
 
-int main(int argc, char* argv[])
-{
-  try
+  // receives the datagrams of the udp appender, so that sending does not
+  // fail with connection refused
+  class UdpReceiver : public cxxtools::RefCounted
   {
-    cxxtools::Arg<bool> enable(argc, argv, 'e');
-    cxxtools::Arg<double> total(argc, argv, 'T', 5.0); // minimum runtime
-    cxxtools::Arg<long> loops(argc, argv, 'l', 1000);
-    cxxtools::Arg<unsigned> numthreads(argc, argv, 't', 1);
+      cxxtools::net::UdpReceiver receiver;
+      cxxtools::AttachedThread thread;
+      volatile bool running;
+
+      void run()
+      {
+        char buffer[65536];
+        while (running)
+        {
+          try
+          {
+            receiver.recv(buffer, sizeof(buffer));
+          }
+          catch (const std::exception&)
+          {
+          }
+        }
+      }
 
-    unsigned long count = 1;
-    double T;
+    public:
+      explicit UdpReceiver(unsigned short port)
+        : receiver("127.0.0.1", port),
+          thread( cxxtools::callable(*this, &UdpReceiver::run) ),
+          running(true)
+      {
+        receiver.setTimeout(100);
+        thread.start();
+      }
 
-    log_init();
+      ~UdpReceiver()
+      {
+        running = false;
+        thread.join();
+      }
+  };
 
-    typedef std::vector<cxxtools::SmartPtr<bench::Logtester> > Threads;
+  void configure(const std::string& appender, bool async, const std::string& format, unsigned short port)
+  {
+    cxxtools::SerializationInfo si;
+    si.addMember("rootlogger") <<= "INFO";
+    si.addMember("format") <<= format;
+    si.addMember("async") <<= async;
+
+    if (appender == "file")
+    {
+      ::unlink("logbench.log");
+      si.addMember("file") <<= "logbench.log";
+    }
+    else if (appender == "rolling")
+    {
+      si.addMember("file") <<= "logbench.log";
+      si.addMember("maxfilesize") <<= "1M";
+      si.addMember("maxbackupindex") <<= 2;
+    }
+    else if (appender == "udp")
+    {
+      si.addMember("loghost") <<= "127.0.0.1";
+      si.addMember("logport") <<= port;
+      si.addMember("broadcast") <<= false;
+    }
+    else if (appender == "ring")
+    {
+      si.addMember("ringbuffer") <<= "logbench.ring";
+    }
+    else if (appender != "fd")
+      throw std::runtime_error("unknown appender \"" + appender + '"');
+
+    log_init(si);
+  }
+
+  unsigned percentile(const std::vector<unsigned>& sorted, double p)
+  {
+    if (sorted.empty())
+      return 0;
+    return sorted[static_cast<std::vector<unsigned>::size_type>(p * (sorted.size() - 1))];
+  }
+
+  void runBenchmark(const std::string& appender, bool async, const std::string& format,
+                    unsigned numthreads, unsigned long count, bool enabled)
+  {
+    StartSignal startSignal;
+
+    typedef std::vector<cxxtools::SmartPtr<Logtester> > Threads;
     Threads threads;
     for (unsigned t = 0; t < numthreads; ++t)
-      threads.push_back(new bench::Logtester(count, loops.getValue() / numthreads.getValue(), enable));
+      threads.push_back(new Logtester(startSignal, count, enabled));
 
-    while (count > 0)
-    {
-      std::cout << "count=" << (count * loops) << '\t' << std::flush;
+    for (Threads::iterator it = threads.begin(); it != threads.end(); ++it)
+      (*it)->start();
 
-      for (Threads::iterator it = threads.begin(); it != threads.end(); ++it)
-        (*it)->setCount(count);
+    unsigned long waits0 = cxxtools::LoggerManager::mutexWaits();
+    unsigned long waitTime0 = cxxtools::LoggerManager::mutexWaitTime();
 
-      struct timeval tv0;
-      struct timeval tv1;
+    unsigned long long t0 = now();
 
-      gettimeofday(&tv0, 0);
+    startSignal.start();
+    for (Threads::iterator it = threads.begin(); it != threads.end(); ++it)
+      (*it)->join();
 
-      if (threads.size() == 1)
-      {
-        (*threads.begin())->run();
-      }
-      else
-      {
-        for (Threads::iterator it = threads.begin(); it != threads.end(); ++it)
-          (*it)->start();
-        for (Threads::iterator it = threads.begin(); it != threads.end(); ++it)
-          (*it)->join();
-      }
+    double T = (now() - t0) / 1e9;
+
+    unsigned long waits = cxxtools::LoggerManager::mutexWaits() - waits0;
+    unsigned long waitTime = cxxtools::LoggerManager::mutexWaitTime() - waitTime0;
 
-      gettimeofday(&tv1, 0);
+    std::vector<unsigned> latencies;
+    latencies.reserve(count * numthreads);
+    for (Threads::iterator it = threads.begin(); it != threads.end(); ++it)
+      latencies.insert(latencies.end(), (*it)->latencies.begin(), (*it)->latencies.end());
+    std::sort(latencies.begin(), latencies.end());
 
-      double t0 = tv0.tv_sec + tv0.tv_usec / 1e6;
-      double t1 = tv1.tv_sec + tv1.tv_usec / 1e6;
-      T = t1 - t0;
+    unsigned long total = count * numthreads;
 
-      std::cout.precision(6);
-      std::cout << " T=" << T << '\t' << std::setprecision(12) << (count / T * loops)
-        << " msg/s" << std::endl;
+    std::cout << appender << ','
+              << (async ? "async" : "sync") << ','
+              << format << ','
+              << numthreads << ','
+              << (enabled ? "enabled" : "disabled") << ','
+              << total << ','
+              << T << ','
+              << static_cast<unsigned long>(total / T) << ','
+              << percentile(latencies, 0.5) << ','
+              << percentile(latencies, 0.9) << ','
+              << percentile(latencies, 0.99) << ','
+              << percentile(latencies, 0.999) << ','
+              << (latencies.empty() ? 0 : latencies.back()) << ','
+              << waits << ','
+              << waitTime << std::endl;
+  }
 
-      if (T >= total)
+  std::vector<std::string> split(const std::string& s)
+  {
+    std::vector<std::string> ret;
+    std::string::size_type b = 0;
+    while (true)
+    {
+      std::string::size_type e = s.find(',', b);
+      ret.push_back(s.substr(b, e == std::string::npos ? e : e - b));
+      if (e == std::string::npos)
         break;
+      b = e + 1;
+    }
+    return ret;
+  }
+}
 
-      count <<= 1;
+int main(int argc, char* argv[])
+{
+  try
+  {
+    cxxtools::Arg<std::string> appenders(argc, argv, 'A', "fd,file,rolling,udp,ring");
+    cxxtools::Arg<std::string> threadCounts(argc, argv, 't', "1,4");
+    cxxtools::Arg<unsigned long> count(argc, argv, 'n', 100000);  // messages per thread
+    cxxtools::Arg<std::string> format(argc, argv, 'f', "text");
+    cxxtools::Arg<bool> syncOnly(argc, argv, 's');
+    cxxtools::Arg<bool> asyncOnly(argc, argv, 'a');
+    cxxtools::Arg<unsigned short> port(argc, argv, 'p', 17001);
+    cxxtools::Arg<bool> help(argc, argv, 'h');
+
+    if (help)
+    {
+      std::cerr << "usage: " << argv[0] << " [options]\n"
+                   "\t-A appenders  comma separated list of fd, file, rolling, udp and ring (default: all)\n"
+                   "\t-t threads    comma separated list of thread counts (default: 1,4)\n"
+                   "\t-n count      messages per thread (default: 100000)\n"
+                   "\t-f format     text or json (default: text)\n"
+                   "\t-s            synchronous logging only\n"
+                   "\t-a            asynchronous logging only\n"
+                   "\t-p port       udp port of the local receiver (default: 17001)\n"
+                   "\n"
+                   "Latencies are in nanoseconds and include the time for reading the clock,\n"
+                   "mutex_wait_us is the time all threads waited for the log mutex.\n";
+      return 0;
     }
 
+    std::vector<std::string> appenderList = bench::split(appenders);
+    std::vector<std::string> threadList = bench::split(threadCounts);
+
+    cxxtools::SmartPtr<bench::UdpReceiver> udpReceiver;
+    if (std::find(appenderList.begin(), appenderList.end(), "udp") != appenderList.end())
+      udpReceiver = new bench::UdpReceiver(port);
+
+    std::cout << "appender,mode,format,threads,level,messages,seconds,msg_per_s,"
+                 "p50_ns,p90_ns,p99_ns,p999_ns,max_ns,mutex_waits,mutex_wait_us" << std::endl;
+
+    for (std::vector<std::string>::const_iterator a = appenderList.begin(); a != appenderList.end(); ++a)
+    {
+      for (int m = 0; m < 2; ++m)
+      {
+        bool async = (m == 1);
+        if (async ? syncOnly : asyncOnly)
+          continue;
+
+        // the ring buffer never uses the background thread
+        if (async && *a == "ring")
+          continue;
+
+        for (std::vector<std::string>::const_iterator t = threadList.begin(); t != threadList.end(); ++t)
+        {
+          unsigned numthreads = cxxtools::convert<unsigned>(*t);
+
+          bench::configure(*a, async, format, port);
+          bench::runBenchmark(*a, async, format, numthreads, count, true);
+          bench::runBenchmark(*a, async, format, numthreads, count, false);
+        }
+      }
+    }
+
+    // write pending messages of an asynchronous appender before the
+    // receiver is stopped
+    log_init(cxxtools::SerializationInfo());
   }
   catch (const std::exception& e)
   {
@@ -151,4 +368,3 @@ int main(int argc, char* argv[])
     return -1;
   }
 }
-
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2026 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <iostream>
+#include <cxxtools/arg.h>
+#include <cxxtools/log.h>
+
+// Prints the log entries kept in the ring buffer file of a ring buffer
+// appender, e.g. after a crash of the process.
+//
+// To log into a ring buffer of 64 MB configure in log.xml:
+//
+//   <ringbuffer>app.ring</ringbuffer>
+//   <ringbuffersize>64M</ringbuffersize>
+//
+int main(int argc, char* argv[])
+{
+  try
+  {
+    cxxtools::Arg<bool> count(argc, argv, 'c');
+
+    if (argc <= 1)
+    {
+      std::cerr << "usage: " << argv[0] << " [-c] ringbufferfile...\n"
+                   "\t-c  print only the number of log entries" << std::endl;
+      return -1;
+    }
+
+    for (int a = 1; a < argc; ++a)
+    {
+      if (count)
+      {
+        std::ostream null(0);
+        std::cout << argv[a] << ": " << cxxtools::dumpLogRingBuffer(argv[a], null) << std::endl;
+      }
+      else
+        cxxtools::dumpLogRingBuffer(argv[a], std::cout);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+}
@@ -181,6 +181,62 @@ atomic_t atomicExchange(volatile atomic_t& val, atomic_t exch);
 */
 void* atomicExchange(void* volatile& dest, void* exch);
 
+/** @brief Atomically get a value with acquire semantics
+
+    Memory accesses after the call are not moved before it, so data
+    published with atomicSetRelease before is visible. Unlike atomicGet
+    this does not need a full memory fence on most platforms.
+*/
+inline atomic_t atomicGetAcquire(volatile atomic_t& val)
+{
+#if defined(__ATOMIC_ACQUIRE)
+    return __atomic_load_n(&val, __ATOMIC_ACQUIRE);
+#else
+    return atomicGet(val);
+#endif
+}
+
+/** @brief Atomically set a value with release semantics
+
+    Memory accesses before the call are not moved after it.
+*/
+inline void atomicSetRelease(volatile atomic_t& val, atomic_t n)
+{
+#if defined(__ATOMIC_RELEASE)
+    __atomic_store_n(&val, n, __ATOMIC_RELEASE);
+#else
+    atomicSet(val, n);
+#endif
+}
+
+/** @brief Atomically get a pointer with acquire semantics
+
+    Memory accesses after the call are not moved before it, so data
+    published with atomicSetRelease before is visible. Unlike atomicGet
+    this does not need a full memory fence on most platforms.
+*/
+inline void* atomicGetAcquire(void* volatile& ptr)
+{
+#if defined(__ATOMIC_ACQUIRE)
+    return __atomic_load_n(&ptr, __ATOMIC_ACQUIRE);
+#else
+    return atomicCompareExchange(ptr, 0, 0);
+#endif
+}
+
+/** @brief Atomically set a pointer with release semantics
+
+    Memory accesses before the call are not moved after it.
+*/
+inline void atomicSetRelease(void* volatile& ptr, void* p)
+{
+#if defined(__ATOMIC_RELEASE)
+    __atomic_store_n(&ptr, p, __ATOMIC_RELEASE);
+#else
+    atomicExchange(ptr, p);
+#endif
+}
+
 }
 
 #endif
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CXXTOOLS_BIN_COMPRESSIONSTATISTICS_H
+#define CXXTOOLS_BIN_COMPRESSIONSTATISTICS_H
+
+#include <stdint.h>
+
+namespace cxxtools
+{
+    namespace bin
+    {
+        /// Counts the compressed frames of a binary rpc connection and their sizes.
+        struct CompressionStatistics
+        {
+            CompressionStatistics()
+                : frames(0),
+                  uncompressedBytes(0),
+                  compressedBytes(0)
+            { }
+
+            /// number of compressed frames sent and received
+            uint64_t frames;
+            /// sum of the frame sizes before compression
+            uint64_t uncompressedBytes;
+            /// sum of the frame sizes after compression
+            uint64_t compressedBytes;
+
+            /// Returns the ratio of uncompressed to compressed size or 0 when nothing was compressed.
+            double ratio() const
+            { return compressedBytes == 0 ? 0 : static_cast<double>(uncompressedBytes) / compressedBytes; }
+
+            void add(uint64_t uncompressed, uint64_t compressed)
+            {
+                ++frames;
+                uncompressedBytes += uncompressed;
+                compressedBytes += compressed;
+            }
+        };
+    }
+}
+
+#endif // CXXTOOLS_BIN_COMPRESSIONSTATISTICS_H
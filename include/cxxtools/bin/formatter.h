@@ -31,6 +31,7 @@
 
 #include <cxxtools/formatter.h>
 #include <cxxtools/textstream.h>
+#include <map>
 
 namespace cxxtools
 {
@@ -47,6 +48,17 @@ namespace cxxtools
 
                 void finish();
 
+                /**
+                    Sends member and type names only once per top level value.
+                    Later occurrences refer to the first by an index. The
+                    output can't be read by older versions of cxxtools, so
+                    it is disabled by default.
+                 */
+                void useDictionary(bool sw);
+
+                bool useDictionary() const
+                { return _useDictionary; }
+
                 virtual void addValueString(const std::string& name, const std::string& type,
                                       const cxxtools::String& value);
 
@@ -67,6 +79,18 @@ namespace cxxtools
 
                 virtual void addNull(const std::string& name, const std::string& type);
 
+                virtual void addArray(const std::string& name, const std::string& type,
+                                      const int32_t* values, std::size_t count);
+
+                virtual void addArray(const std::string& name, const std::string& type,
+                                      const int64_t* values, std::size_t count);
+
+                virtual void addArray(const std::string& name, const std::string& type,
+                                      const float* values, std::size_t count);
+
+                virtual void addArray(const std::string& name, const std::string& type,
+                                      const double* values, std::size_t count);
+
                 virtual void beginArray(const std::string& name, const std::string& type);
 
                 virtual void finishArray();
@@ -80,8 +104,18 @@ namespace cxxtools
                 virtual void finishObject();
 
             private:
+                void printName(const std::string& name);
+                void printTypeCode(const std::string& type, bool plain);
+                void printUInt(uint64_t v, const std::string& name);
+                void printInt(int64_t v, const std::string& name);
+
                 std::ostream* _out;
                 TextOStream _ts;
+
+                typedef std::map<std::string, unsigned> DictionaryType;
+                bool _useDictionary;
+                unsigned _level;
+                DictionaryType _dictionary;
         };
 
     }
@@ -30,6 +30,7 @@
 #define CXXTOOLS_BIN_CLIENT_H
 
 #include <cxxtools/remoteclient.h>
+#include <cxxtools/bin/compressionstatistics.h>
 #include <string>
 
 namespace cxxtools
@@ -82,6 +83,36 @@ class RpcClient : public RemoteClient
 
         void domain(const std::string& p);
 
+        // Requests are sent in compressed frames, when the compression
+        // threshold is set. Requests smaller than the threshold are sent
+        // in uncompressed frames. Compressed frames tell the server, that
+        // compressed replies are accepted. 0 (the default) disables
+        // compression; compression needs a server, which supports it.
+        std::size_t compressionThreshold() const;
+        void compressionThreshold(std::size_t n);
+
+        // Returns the statistics of the frames compressed and uncompressed
+        // by this client.
+        CompressionStatistics compressionStatistics() const;
+
+        // Sets a deadline for the following requests in milliseconds. The
+        // server does not execute a request, which it could not start
+        // within the deadline after receiving it, but replies with the
+        // error "deadline exceeded". Requests, which the client has given
+        // up already do not waste server resources that way. 0 (the
+        // default) sends no deadline; deadlines need a server, which
+        // supports them.
+        std::size_t deadline() const;
+        void deadline(std::size_t msecs);
+
+        // When set, member and type names repeated within a request are
+        // sent as references to their first occurrence. The flag is sent
+        // with the request and tells the server, that it may compress the
+        // names in the reply also. Disabled by default; the dictionary needs
+        // a server, which supports it.
+        bool useDictionary() const;
+        void useDictionary(bool sw);
+
 };
 
 }
@@ -33,6 +33,7 @@
 #include <cxxtools/signal.h>
 #include <cxxtools/callable.h>
 #include <cxxtools/serviceregistry.h>
+#include <cxxtools/bin/compressionstatistics.h>
 
 namespace cxxtools
 {
@@ -65,6 +66,31 @@ namespace cxxtools
                 unsigned maxThreads() const;
                 void maxThreads(unsigned m);
 
+                // In event driven mode the connections are processed in the
+                // event loop and only the procedure calls are passed to a
+                // thread pool with maxThreads threads. The number of threads
+                // does not depend on the number of connections then. The mode
+                // must be set before the event loop is started.
+                bool eventDriven() const;
+                void eventDriven(bool sw);
+
+                // Replies are sent in compressed frames to clients, which
+                // send their requests in compressed frames. Replies smaller
+                // than the compression threshold are not compressed. 0
+                // disables compression. The default is 1024 bytes.
+                std::size_t compressionThreshold() const;
+                void compressionThreshold(std::size_t n);
+
+                // Compressed frames larger than maxFrameSize bytes before or
+                // after compression are rejected and the connection is
+                // closed. 0 disables the limit. The default is 64 MiB.
+                std::size_t maxFrameSize() const;
+                void maxFrameSize(std::size_t n);
+
+                // Returns the statistics of all frames compressed and
+                // uncompressed by the server.
+                CompressionStatistics compressionStatistics() const;
+
                 // idleTimeout is the time in milliseconds of inactivity after
                 // which a socket is moved from a worker thread to the main event loop.
                 std::size_t idleTimeout() const;
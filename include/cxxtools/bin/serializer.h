@@ -61,6 +61,10 @@ namespace cxxtools
                     TypeShortFloat = 0x21, // 1 bit sign, 7 bit exponent, 16 bit mantissa (3 byte)
                     TypeMediumFloat = 0x22, // 1 bit sign, 7 bit exponent, 32 bit mantissa (5 byte)
                     TypeLongFloat = 0x23,  // 1 bit sign, 15 bit exponent, 64 bit mantissa (10 byte)
+                    TypePackedInt32 = 0x28,  // followed by 4 byte count and little endian values
+                    TypePackedInt64 = 0x29,
+                    TypePackedFloat = 0x2a,
+                    TypePackedDouble = 0x2b,
                     TypePair = 0x30,
                     TypeArray = 0x31,
                     TypeVector = 0x32,
@@ -90,6 +94,10 @@ namespace cxxtools
                     TypePlainShortFloat = 0x61, // 1 bit sign, 7 bit exponent, 16 bit mantissa
                     TypePlainMediumFloat = 0x62,  // 1 bit sign, 7 bit exponent, 32 bit mantissa
                     TypePlainLongFloat = 0x63,  // 1 bit sign, 15 bit exponent, 64 bit mantissa
+                    TypePlainPackedInt32 = 0x68,
+                    TypePlainPackedInt64 = 0x69,
+                    TypePlainPackedFloat = 0x6a,
+                    TypePlainPackedDouble = 0x6b,
                     TypePlainPair = 0x70,
                     TypePlainArray = 0x71,
                     TypePlainVector = 0x72,
@@ -143,9 +151,32 @@ namespace cxxtools
                     return *this;
                 }
 
+                /// Serializes an object using formatValue without intermediate SerializationInfo.
+                template <typename T>
+                Serializer& serializeDirect(const T& v, const std::string& name)
+                {
+                    formatValue(_formatter, v, name);
+                    return *this;
+                }
+
+                template <typename T>
+                Serializer& serializeDirect(const T& v)
+                {
+                    formatValue(_formatter, v, std::string());
+                    return *this;
+                }
+
                 void finish()
                 { }
 
+                /// Sends repeated member and type names as references to the
+                /// first occurrence; see Formatter::useDictionary.
+                void useDictionary(bool sw)
+                { _formatter.useDictionary(sw); }
+
+                bool useDictionary() const
+                { return _formatter.useDictionary(); }
+
             private:
                 Formatter _formatter;
         };
@@ -30,6 +30,7 @@
 #define CXXTOOLS_BIN_VALUEPARSER_H
 
 #include <cxxtools/serializationinfo.h>
+#include <iosfwd>
 
 namespace cxxtools
 {
@@ -46,7 +47,8 @@ class ValueParser
 
     public:
         ValueParser()
-            : _next(0)
+            : _dictionary(&_names),
+              _next(0)
         { }
 
         ~ValueParser() 
@@ -60,12 +62,18 @@ class ValueParser
 
         bool advance(char ch); // returns true, if number is read completely
 
+        /// Reads the values of a packed array, which is currently parsed, in
+        /// one block from the stream. The last byte is left for advance.
+        void readPacked(std::istream& in);
+
         DeserializerBase* current()
         { return _deserializer; }
 
     private:
 
         bool processFloatBase(char ch, unsigned shift, unsigned expOffset);
+        bool processName(char ch);
+        void processPacked();
         enum State
         {
             state_type,
@@ -86,6 +94,8 @@ class ValueParser
             state_mfloat_base,
             state_lfloat_exp,
             state_lfloat_base,
+            state_packed_length,
+            state_packed_data,
             state_object_type,
             state_object_type_other,
             state_object_member,
@@ -98,11 +108,26 @@ class ValueParser
             state_end
         } _state, _nextstate;
 
+        enum NameState
+        {
+            name_start,
+            name_plain,
+            name_define,
+            name_reference
+        } _nameState;
+
         std::string _token;
         unsigned _count;
         uint64_t _int;
         int _exp;
         bool _isNeg;
+        char _packedType;
+        unsigned _shift;
+
+        // names defined in the current top level value; nested parsers
+        // use the dictionary of the outermost
+        std::vector<std::string> _names;
+        std::vector<std::string>* _dictionary;
         DeserializerBase* _deserializer;
         ValueParser* _next;
 };
@@ -72,6 +72,32 @@ class Composer : public IComposer
 };
 
 
+/** @brief Composer, which appends each passed element to a sequence container
+ */
+template <typename C>
+class SequenceComposer : public IComposer
+{
+    public:
+        SequenceComposer()
+        : _container(0)
+        {}
+
+        void begin(C& container)
+        {
+            _container = &container;
+        }
+
+        virtual void fixup(const SerializationInfo& si)
+        {
+            _container->resize(_container->size() + 1);
+            si >>= _container->back();
+        }
+
+    private:
+        C* _container;
+};
+
+
 } // namespace cxxtools
 
 #endif
@@ -284,6 +284,36 @@ OutIterT putFloat(OutIterT it, T d, const FormatT& fmt, int precision);
 template <typename OutIterT, typename T>
 OutIterT putFloat(OutIterT it, T d);
 
+/** @brief Formats a double with the shortest number of digits, which read back to the same value.
+ */
+template <typename OutIterT>
+OutIterT putFloat(OutIterT it, double d);
+
+/** @brief Formats a float with the shortest number of digits, which read back to the same value.
+ */
+template <typename OutIterT>
+OutIterT putFloat(OutIterT it, float d);
+
+/** @brief Formats a long double.
+
+    Values, which are exactly representable as a double, are formatted
+    like a double, others with the full precision of long double.
+ */
+template <typename OutIterT>
+OutIterT putFloat(OutIterT it, long double d);
+
+/** @brief Calculates the shortest decimal digits of a floating point value
+
+    The digits of the positive and finite value \a d are written as
+    characters to \a digits, which must have room for 17 characters. The
+    number of digits is returned; the value is this digit sequence
+    multiplied by 10 to the power of \a exp10. Reading back the digits
+    results exactly in \a d.
+ */
+CXXTOOLS_API int shortestDigits(double d, char* digits, int& exp10);
+
+CXXTOOLS_API int shortestDigits(float d, char* digits, int& exp10);
+
 //
 // number parsing
 //
@@ -308,6 +338,37 @@ InIterT getFloat(InIterT it, InIterT end, bool& ok, T& n, const FormatT& fmt);
 template <typename InIterT, typename T>
 InIterT getFloat(InIterT it, InIterT end, bool& ok, T& n);
 
+/** @brief Parses a double from contiguous character data.
+
+    Accepts the same input as the generic getFloat but is considerably
+    faster and the result is correctly rounded.
+ */
+CXXTOOLS_API const char* getFloat(const char* it, const char* end, bool& ok, double& n);
+
+CXXTOOLS_API const char* getFloat(const char* it, const char* end, bool& ok, float& n);
+
+inline char* getFloat(char* it, char* end, bool& ok, double& n)
+{ return const_cast<char*>(getFloat(const_cast<const char*>(it), const_cast<const char*>(end), ok, n)); }
+
+inline char* getFloat(char* it, char* end, bool& ok, float& n)
+{ return const_cast<char*>(getFloat(const_cast<const char*>(it), const_cast<const char*>(end), ok, n)); }
+
+/** @brief Parses an integer value in decimal format from contiguous character data.
+ */
+template <typename T>
+const char* getInt(const char* it, const char* end, bool& ok, T& n);
+
+template <typename T>
+char* getInt(char* it, char* end, bool& ok, T& n)
+{ return const_cast<char*>(getInt(const_cast<const char*>(it), const_cast<const char*>(end), ok, n)); }
+
+/** @brief Reads a run of decimal digits, eight at a time where possible.
+
+    The value of the digits is returned in \a u and their number in \a
+    count. The value is only meaningful for up to 19 digits.
+ */
+CXXTOOLS_API const char* getDigits(const char* it, const char* end, uint64_t& u, unsigned& count);
+
 
 template <typename CharType>
 struct NumberFormat
@@ -751,6 +812,121 @@ inline OutIterT putFloat(OutIterT it, T d)
 }
 
 
+//! @internal @brief Formats a float or double using shortestDigits
+template <typename OutIterT, typename T, typename FormatT>
+inline OutIterT putShortestFloat(OutIterT it, T d, const FormatT& fmt)
+{
+    typedef typename FormatT::CharT CharT;
+
+    if (d != d)
+    {
+        for (const CharT* nanstr = fmt.nan(); *nanstr != 0; ++nanstr)
+        {
+            *it = *nanstr;
+            ++it;
+        }
+
+        return it;
+    }
+
+    if (d < 0)
+    {
+        *it = fmt.minus();
+        ++it;
+        d = -d;
+    }
+
+    if (d == std::numeric_limits<T>::infinity())
+    {
+        for (const CharT* infstr = fmt.inf(); *infstr != 0; ++infstr)
+        {
+            *it = *infstr;
+            ++it;
+        }
+
+        return it;
+    }
+
+    if (d == 0)
+    {
+        *it = '0'; ++it;
+        return it;
+    }
+
+    char digits[20];
+    int exp10;
+    int len = shortestDigits(d, digits, exp10);
+
+    // number of digits before the decimal point
+    int pos = len + exp10;
+
+    if (pos <= 0)
+    {
+        *it = '0'; ++it;
+        *it = fmt.point(); ++it;
+
+        for ( ; pos < 0; ++pos)
+        {
+            *it = '0'; ++it;
+        }
+
+        for (int n = 0; n < len; ++n)
+        {
+            *it = digits[n]; ++it;
+        }
+    }
+    else
+    {
+        for (int n = 0; n < len; ++n)
+        {
+            if (n == pos)
+            {
+                *it = fmt.point(); ++it;
+            }
+
+            *it = digits[n]; ++it;
+        }
+
+        for ( ; pos > len; --pos)
+        {
+            *it = '0'; ++it;
+        }
+    }
+
+    return it;
+}
+
+
+template <typename OutIterT>
+inline OutIterT putFloat(OutIterT it, double d)
+{
+    FloatFormat<char> fmt;
+    return putShortestFloat(it, d, fmt);
+}
+
+
+template <typename OutIterT>
+inline OutIterT putFloat(OutIterT it, float d)
+{
+    FloatFormat<char> fmt;
+    return putShortestFloat(it, d, fmt);
+}
+
+
+template <typename OutIterT>
+inline OutIterT putFloat(OutIterT it, long double d)
+{
+    FloatFormat<char> fmt;
+
+    double dd = static_cast<double>(d);
+    if (static_cast<long double>(dd) == d || d != d)
+        return putShortestFloat(it, dd, fmt);
+
+    const int precision = std::numeric_limits<long double>::digits10 + 1;
+    return putFloat(it, d, fmt, precision);
+}
+
+
 template <typename InIterT, typename FormatT>
 InIterT getSign(InIterT it, InIterT end, bool& pos, const FormatT& fmt)
 {
@@ -842,6 +1018,60 @@ InIterT getInt(InIterT it, InIterT end, bool& ok, T& n)
 }
 
 
+template <typename T>
+const char* getInt(const char* it, const char* end, bool& ok, T& n)
+{
+    typedef typename IntTraits<T>::Unsigned UnsignedInt;
+
+    const char* begin = it;
+
+    n = 0;
+    ok = false;
+
+    while (it != end && isspace(static_cast<unsigned char>(*it)))
+        ++it;
+
+    bool isNeg = false;
+    if (it != end && (*it == '-' || *it == '+'))
+    {
+        isNeg = (*it == '-');
+        ++it;
+    }
+
+    if (it == end)
+        return it;
+
+    // return if minus sign was parsed for unsigned type
+    if (isNeg && !std::numeric_limits<T>::is_signed)
+        return it;
+
+    uint64_t u;
+    unsigned count;
+    const char* e = getDigits(it, end, u, count);
+
+    // the value may have wrapped around; let the generic parser find the
+    // position of the overflow
+    if (count > 19)
+        return getInt(begin, end, ok, n, DecimalFormat<char>());
+
+    // abs(min) is max + 1 for negative signed types
+    uint64_t max = static_cast<UnsignedInt>(std::numeric_limits<T>::max());
+    if (isNeg)
+        ++max;
+
+    if (u > max)
+        return e;
+
+    if (isNeg)
+        n = static_cast<T>(UnsignedInt(0) - static_cast<UnsignedInt>(u));
+    else
+        n = static_cast<T>(u);
+
+    ok = true;
+    return e;
+}
+
+
 template <typename InIterT, typename T, typename FormatT>
 InIterT getFloat(InIterT it, InIterT end, bool& ok, T& n, const FormatT& fmt)
 {
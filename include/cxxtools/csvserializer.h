@@ -87,6 +87,13 @@ namespace cxxtools
                 _formatter->finish();
             }
 
+            template <typename T>
+            void serializeDirect(const T& type)
+            {
+                formatValue(*_formatter, type, std::string());
+                _formatter->finish();
+            }
+
         private:
             CsvFormatter* _formatter;
     };
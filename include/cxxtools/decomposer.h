@@ -31,14 +31,16 @@
 #include <cxxtools/api.h>
 #include <cxxtools/convert.h>
 #include <cxxtools/serializationinfo.h>
+#include <cxxtools/formatter.h>
 #include <cxxtools/noncopyable.h>
 #include <vector>
+#include <list>
+#include <deque>
+#include <set>
 #include <map>
 
 namespace cxxtools {
 
-class Formatter;
-
 class CXXTOOLS_API IDecomposer
 {
     public:
@@ -70,7 +72,7 @@ class Decomposer : public IDecomposer
 
         void begin(const T& type)
         {
-            _si.clear();
+            _si.recycle();
             _si <<= type;
         }
 
@@ -90,6 +92,251 @@ class Decomposer : public IDecomposer
 };
 
 
+/** @brief Streaming serialization
+
+    The functions formatValue pass a value directly to a Formatter without
+    building a SerializationInfo tree first. The serializers use them in
+    their serializeDirect methods.
+
+    A user type may provide its own overload, which is found by argument
+    dependent lookup, e.g.:
+
+    @code
+    void formatValue(cxxtools::Formatter& formatter, const Color& color,
+                     const std::string& name)
+    {
+        formatter.beginObject(name, "Color");
+        cxxtools::formatMember(formatter, "red", color.red);
+        cxxtools::formatMember(formatter, "green", color.green);
+        cxxtools::formatMember(formatter, "blue", color.blue);
+        formatter.finishObject();
+    }
+    @endcode
+
+    Types without such an overload fall back to operator <<= and format the
+    resulting SerializationInfo, so the output is always the same as with
+    the Decomposer.
+ */
+template <typename T>
+void formatValue(Formatter& formatter, const T& value, const std::string& name);
+
+template <typename T>
+void formatMember(Formatter& formatter, const std::string& name, const T& value);
+
+inline void formatValue(Formatter& formatter, bool value, const std::string& name)
+{
+    formatter.addValueBool(name, "bool", value);
+}
+
+inline void formatValue(Formatter& formatter, short value, const std::string& name)
+{
+    formatter.addValueInt(name, "int", value);
+}
+
+inline void formatValue(Formatter& formatter, unsigned short value, const std::string& name)
+{
+    formatter.addValueUnsigned(name, "int", value);
+}
+
+inline void formatValue(Formatter& formatter, int value, const std::string& name)
+{
+    formatter.addValueInt(name, "int", value);
+}
+
+inline void formatValue(Formatter& formatter, unsigned int value, const std::string& name)
+{
+    formatter.addValueUnsigned(name, "int", value);
+}
+
+inline void formatValue(Formatter& formatter, long value, const std::string& name)
+{
+    formatter.addValueInt(name, "int", value);
+}
+
+inline void formatValue(Formatter& formatter, unsigned long value, const std::string& name)
+{
+    formatter.addValueUnsigned(name, "int", value);
+}
+
+#ifdef HAVE_LONG_LONG
+inline void formatValue(Formatter& formatter, long long value, const std::string& name)
+{
+    formatter.addValueInt(name, "int", value);
+}
+#endif
+
+#ifdef HAVE_UNSIGNED_LONG_LONG
+inline void formatValue(Formatter& formatter, unsigned long long value, const std::string& name)
+{
+    formatter.addValueUnsigned(name, "int", value);
+}
+#endif
+
+inline void formatValue(Formatter& formatter, float value, const std::string& name)
+{
+    formatter.addValueFloat(name, "double", value);
+}
+
+inline void formatValue(Formatter& formatter, double value, const std::string& name)
+{
+    formatter.addValueFloat(name, "double", value);
+}
+
+inline void formatValue(Formatter& formatter, const std::string& value, const std::string& name)
+{
+    formatter.addValueStdString(name, "string", value);
+}
+
+inline void formatValue(Formatter& formatter, const char* value, const std::string& name)
+{
+    formatter.addValueStdString(name, "string", value);
+}
+
+inline void formatValue(Formatter& formatter, const String& value, const std::string& name)
+{
+    formatter.addValueString(name, "string", value);
+}
+
+template <typename T, typename A>
+void formatValue(Formatter& formatter, const std::vector<T, A>& vec, const std::string& name);
+
+template <typename A>
+void formatValue(Formatter& formatter, const std::vector<int32_t, A>& vec, const std::string& name);
+
+template <typename A>
+void formatValue(Formatter& formatter, const std::vector<int64_t, A>& vec, const std::string& name);
+
+template <typename A>
+void formatValue(Formatter& formatter, const std::vector<float, A>& vec, const std::string& name);
+
+template <typename A>
+void formatValue(Formatter& formatter, const std::vector<double, A>& vec, const std::string& name);
+
+template <typename T, typename A>
+void formatValue(Formatter& formatter, const std::list<T, A>& list, const std::string& name);
+
+template <typename T, typename A>
+void formatValue(Formatter& formatter, const std::deque<T, A>& deque, const std::string& name);
+
+template <typename T, typename C, typename A>
+void formatValue(Formatter& formatter, const std::set<T, C, A>& set, const std::string& name);
+
+template <typename T, typename C, typename A>
+void formatValue(Formatter& formatter, const std::multiset<T, C, A>& multiset, const std::string& name);
+
+template <typename A, typename B>
+void formatValue(Formatter& formatter, const std::pair<A, B>& p, const std::string& name);
+
+template <typename K, typename V, typename P, typename A>
+void formatValue(Formatter& formatter, const std::map<K, V, P, A>& map, const std::string& name);
+
+template <typename K, typename V, typename P, typename A>
+void formatValue(Formatter& formatter, const std::multimap<K, V, P, A>& multimap, const std::string& name);
+
+template <typename Iterator>
+void formatRange(Formatter& formatter, Iterator begin, Iterator end,
+                 const std::string& name, const std::string& type)
+{
+    formatter.beginArray(name, type);
+    for ( ; begin != end; ++begin)
+        formatValue(formatter, *begin, std::string());
+    formatter.finishArray();
+}
+
+template <typename T>
+void formatValue(Formatter& formatter, const T& value, const std::string& name)
+{
+    SerializationInfo si;
+    si <<= value;
+    si.setName(name);
+    IDecomposer::formatEach(si, formatter);
+}
+
+template <typename T>
+void formatMember(Formatter& formatter, const std::string& name, const T& value)
+{
+    formatter.beginMember(name);
+    formatValue(formatter, value, name);
+    formatter.finishMember();
+}
+
+template <typename T, typename A>
+void formatValue(Formatter& formatter, const std::vector<T, A>& vec, const std::string& name)
+{
+    formatRange(formatter, vec.begin(), vec.end(), name, "array");
+}
+
+// vectors of fixed size numbers are passed as one block
+template <typename A>
+void formatValue(Formatter& formatter, const std::vector<int32_t, A>& vec, const std::string& name)
+{
+    formatter.addArray(name, "array", vec.empty() ? 0 : &vec[0], vec.size());
+}
+
+template <typename A>
+void formatValue(Formatter& formatter, const std::vector<int64_t, A>& vec, const std::string& name)
+{
+    formatter.addArray(name, "array", vec.empty() ? 0 : &vec[0], vec.size());
+}
+
+template <typename A>
+void formatValue(Formatter& formatter, const std::vector<float, A>& vec, const std::string& name)
+{
+    formatter.addArray(name, "array", vec.empty() ? 0 : &vec[0], vec.size());
+}
+
+template <typename A>
+void formatValue(Formatter& formatter, const std::vector<double, A>& vec, const std::string& name)
+{
+    formatter.addArray(name, "array", vec.empty() ? 0 : &vec[0], vec.size());
+}
+
+template <typename T, typename A>
+void formatValue(Formatter& formatter, const std::list<T, A>& list, const std::string& name)
+{
+    formatRange(formatter, list.begin(), list.end(), name, "list");
+}
+
+template <typename T, typename A>
+void formatValue(Formatter& formatter, const std::deque<T, A>& deque, const std::string& name)
+{
+    formatRange(formatter, deque.begin(), deque.end(), name, "deque");
+}
+
+template <typename T, typename C, typename A>
+void formatValue(Formatter& formatter, const std::set<T, C, A>& set, const std::string& name)
+{
+    formatRange(formatter, set.begin(), set.end(), name, "set");
+}
+
+template <typename T, typename C, typename A>
+void formatValue(Formatter& formatter, const std::multiset<T, C, A>& multiset, const std::string& name)
+{
+    formatRange(formatter, multiset.begin(), multiset.end(), name, "multiset");
+}
+
+template <typename A, typename B>
+void formatValue(Formatter& formatter, const std::pair<A, B>& p, const std::string& name)
+{
+    formatter.beginObject(name, "pair");
+    formatMember(formatter, "first", p.first);
+    formatMember(formatter, "second", p.second);
+    formatter.finishObject();
+}
+
+template <typename K, typename V, typename P, typename A>
+void formatValue(Formatter& formatter, const std::map<K, V, P, A>& map, const std::string& name)
+{
+    formatRange(formatter, map.begin(), map.end(), name, "map");
+}
+
+template <typename K, typename V, typename P, typename A>
+void formatValue(Formatter& formatter, const std::multimap<K, V, P, A>& multimap, const std::string& name)
+{
+    formatRange(formatter, multimap.begin(), multimap.end(), name, "multimap");
+}
+
+
 } // namespace cxxtools
 
 #endif
@@ -94,6 +94,43 @@ namespace cxxtools
                 doDeserialize();
             }
 
+            /** @brief Deserialize the elements of an array one by one
+
+                Each element of the top level array or object is passed to
+                \a composer as soon as it is read. Unlike deserialize the
+                input is not converted into a SerializationInfo tree as a
+                whole, so the memory needed does not depend on the number of
+                elements.
+            */
+            void deserializeEach(IComposer& composer)
+            {
+                begin();
+                elementComposer(&composer);
+                try
+                {
+                    doDeserialize();
+                }
+                catch (...)
+                {
+                    elementComposer(0);
+                    throw;
+                }
+                elementComposer(0);
+            }
+
+            /** @brief Deserialize the elements of an array into a sequence container
+
+                The elements are appended to \a container, which may be a
+                std::vector, std::list or std::deque.
+            */
+            template <typename C>
+            void deserializeElements(C& container)
+            {
+                SequenceComposer<C> composer;
+                composer.begin(container);
+                deserializeEach(composer);
+            }
+
         private:
             virtual void doDeserialize() = 0;
     };
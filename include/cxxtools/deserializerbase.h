@@ -34,6 +34,8 @@
 
 namespace cxxtools
 {
+    class IComposer;
+
     /**
      * convert format to SerializationInfo
      */
@@ -52,16 +54,18 @@ namespace cxxtools
 #endif
 
             DeserializerBase()
-                : _current(0)
+                : _current(0),
+                  _elementComposer(0)
             { }
 
             virtual ~DeserializerBase()
             { }
 
+            /// Starts a new tree; the nodes of the previous one are recycled.
             void begin()
             {
                 _current = &_si;
-                _si.clear();
+                _si.recycle();
             }
 
             void clear()
@@ -89,6 +93,8 @@ namespace cxxtools
 
             void setValue(const char* value);
 
+            void setValue(const char* value, std::size_t len);
+
             void setValue(bool value);
 
             void setValue(int_type value);
@@ -105,9 +111,23 @@ namespace cxxtools
 
             void leaveMember();
 
+            /** @brief Passes each completed top level member to a composer
+
+                When set, every direct child of the root is passed to
+                \a composer as soon as it is complete and its node is reused
+                for the next child. So the tree never holds more than one
+                element. Pass 0 to build the full tree again.
+             */
+            void elementComposer(IComposer* composer)
+            { _elementComposer = composer; }
+
+            IComposer* elementComposer() const
+            { return _elementComposer; }
+
         private:
             SerializationInfo _si;
             SerializationInfo* _current;
+            IComposer* _elementComposer;
     };
 
 }
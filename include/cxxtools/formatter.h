@@ -31,6 +31,8 @@
 #include <cxxtools/api.h>
 #include <cxxtools/string.h>
 #include <string>
+#include <cstddef>
+#include <stdint.h>
 #include <cxxtools/config.h>
 
 namespace cxxtools
@@ -73,6 +75,20 @@ class Formatter
 
         virtual void addNull(const std::string& name, const std::string& type);
 
+        /// Adds an array of numbers. The default implementation passes the
+        /// values one by one; binary formats may write them in one block.
+        virtual void addArray(const std::string& name, const std::string& type,
+                              const int32_t* values, std::size_t count);
+
+        virtual void addArray(const std::string& name, const std::string& type,
+                              const int64_t* values, std::size_t count);
+
+        virtual void addArray(const std::string& name, const std::string& type,
+                              const float* values, std::size_t count);
+
+        virtual void addArray(const std::string& name, const std::string& type,
+                              const double* values, std::size_t count);
+
         virtual void beginArray(const std::string& name, const std::string& type) = 0;
 
         virtual void finishArray() = 0;
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CXXTOOLS_HEDGEDCLIENT_H
+#define CXXTOOLS_HEDGEDCLIENT_H
+
+#include <cxxtools/remoteclient.h>
+#include <cstddef>
+
+namespace cxxtools
+{
+    class SelectorBase;
+    class HedgedClientImpl;
+
+    /** @brief Remote client, which sends hedged requests to a second endpoint
+
+        The hedged client forwards calls to a primary client. When the primary
+        does not reply within the hedge delay, the same request is sent to
+        the secondary client and the reply, which arrives first, is taken.
+        The other request is cancelled. When one of the requests fails, the
+        other is awaited or sent immediately.
+
+        The hedge delay is the 95th percentile of the latencies of the recent
+        successful requests, but not less than the minimum hedge delay. That
+        way about 5% of the requests are duplicated.
+
+        Both clients must use the selector passed to the hedged client. Since
+        requests may be executed on both endpoints, only idempotent procedures
+        should be called through a hedged client.
+
+        @code
+        cxxtools::EventLoop loop;
+        cxxtools::bin::RpcClient replica1(loop, "replica1", 7002);
+        cxxtools::bin::RpcClient replica2(loop, "replica2", 7002);
+        cxxtools::HedgedClient client(loop, replica1, replica2);
+
+        cxxtools::RemoteProcedure<std::string, std::string> echo(client, "echo");
+        std::string result = echo("hi");
+        @endcode
+     */
+    class HedgedClient : public RemoteClient
+    {
+            HedgedClientImpl* _impl;
+
+            HedgedClient(HedgedClient&) { }
+            void operator= (const HedgedClient&) { }
+
+        public:
+            HedgedClient(SelectorBase& selector, RemoteClient& primary, RemoteClient& secondary);
+
+            virtual ~HedgedClient();
+
+            void beginCall(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc);
+
+            void endCall();
+
+            void call(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc);
+
+            const IRemoteProcedure* activeProcedure() const;
+
+            void cancel();
+
+            void wait(std::size_t msecs = WaitInfinite);
+
+            /// Returns the current hedge delay in milliseconds.
+            std::size_t hedgeDelay() const;
+
+            /// Returns the minimum hedge delay in milliseconds.
+            std::size_t minHedgeDelay() const;
+
+            /// Sets the minimum hedge delay in milliseconds (default 10).
+            void minHedgeDelay(std::size_t msecs);
+
+            /// Returns the number of requests, which were sent to the secondary client.
+            std::size_t hedgedCalls() const;
+    };
+}
+
+#endif // CXXTOOLS_HEDGEDCLIENT_H
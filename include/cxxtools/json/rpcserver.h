@@ -64,6 +64,14 @@ namespace cxxtools
                 unsigned maxThreads() const;
                 void maxThreads(unsigned m);
 
+                // In event driven mode the connections are processed in the
+                // event loop and only the procedure calls are passed to a
+                // thread pool with maxThreads threads. The number of threads
+                // does not depend on the number of connections then. The mode
+                // must be set before the event loop is started.
+                bool eventDriven() const;
+                void eventDriven(bool sw);
+
                 // idleTimeout is the time in milliseconds of inactivity after
                 // which a socket is moved from a worker thread to the main event loop.
                 std::size_t idleTimeout() const;
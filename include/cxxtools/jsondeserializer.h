@@ -34,6 +34,7 @@
 #include <cxxtools/deserializer.h>
 #include <cxxtools/textstream.h>
 #include <cxxtools/utf8codec.h>
+#include <cstddef>
 
 namespace cxxtools
 {
@@ -44,6 +45,14 @@ namespace cxxtools
 
             JsonDeserializer(TextIStream& in);
 
+            /**
+                Reads json from a buffer of utf-8 encoded bytes using the
+                JsonUtf8Parser, which does not decode the input character
+                by character. The buffer must contain exactly one json
+                value and must stay valid during deserialization.
+             */
+            JsonDeserializer(const char* data, std::size_t size);
+
             ~JsonDeserializer();
 
         protected:
@@ -51,7 +60,9 @@ namespace cxxtools
 
         private:
             TextIStream* _ts;
-            TextIStream& _in;
+            TextIStream* _in;
+            const char* _data;
+            std::size_t _size;
     };
 }
 
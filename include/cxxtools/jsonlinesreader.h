@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CXXTOOLS_JSONLINESREADER_H
+#define CXXTOOLS_JSONLINESREADER_H
+
+#include <cxxtools/api.h>
+#include <cxxtools/noncopyable.h>
+#include <cxxtools/serializationinfo.h>
+#include <iosfwd>
+
+namespace cxxtools
+{
+    class JsonLinesReaderImpl;
+
+    /**
+        Reads json lines (also known as ndjson), where each line of the
+        input contains one json value.
+
+        The records are deserialized into a SerializationInfo, which is
+        reused for the next record, so reading does not allocate a new tree
+        per line. Empty lines are skipped.
+
+        When a number of threads is passed, lines are read ahead in batches,
+        which are parsed in a thread pool. The records are still returned in
+        the order of the input.
+
+        \code
+          std::ifstream in("events.jsonl");
+          cxxtools::JsonLinesReader reader(in, 4);
+          Event event;
+          while (reader.get(event))
+              process(event);
+        \endcode
+     */
+    class CXXTOOLS_API JsonLinesReader : private NonCopyable
+    {
+        public:
+            explicit JsonLinesReader(std::istream& in, unsigned threads = 0);
+
+            ~JsonLinesReader();
+
+            /**
+                Reads the next record. The result is valid until the next call.
+                Returns 0 at the end of the input.
+             */
+            const SerializationInfo* next();
+
+            /// Reads the next record into an object. Returns false at the end.
+            template <typename T>
+            bool get(T& obj)
+            {
+                const SerializationInfo* si = next();
+                if (si == 0)
+                    return false;
+                *si >>= obj;
+                return true;
+            }
+
+            /// Returns the line number of the last record.
+            unsigned lineNumber() const;
+
+        private:
+            JsonLinesReaderImpl* _impl;
+    };
+}
+
+#endif // CXXTOOLS_JSONLINESREADER_H
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CXXTOOLS_JSONLINESWRITER_H
+#define CXXTOOLS_JSONLINESWRITER_H
+
+#include <cxxtools/api.h>
+#include <cxxtools/noncopyable.h>
+#include <cxxtools/jsonformatter.h>
+#include <cxxtools/decomposer.h>
+#include <cxxtools/textstream.h>
+
+namespace cxxtools
+{
+    /**
+        Writes json lines, one compact json value per line.
+
+        The output is buffered. It is flushed after every flushInterval
+        records, when flush is called and on destruction. With a flush
+        interval of 0 the data is only written when the buffer is full.
+     */
+    class CXXTOOLS_API JsonLinesWriter : private NonCopyable
+    {
+        public:
+            explicit JsonLinesWriter(std::ostream& out, unsigned flushInterval = 0);
+
+            ~JsonLinesWriter();
+
+            template <typename T>
+            JsonLinesWriter& write(const T& v)
+            {
+                formatValue(_formatter, v, std::string());
+                finishRecord();
+                return *this;
+            }
+
+            void flush();
+
+            unsigned flushInterval() const
+            { return _flushInterval; }
+
+            void flushInterval(unsigned n)
+            { _flushInterval = n; }
+
+        private:
+            void finishRecord();
+
+            TextOStream _ts;
+            JsonFormatter _formatter;
+            unsigned _flushInterval;
+            unsigned _count;
+    };
+}
+
+#endif // CXXTOOLS_JSONLINESWRITER_H
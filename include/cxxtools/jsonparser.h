@@ -31,6 +31,7 @@
 
 #include <cxxtools/api.h>
 #include <cxxtools/string.h>
+#include <string>
 
 namespace cxxtools
 {
@@ -72,6 +73,7 @@ namespace cxxtools
             {
                 _state = state_0;
                 _token.clear();
+                _number.clear();
                 _deserializer = &handler;
             }
 
@@ -79,6 +81,9 @@ namespace cxxtools
             void finish();
 
         private:
+            void setIntValue();
+            void setFloatValue();
+
             enum
             {
                 state_0,
@@ -103,6 +108,7 @@ namespace cxxtools
             } _state, _nextState;
 
             String _token;
+            std::string _number;
 
             DeserializerBase* _deserializer;
             JsonStringParser _stringParser;
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CXXTOOLS_JSONREADER_H
+#define CXXTOOLS_JSONREADER_H
+
+#include <cxxtools/api.h>
+#include <cxxtools/string.h>
+#include <cxxtools/serializationinfo.h>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace cxxtools
+{
+    /**
+        Pull reader for json.
+
+        The reader delivers the contents of a utf-8 encoded json stream as a
+        sequence of events without building a tree. Only the current token
+        is held in memory, so arbitrary large documents can be processed:
+
+        \code
+          std::ifstream in("export.json");
+          cxxtools::JsonReader reader(in);
+          reader.next();                  // BeginArray
+          while (reader.next() != cxxtools::JsonReader::EndArray)
+          {
+              Record record;
+              reader.get(record);         // reads one element
+          }
+        \endcode
+
+        The text of keys and scalar values is accessed with data() and
+        size() directly in the input buffer. It is valid until the next
+        call to next() or skip(). Strings are unescaped and utf-8 encoded.
+
+        Several json values may follow each other in the stream. After the
+        end of a top level value, next() starts reading the following one
+        and returns End at the end of the input.
+     */
+    class CXXTOOLS_API JsonReader
+    {
+        public:
+            typedef SerializationInfo::int_type int_type;
+            typedef SerializationInfo::unsigned_type unsigned_type;
+
+            enum Event
+            {
+                None,
+                BeginObject,
+                EndObject,
+                BeginArray,
+                EndArray,
+                Key,
+                StringValue,
+                NumberValue,
+                BoolValue,
+                NullValue,
+                End
+            };
+
+            explicit JsonReader(std::istream& in, std::size_t bufferSize = 65536);
+
+            /// Reads the next event.
+            Event next();
+
+            /// Returns the current event.
+            Event event() const
+            { return _event; }
+
+            /**
+                Skips the value of the current event without processing it.
+
+                After BeginObject or BeginArray the rest of the object or array
+                including its end is skipped, after Key the value of the member.
+                Nothing happens for other events.
+             */
+            void skip();
+
+            /// Returns the nesting level of the current position.
+            unsigned depth() const
+            { return static_cast<unsigned>(_stack.size()); }
+
+            /// Returns the text of the current key or scalar value.
+            const char* data() const
+            { return _tokenSize ? &_buffer[_token] : ""; }
+
+            std::size_t size() const
+            { return _tokenSize; }
+
+            std::string str() const
+            { return std::string(data(), size()); }
+
+            /// Returns the text of the current key or scalar decoded to a String.
+            String toString() const;
+
+            bool toBool() const;
+
+            int_type toInt() const;
+
+            unsigned_type toUnsigned() const;
+
+            double toDouble() const;
+
+            /**
+                Reads the value of the current event into a SerializationInfo.
+
+                For BeginObject and BeginArray the complete object or array is
+                read; for Key the value of the member.
+             */
+            void get(SerializationInfo& si);
+
+            /// Reads the value of the current event into an object.
+            template <typename T>
+            void get(T& obj)
+            {
+                _si.recycle();
+                get(_si);
+                _si >>= obj;
+            }
+
+        private:
+            bool fill();
+            bool available(std::size_t n);
+            void skipWhitespace();
+            void readString();
+            void readNumber();
+            void readToken();
+            void skipString();
+            void skipContainer();
+            void getValue(SerializationInfo& si);
+
+            std::istream& _in;
+            std::vector<char> _buffer;
+            std::size_t _begin;
+            std::size_t _end;
+            std::size_t _token;
+            std::size_t _tokenSize;
+            bool _nonAscii;
+            bool _eof;
+
+            enum
+            {
+                state_value,
+                state_first_value,
+                state_first_key,
+                state_key,
+                state_colon,
+                state_after_value
+            } _state;
+
+            Event _event;
+            std::vector<char> _stack;
+            SerializationInfo _si;
+    };
+}
+
+#endif // CXXTOOLS_JSONREADER_H
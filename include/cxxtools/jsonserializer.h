@@ -113,6 +113,37 @@ namespace cxxtools
                 return *this;
             }
 
+            /** @brief Serialize an object without building a SerializationInfo
+
+                The value is passed to the formatter using formatValue, so
+                user types with a formatValue overload are written without
+                intermediate tree. The output is the same as with serialize.
+             */
+            template <typename T>
+            JsonSerializer& serializeDirect(const T& v, const std::string& name)
+            {
+                if (!_inObject)
+                {
+                    _formatter.beginObject(std::string(), std::string());
+                    _inObject = true;
+                }
+
+                formatValue(_formatter, v, name);
+                return *this;
+            }
+
+            template <typename T>
+            JsonSerializer& serializeDirect(const T& v)
+            {
+                if (_inObject)
+                    throw std::logic_error("can't serialize object without name into another object");
+
+                formatValue(_formatter, v, std::string());
+                if (_ts)
+                    _ts->flush();
+                return *this;
+            }
+
             void setObject()
             {
                 _formatter.beginObject(std::string(), std::string());
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CXXTOOLS_JSONUTF8PARSER_H
+#define CXXTOOLS_JSONUTF8PARSER_H
+
+#include <cxxtools/api.h>
+#include <string>
+#include <cstddef>
+
+namespace cxxtools
+{
+    class DeserializerBase;
+    class Formatter;
+
+    /**
+        Parses json from a contiguous buffer of utf-8 encoded bytes.
+
+        Unlike the JsonParser, which processes one decoded character at a
+        time, this parser works directly on the bytes. The ends of strings
+        and escape sequences are found with vector instructions where
+        available and strings without escapes are taken directly from the
+        buffer. Strings consisting of ascii characters only are passed on as
+        std::string; others are decoded to cxxtools::String as the
+        JsonParser does.
+
+        The same syntax as in the JsonParser is accepted including
+        comments.
+     */
+    class CXXTOOLS_API JsonUtf8Parser
+    {
+        public:
+            /// Parses one json value and passes it to the deserializer.
+            /// Returns a pointer behind the value.
+            const char* parse(const char* begin, const char* end, DeserializerBase& deserializer);
+
+            /// Parses one json value and passes it as a stream of events
+            /// to the formatter. Formatter::finish is not called.
+            /// Returns a pointer behind the value.
+            const char* parse(const char* begin, const char* end, Formatter& formatter);
+
+            /// Returns a pointer to the first character after \a begin, which
+            /// is neither whitespace nor part of a comment.
+            static const char* skipWhitespace(const char* begin, const char* end);
+
+        private:
+            template <typename HandlerType> friend class JsonUtf8ParserImpl;
+
+            std::string _buffer;
+    };
+}
+
+#endif // CXXTOOLS_JSONUTF8PARSER_H
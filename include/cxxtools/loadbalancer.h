@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CXXTOOLS_LOADBALANCER_H
+#define CXXTOOLS_LOADBALANCER_H
+
+#include <cxxtools/timespan.h>
+#include <string>
+#include <cstddef>
+
+namespace cxxtools
+{
+    class RemoteClient;
+    class SelectorBase;
+    class LoadBalancerImpl;
+    class BalancingClientImpl;
+
+    /** @brief Set of endpoints, to which a BalancingClient distributes calls
+
+        The load balancer selects an endpoint for each call by comparing two
+        randomly chosen healthy endpoints ("power of two choices"). The one
+        with fewer outstanding requests weighted by its average latency is
+        taken.
+
+        The health of the endpoints is tracked passively. An endpoint is
+        ejected after a number of consecutive failed calls. After the eject
+        time one probe call is sent to it again. If it succeeds, the endpoint
+        is healthy again, otherwise it is ejected again. When all endpoints
+        are ejected, the one with the earliest end of ejection is used.
+
+        Faults reported by the server do not count as failures, since the
+        server is obviously alive.
+
+        Each endpoint keeps a pool of connections. A connection is created
+        when no idle connection is available, so that the pool grows up to
+        the number of concurrent calls to the endpoint. At most maxIdle
+        connections are kept idle, the others are closed after the call.
+        A connection, whose call failed, is always closed.
+
+        The load balancer may be shared by multiple BalancingClient objects,
+        also in different threads, when the connections are synchronous.
+
+        Connections are created by the abstract method createClient. The
+        template class BasicLoadBalancer creates connections of clients
+        with a constructor taking a host and a port.
+     */
+    class LoadBalancer
+    {
+            friend class BalancingClientImpl;
+
+            LoadBalancerImpl* _impl;
+
+            LoadBalancer(const LoadBalancer&) { }
+            void operator= (const LoadBalancer&) { }
+
+        public:
+            struct EndpointInfo
+            {
+                std::string host;
+                unsigned short port;
+                unsigned outstanding;
+                std::size_t requests;
+                std::size_t failures;
+                std::size_t connections;
+                bool ejected;
+                Timespan latency;
+            };
+
+            LoadBalancer();
+
+            /// Deletes all connections.
+            virtual ~LoadBalancer();
+
+            void addEndpoint(const std::string& host, unsigned short port);
+
+            /// Returns the number of endpoints.
+            unsigned endpoints() const;
+
+            /// Returns the state of the nth endpoint.
+            EndpointInfo endpointInfo(unsigned n) const;
+
+            /// Returns the number of consecutive failures, after which an endpoint is ejected.
+            unsigned failureThreshold() const;
+
+            /// Sets the number of consecutive failures, after which an endpoint is ejected (default 3).
+            void failureThreshold(unsigned n);
+
+            /// Returns the time in milliseconds, an endpoint stays ejected.
+            std::size_t ejectTime() const;
+
+            /// Sets the time in milliseconds, an endpoint stays ejected (default 10000).
+            void ejectTime(std::size_t msecs);
+
+            /// Returns the maximum number of idle connections kept per endpoint.
+            std::size_t maxIdle() const;
+
+            /// Sets the maximum number of idle connections kept per endpoint (default 16).
+            void maxIdle(std::size_t n);
+
+        protected:
+            virtual RemoteClient* createClient(const std::string& host, unsigned short port) = 0;
+
+        private:
+            // selects an endpoint and returns a connection to it
+            RemoteClient* acquire(unsigned& endpoint);
+
+            // returns the connection after a call; when false is returned,
+            // the connection is not kept and the caller has to delete it
+            bool release(unsigned endpoint, RemoteClient* client, const Timespan& latency, bool failed);
+    };
+
+    /** @brief Load balancer for clients constructed with host and port
+
+        When a selector is passed, the connections are asynchronous clients
+        using that selector.
+
+        @code
+        cxxtools::EventLoop loop;
+        cxxtools::BasicLoadBalancer<cxxtools::bin::RpcClient> balancer(loop);
+        balancer.addEndpoint("replica1", 7002);
+        balancer.addEndpoint("replica2", 7002);
+
+        cxxtools::BalancingClient client(balancer);
+        cxxtools::RemoteProcedure<std::string, std::string> echo(client, "echo");
+        echo.begin("hi");
+        std::string result = echo.end();
+        @endcode
+     */
+    template <typename ClientType>
+    class BasicLoadBalancer : public LoadBalancer
+    {
+            SelectorBase* _selector;
+
+        public:
+            BasicLoadBalancer()
+                : _selector(0)
+            { }
+
+            explicit BasicLoadBalancer(SelectorBase& selector)
+                : _selector(&selector)
+            { }
+
+            ~BasicLoadBalancer()
+            { }
+
+        protected:
+            RemoteClient* createClient(const std::string& host, unsigned short port)
+            {
+                if (_selector)
+                    return new ClientType(*_selector, host, port);
+                else
+                    return new ClientType(host, port);
+            }
+    };
+}
+
+#endif // CXXTOOLS_LOADBALANCER_H
@@ -29,31 +29,81 @@
 #ifndef CXXTOOLS_LOG_CXXTOOLS_H
 #define CXXTOOLS_LOG_CXXTOOLS_H
 
+#include <cxxtools/atomicity.h>
 #include <string>
 #include <iostream>
+#include <time.h>
+
+// Log statements below a minimum level can be removed at compile time by
+// defining CXXTOOLS_LOG_MIN_LEVEL to one of the CXXTOOLS_LOG_LEVEL_* values.
+// With -DCXXTOOLS_LOG_MIN_LEVEL=CXXTOOLS_LOG_LEVEL_INFO log_debug and
+// log_trace statements are dead code, which the compiler removes, while
+// their expressions are still checked for errors. The library itself may be
+// built with the floor by passing it in CPPFLAGS to configure.
+#define CXXTOOLS_LOG_LEVEL_FATAL  0
+#define CXXTOOLS_LOG_LEVEL_ERROR  100
+#define CXXTOOLS_LOG_LEVEL_WARN   200
+#define CXXTOOLS_LOG_LEVEL_INFO   300
+#define CXXTOOLS_LOG_LEVEL_DEBUG  400
+#define CXXTOOLS_LOG_LEVEL_TRACE  500
+
+#ifndef CXXTOOLS_LOG_MIN_LEVEL
+#define CXXTOOLS_LOG_MIN_LEVEL  CXXTOOLS_LOG_LEVEL_TRACE
+#endif
+
+#define _cxxtools_log_compiled(level)   \
+  (CXXTOOLS_LOG_LEVEL_ ## level <= CXXTOOLS_LOG_MIN_LEVEL)
 
 #define _cxxtools_log_enabled(level)   \
-  (getLogger() != 0 && getLogger()->isEnabled(::cxxtools::Logger::LOG_LEVEL_ ## level))
+  (_cxxtools_log_compiled(level) \
+    && getLogger() != 0 && getLogger()->isEnabled(::cxxtools::Logger::LOG_LEVEL_ ## level))
 
 #define _cxxtools_log(level, expr)   \
   do { \
-    ::cxxtools::Logger* _cxxtools_logger = getLogger(); \
-    if (_cxxtools_logger != 0 && _cxxtools_logger->isEnabled(::cxxtools::Logger::LOG_LEVEL_ ## level)) \
+    if (_cxxtools_log_compiled(level)) \
     { \
-      ::cxxtools::LogMessage _cxxtools_logMessage(_cxxtools_logger, #level); \
-      _cxxtools_logMessage.out() << expr; \
-      _cxxtools_logMessage.finish(); \
+      ::cxxtools::Logger* _cxxtools_logger = getLogger(); \
+      if (_cxxtools_logger != 0 && _cxxtools_logger->isEnabled(::cxxtools::Logger::LOG_LEVEL_ ## level) \
+          && _cxxtools_logger->pass()) \
+      { \
+        ::cxxtools::LogMessage _cxxtools_logMessage(_cxxtools_logger, #level); \
+        _cxxtools_logMessage.out() << expr; \
+        _cxxtools_logMessage.finish(); \
+      } \
     } \
   } while (false)
 
 #define _cxxtools_log_if(level, cond, expr)   \
   do { \
-    ::cxxtools::Logger* _cxxtools_logger = getLogger(); \
-    if (_cxxtools_logger != 0 && _cxxtools_logger->isEnabled(::cxxtools::Logger::LOG_LEVEL_ ## level) && (cond)) \
+    if (_cxxtools_log_compiled(level)) \
+    { \
+      ::cxxtools::Logger* _cxxtools_logger = getLogger(); \
+      if (_cxxtools_logger != 0 && _cxxtools_logger->isEnabled(::cxxtools::Logger::LOG_LEVEL_ ## level) && (cond) \
+          && _cxxtools_logger->pass()) \
+      { \
+        ::cxxtools::LogMessage _cxxtools_logMessage(_cxxtools_logger, #level); \
+        _cxxtools_logMessage.out() << expr; \
+        _cxxtools_logMessage.finish(); \
+      } \
+    } \
+  } while (false)
+
+#define _cxxtools_log_limit(level, limit, expr)   \
+  do { \
+    if (_cxxtools_log_compiled(level)) \
     { \
-      ::cxxtools::LogMessage _cxxtools_logMessage(_cxxtools_logger, #level); \
-      _cxxtools_logMessage.out() << expr; \
-      _cxxtools_logMessage.finish(); \
+      ::cxxtools::Logger* _cxxtools_logger = getLogger(); \
+      if (_cxxtools_logger != 0 && _cxxtools_logger->isEnabled(::cxxtools::Logger::LOG_LEVEL_ ## level) \
+          && _cxxtools_logger->pass()) \
+      { \
+        static ::cxxtools::LogLimiter _cxxtools_limiter(limit); \
+        if (_cxxtools_limiter.pass(_cxxtools_logger, __FILE__, __LINE__)) \
+        { \
+          ::cxxtools::LogMessage _cxxtools_logMessage(_cxxtools_logger, #level); \
+          _cxxtools_logMessage.out() << expr; \
+          _cxxtools_logMessage.finish(); \
+        } \
+      } \
     } \
   } while (false)
 
@@ -76,6 +126,15 @@
 #define log_info_if(cond, expr)      _cxxtools_log_if(INFO, cond, expr)
 #define log_debug_if(cond, expr)     _cxxtools_log_if(DEBUG, cond, expr)
 
+// log at most limit messages per second from this call site
+#define log_fatal_limit(limit, expr)     _cxxtools_log_limit(FATAL, limit, expr)
+#define log_error_limit(limit, expr)     _cxxtools_log_limit(ERROR, limit, expr)
+#define log_warn_limit(limit, expr)      _cxxtools_log_limit(WARN, limit, expr)
+#define log_info_limit(limit, expr)      _cxxtools_log_limit(INFO, limit, expr)
+#define log_debug_limit(limit, expr)     _cxxtools_log_limit(DEBUG, limit, expr)
+
+#if CXXTOOLS_LOG_MIN_LEVEL >= CXXTOOLS_LOG_LEVEL_TRACE
+
 #define log_trace(expr)     \
   ::cxxtools::LogTracer _cxxtools_tracer;  \
   do { \
@@ -88,6 +147,21 @@
     } \
   } while (false)
 
+#else
+
+// no tracer object is created, so the compiler can remove the statement
+#define log_trace(expr)     \
+  do { \
+    if (false) \
+    { \
+      ::cxxtools::LogTracer _cxxtools_tracer;  \
+      _cxxtools_tracer.setLogger(getLogger()); \
+      _cxxtools_tracer.out() << expr;  \
+    } \
+  } while (false)
+
+#endif
+
 #define log_define(category) \
   static ::cxxtools::Logger* getLogger()   \
   {  \
@@ -105,6 +179,58 @@
 namespace cxxtools
 {
   class SerializationInfo;
+  class Logger;
+
+  //////////////////////////////////////////////////////////////////////
+  // Limits the number of log messages per second and samples messages.
+  // The number of suppressed messages is logged as a warning, when the
+  // next second starts, at the latest by a background thread.
+  //
+  class LogLimiter
+  {
+    public:
+      typedef time_t (*Clock)(time_t*);
+
+    private:
+      unsigned _limit;
+      unsigned long long _sample;
+      volatile atomic_t _second;
+      volatile atomic_t _count;
+      volatile atomic_t _suppressed;
+      volatile atomic_t _sequence;
+
+      // set, while the suppressed messages wait for their report; the
+      // logger and call site are kept for the report
+      bool _pending;
+      Logger* _logger;
+      const char* _file;
+      int _line;
+
+      LogLimiter(const LogLimiter&);
+      LogLimiter& operator=(const LogLimiter&);
+
+      void suppress(Logger* logger, const char* file, int line);
+      void report();
+
+    public:
+      // limit is the maximum number of messages per second, 0 for no
+      // limit; sample is the fraction of the messages to be logged
+      explicit LogLimiter(unsigned limit, double sample = 1.0);
+      ~LogLimiter();
+
+      // returns false, when the message is suppressed; file and line
+      // are reported with the number of suppressed messages
+      bool pass(Logger* logger, const char* file = 0, int line = 0);
+
+      // Logs the number of suppressed messages of all limiters, which
+      // second is over, or of all limiters, when all is set. This is done
+      // once a second in the background and when logging ends.
+      static void reportSuppressed(bool all = false);
+
+      // Replaces the clock, which defaults to time(); 0 restores the
+      // default. Meant for tests.
+      static void setClock(Clock clock);
+  };
 
   //////////////////////////////////////////////////////////////////////
   //
@@ -121,23 +247,40 @@ namespace cxxtools
       } log_level_type;
 
     private:
+      // level and limiter are changed at runtime, while other threads log
       std::string category;
-      log_level_type level;
+      volatile atomic_t level;
+      void* volatile limiter;  // LogLimiter*
 
       Logger(const Logger&);
       Logger& operator=(const Logger&);
 
     public:
-      Logger(const std::string& c, log_level_type l)
-        : category(c), level(l)
+      Logger(const std::string& c, log_level_type l, LogLimiter* lim = 0)
+        : category(c), level(l), limiter(lim)
         { }
 
+      ~Logger()
+        { delete static_cast<LogLimiter*>(limiter); }
+
       bool isEnabled(log_level_type l) const
-        { return level >= l; }
+        { return atomicGetAcquire(const_cast<volatile atomic_t&>(level)) >= l; }
+      void setLogLevel(log_level_type l)
+        { atomicSetRelease(level, l); }
+      // replaces the limiter and returns the previous one
+      LogLimiter* setLimiter(LogLimiter* l)
+        { return static_cast<LogLimiter*>(atomicExchange(limiter, l)); }
+      // returns false, when the message is suppressed by the rate limit
+      // or sampling of the category
+      bool pass()
+      {
+        LogLimiter* l = static_cast<LogLimiter*>(atomicGetAcquire(limiter));
+        return l == 0 || l->pass(this);
+      }
       const std::string& getCategory() const
         { return category; }
       log_level_type getLogLevel() const
-        { return level; }
+        { return static_cast<log_level_type>(atomicGetAcquire(const_cast<volatile atomic_t&>(level))); }
   };
 
   //////////////////////////////////////////////////////////////////////
@@ -195,12 +338,58 @@ namespace cxxtools
       static void logInit(const cxxtools::SerializationInfo& si);
 
       void configure(const LoggerManagerConfiguration& config);
+
+      // Applies the log levels and limits of the configuration to the
+      // existing loggers at runtime. Appender settings are not changed.
+      void reconfigure(const LoggerManagerConfiguration& config);
+
+      // Sets the log level of a category and its subcategories at runtime;
+      // an empty category sets the root level.
+      void setLogLevel(const std::string& category, Logger::log_level_type level);
+
+      // Returns the logger of the category. Loggers are kept, when the
+      // configuration changes, so the returned pointer stays valid.
       Logger* getLogger(const std::string& category);
       static bool isEnabled()
       { return _enabled; }
 
       Logger::log_level_type rootLevel() const;
       Logger::log_level_type logLevel(const std::string& category) const;
+
+      // Statistics of the mutex, which serializes the synchronous appenders:
+      // the number of log messages, which had to wait for it and the total
+      // time waited in microseconds.
+      static unsigned long mutexWaits();
+      static unsigned long mutexWaitTime();
+  };
+
+  // Writes the log entries kept in the file of a ring buffer appender in
+  // chronological order to the stream and returns the number of entries.
+  unsigned dumpLogRingBuffer(const std::string& fname, std::ostream& out);
+
+  //////////////////////////////////////////////////////////////////////
+  // The stream log messages are written to. Strings and integers are
+  // passed directly to the stream buffer without the locale facets of
+  // std::ostream, unless a width or formatting flags are set.
+  //
+  class LogStream : public std::ostream
+  {
+    public:
+      explicit LogStream(std::streambuf* sb)
+        : std::ostream(sb)
+        { }
+
+      using std::ostream::operator<<;
+
+      LogStream& operator<< (int n);
+      LogStream& operator<< (long n);
+      LogStream& operator<< (unsigned n);
+      LogStream& operator<< (unsigned long n);
+      LogStream& operator<< (char ch);
+      LogStream& operator<< (signed char ch);
+      LogStream& operator<< (unsigned char ch);
+      LogStream& operator<< (const char* s);
+      LogStream& operator<< (const std::string& s);
   };
 
   //////////////////////////////////////////////////////////////////////
@@ -224,12 +413,86 @@ namespace cxxtools
       Impl* impl()             { return _impl; }
       const Impl* impl() const { return _impl; }
 
-      std::ostream& out();
+      LogStream& out();
       std::string str() const;
 
       void finish();
   };
 
+  //////////////////////////////////////////////////////////////////////
+  // A typed key value pair, which is written into a log message:
+  //
+  //   log_info("request done" << cxxtools::LogField("user", user)
+  //                           << cxxtools::LogField("ms", ms));
+  //
+  // With json log format the field is added as a member of the log
+  // entry, otherwise it is written as " key=value" into the message.
+  //
+  class LogField
+  {
+    public:
+      enum Type {
+        StringType,
+        IntType,
+        UnsignedType,
+        FloatType,
+        BoolType
+      };
+
+    private:
+      const char* _key;
+      Type _type;
+      const char* _str;
+      std::size_t _len;
+      union {
+        long long i;
+        unsigned long long u;
+        double d;
+        bool b;
+      } _value;
+
+    public:
+      LogField(const char* key, const std::string& value)
+        : _key(key), _type(StringType), _str(value.data()), _len(value.size())
+        { }
+      LogField(const char* key, const char* value);
+      LogField(const char* key, int value)
+        : _key(key), _type(IntType)
+        { _value.i = value; }
+      LogField(const char* key, long value)
+        : _key(key), _type(IntType)
+        { _value.i = value; }
+      LogField(const char* key, long long value)
+        : _key(key), _type(IntType)
+        { _value.i = value; }
+      LogField(const char* key, unsigned value)
+        : _key(key), _type(UnsignedType)
+        { _value.u = value; }
+      LogField(const char* key, unsigned long value)
+        : _key(key), _type(UnsignedType)
+        { _value.u = value; }
+      LogField(const char* key, unsigned long long value)
+        : _key(key), _type(UnsignedType)
+        { _value.u = value; }
+      LogField(const char* key, double value)
+        : _key(key), _type(FloatType)
+        { _value.d = value; }
+      LogField(const char* key, bool value)
+        : _key(key), _type(BoolType)
+        { _value.b = value; }
+
+      const char* key() const             { return _key; }
+      Type type() const                   { return _type; }
+      const char* stringValue() const     { return _str; }
+      std::size_t stringLength() const    { return _len; }
+      long long intValue() const          { return _value.i; }
+      unsigned long long unsignedValue() const  { return _value.u; }
+      double floatValue() const           { return _value.d; }
+      bool boolValue() const              { return _value.b; }
+  };
+
+  std::ostream& operator<< (std::ostream& out, const LogField& field);
+
   //////////////////////////////////////////////////////////////////////
   //
   class LogTracer
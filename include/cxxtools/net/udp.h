@@ -57,6 +57,12 @@ namespace net
 
       size_type send(const void* message, size_type length, int flags = 0) const;
       size_type send(const std::string& message, int flags = 0) const;
+
+      /// Sends each of the count messages as a datagram with as few system
+      /// calls as possible (sendmmsg where available). Returns the number
+      /// of datagrams sent.
+      size_type sendBatch(const std::string* messages, size_type count, int flags = 0) const;
+
       size_type recv(void* buffer, size_type length, int flags = 0) const;
       std::string recv(size_type length, int flags = 0) const;
   };
@@ -58,6 +58,7 @@ class CXXTOOLS_API SerializationInfo
 
         class Iterator;
         class ConstIterator;
+        class Hint;
 
 #ifdef HAVE_LONG_LONG
         typedef long long int_type;
@@ -125,6 +126,7 @@ class CXXTOOLS_API SerializationInfo
         void setValue(const String& value)       { _setString(value); }
         void setValue(const std::string& value)  { _setString8(value); }
         void setValue(const char* value)         { _setString8(value); }
+        void setValue(const char* value, std::size_t len) { _setString8(value, len); }
         void setValue(Char value)                { _setString(String(1, value)); }
         void setValue(wchar_t value)             { _setString(String(1, value)); }
         void setValue(bool value)                { _setBool(value) ; }
@@ -213,6 +215,14 @@ class CXXTOOLS_API SerializationInfo
         */
         const SerializationInfo& getMember(unsigned idx) const;
 
+        /** @brief Deserialization of member data starting at a position
+
+            The member is searched like in findMember with a hint.
+
+            @throws SerializationError when member is not found.
+        */
+        const SerializationInfo& getMember(const std::string& name, Hint& hint) const;
+
         /** @brief Deserialization of member data.
 
             @return true if member is found, false otherwise.
@@ -228,6 +238,23 @@ class CXXTOOLS_API SerializationInfo
             return true;
         }
 
+        /** @brief Deserialization of member data starting at a position
+
+            The member is searched like in findMember with a hint.
+
+            @return true if member is found, false otherwise.
+            The passed value is not modified when the member was not found.
+         */
+        template <typename T>
+        bool getMember(const std::string& name, T& value, Hint& hint) const
+        {
+            const SerializationInfo* si = findMember(name, hint);
+            if (si == 0)
+                return false;
+            *si >>= value;
+            return true;
+        }
+
         /** @brief Find member data by name
 
             This method returns the data for an object with the name \a name.
@@ -242,9 +269,23 @@ class CXXTOOLS_API SerializationInfo
         */
         SerializationInfo* findMember(const std::string& name);
 
+        /** @brief Find member data by name starting at a position
+
+            The search starts at the position of \a hint and wraps around.
+            When the member is found, \a hint is set to the position behind
+            it. Passing the same hint to consecutive calls finds members
+            requested in the order they were added with a single comparison
+            each.
+        */
+        const SerializationInfo* findMember(const std::string& name, Hint& hint) const;
+
+        /** @brief Find member data by name starting at a position
+        */
+        SerializationInfo* findMember(const std::string& name, Hint& hint);
+
         size_t memberCount() const
         {
-            return _nodes.size();
+            return _used;
         }
 
         Iterator begin();
@@ -259,6 +300,25 @@ class CXXTOOLS_API SerializationInfo
 
         void clear();
 
+        /** @brief Clears the node but keeps the members for reuse
+
+            The node looks like a newly constructed one afterwards, but the
+            member nodes and their name and type strings are kept and reused
+            by the next calls to addMember. Refilling a recycled tree with
+            data of similar shape does not need to allocate memory.
+
+            At most twice the number of members used before plus 16 nodes
+            are kept. The memory is released by shrink, clear or the
+            destructor.
+         */
+        void recycle();
+
+        /** @brief Releases the member nodes kept for reuse by recycle
+
+            This is done recursively for all members.
+         */
+        void shrink();
+
         void swap(SerializationInfo& si);
 
         bool isNull() const     { return _t == t_none && _category == Void; }
@@ -286,6 +346,7 @@ class CXXTOOLS_API SerializationInfo
         void _setString(const String& value);
         void _setString8(const std::string& value);
         void _setString8(const char* value);
+        void _setString8(const char* value, std::size_t len);
         void _setChar(char value);
         void _setBool(bool value);
         void _setInt(int_type value);
@@ -331,6 +392,28 @@ class CXXTOOLS_API SerializationInfo
         } _t;
 
         Nodes _nodes;             // objects/arrays
+        Nodes::size_type _used;   // number of nodes in use; the others are kept for reuse
+};
+
+
+/** @brief Position for member lookups in the order the members were added
+
+    A hint remembers the position behind the member found last. It is only
+    meaningful for the SerializationInfo it was used with.
+ */
+class SerializationInfo::Hint
+{
+        friend class SerializationInfo;
+        size_t _pos;
+
+    public:
+        explicit Hint(size_t pos = 0)
+            : _pos(pos)
+        { }
+
+        /// Returns the member index, where the next search starts.
+        size_t pos() const
+        { return _pos; }
 };
 
 
@@ -899,8 +982,9 @@ inline void operator <<=(SerializationInfo& si, const std::multiset<T, C, A>& mu
 template <typename A, typename B>
 inline void operator >>=(const SerializationInfo& si, std::pair<A, B>& p)
 {
-    si.getMember("first") >>= p.first;
-    si.getMember("second") >>= p.second;
+    SerializationInfo::Hint hint;
+    si.getMember("first", hint) >>= p.first;
+    si.getMember("second", hint) >>= p.second;
 }
 
 
@@ -147,6 +147,19 @@ class XmlSerializer
             _formatter.flush();
         }
 
+        /** @brief Serialize an object to XML without building a SerializationInfo
+
+            Like serialize but the object is passed to the formatter using
+            formatValue.
+        */
+        template <typename T>
+        void serializeDirect(const T& type, const std::string& name)
+        {
+            formatValue(_formatter, type, name);
+            _formatter.finish();
+            _formatter.flush();
+        }
+
         void finish()
         {
         }
@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cxxtools/balancingclient.h>
+#include <cxxtools/remoteprocedure.h>
+#include <cxxtools/remoteexception.h>
+#include <cxxtools/clock.h>
+#include <cxxtools/log.h>
+#include <stdexcept>
+
+log_define("cxxtools.balancingclient")
+
+namespace cxxtools
+{
+
+class BalancingClientImpl
+{
+        // Proxy procedure, which receives the completion of the request
+        // from the connection.
+        class Proxy : public IRemoteProcedure
+        {
+                BalancingClientImpl& _impl;
+                bool _failed;
+                int _rc;
+                std::string _msg;
+
+            public:
+                Proxy(BalancingClientImpl& impl, RemoteClient& client, const String& name)
+                    : IRemoteProcedure(client, name),
+                      _impl(impl),
+                      _failed(false),
+                      _rc(0)
+                { }
+
+                void setFault(int rc, const std::string& msg)
+                {
+                    _failed = true;
+                    _rc = rc;
+                    _msg = msg;
+                }
+
+                bool failed() const
+                { return _failed; }
+
+                int rc() const
+                { return _rc; }
+
+                const std::string& msg() const
+                { return _msg; }
+
+                void onFinished()
+                { _impl.onFinished(); }
+        };
+
+    public:
+        explicit BalancingClientImpl(LoadBalancer& balancer)
+            : _balancer(balancer),
+              _client(0),
+              _endpoint(0),
+              _proxy(0),
+              _retired(0),
+              _proc(0),
+              _exceptionPending(false)
+        { }
+
+        ~BalancingClientImpl()
+        {
+            cancel();
+            delete _proxy;
+            delete _retired;
+        }
+
+        void beginCall(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc);
+        void endCall();
+        void call(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc);
+        void wait(std::size_t msecs);
+        void cancel();
+
+        const IRemoteProcedure* activeProcedure() const
+        { return _proc; }
+
+    private:
+        void begin(IRemoteProcedure& method);
+        void release(bool failed);
+        void onFinished();
+
+        LoadBalancer& _balancer;
+        RemoteClient* _client;
+        unsigned _endpoint;
+        Proxy* _proxy;
+        RemoteClient* _retired;
+        IRemoteProcedure* _proc;
+        Clock _clock;
+        bool _exceptionPending;
+};
+
+void BalancingClientImpl::begin(IRemoteProcedure& method)
+{
+    if (_proc)
+        throw std::logic_error("asyncronous request already running");
+
+    delete _proxy;
+    _proxy = 0;
+    delete _retired;
+    _retired = 0;
+
+    _client = _balancer.acquire(_endpoint);
+    _proxy = new Proxy(*this, *_client, method.name());
+    _proc = &method;
+    _clock.start();
+}
+
+void BalancingClientImpl::release(bool failed)
+{
+    // The connection may still be in its own callback here, so a
+    // connection dropped by the balancer is deleted with the next call.
+    if (!_balancer.release(_endpoint, _client, _clock.stop(), failed))
+        _retired = _client;
+    _client = 0;
+    _proc = 0;
+}
+
+void BalancingClientImpl::beginCall(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc)
+{
+    begin(method);
+
+    try
+    {
+        _client->beginCall(r, *_proxy, argv, argc);
+    }
+    catch (...)
+    {
+        release(true);
+        throw;
+    }
+}
+
+void BalancingClientImpl::endCall()
+{
+    _proc = 0;
+
+    if (_exceptionPending)
+    {
+        _exceptionPending = false;
+        throw;
+    }
+}
+
+void BalancingClientImpl::call(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc)
+{
+    begin(method);
+
+    try
+    {
+        _client->call(r, *_proxy, argv, argc);
+    }
+    catch (const RemoteException&)
+    {
+        release(false);
+        throw;
+    }
+    catch (...)
+    {
+        release(true);
+        throw;
+    }
+
+    if (_proxy->failed())
+        method.setFault(_proxy->rc(), _proxy->msg());
+
+    release(false);
+}
+
+void BalancingClientImpl::wait(std::size_t msecs)
+{
+    Clock clock;
+    if (msecs != RemoteClient::WaitInfinite)
+        clock.start();
+
+    std::size_t remaining = msecs;
+
+    while (_client)
+    {
+        _client->wait(remaining);
+
+        if (msecs != RemoteClient::WaitInfinite)
+        {
+            std::size_t diff = static_cast<std::size_t>(clock.stop().totalMSecs());
+            remaining = diff >= msecs ? 0 : msecs - diff;
+        }
+    }
+}
+
+void BalancingClientImpl::cancel()
+{
+    if (_client)
+    {
+        _client->cancel();
+        release(false);
+    }
+}
+
+void BalancingClientImpl::onFinished()
+{
+    // The connections report errors either with a fault or with an
+    // exception, which is rethrown by endCall while the error is handled.
+    // Only exceptions other than faults from the server are failures of
+    // the endpoint.
+    bool failed = false;
+    IRemoteProcedure* proc = _proc;
+
+    if (_proxy->failed())
+    {
+        proc->setFault(_proxy->rc(), _proxy->msg());
+    }
+    else
+    {
+        try
+        {
+            _client->endCall();
+        }
+        catch (const RemoteException&)
+        {
+            _exceptionPending = true;
+        }
+        catch (...)
+        {
+            log_debug("call to endpoint " << _endpoint << " failed");
+            failed = true;
+            _exceptionPending = true;
+        }
+    }
+
+    release(failed);
+
+    proc->onFinished();
+
+    if (_exceptionPending)
+    {
+        _exceptionPending = false;
+        throw;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+// BalancingClient
+//
+BalancingClient::BalancingClient(LoadBalancer& balancer)
+    : _impl(new BalancingClientImpl(balancer))
+{
+}
+
+BalancingClient::~BalancingClient()
+{
+    delete _impl;
+}
+
+void BalancingClient::beginCall(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc)
+{
+    _impl->beginCall(r, method, argv, argc);
+}
+
+void BalancingClient::endCall()
+{
+    _impl->endCall();
+}
+
+void BalancingClient::call(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc)
+{
+    _impl->call(r, method, argv, argc);
+}
+
+const IRemoteProcedure* BalancingClient::activeProcedure() const
+{
+    return _impl->activeProcedure();
+}
+
+void BalancingClient::cancel()
+{
+    _impl->cancel();
+}
+
+void BalancingClient::wait(std::size_t msecs)
+{
+    _impl->wait(msecs);
+}
+
+}
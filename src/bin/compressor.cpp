@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "compressor.h"
+#include <cxxtools/log.h>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+#include <string.h>
+#include <stdint.h>
+
+log_define("cxxtools.bin.compressor")
+
+namespace cxxtools
+{
+namespace bin
+{
+
+namespace
+{
+    const std::size_t minMatch = 4;
+    const std::size_t maxOffset = 65535;
+    const unsigned hashBits = 12;
+
+    inline uint32_t read32(const unsigned char* p)
+    {
+        return static_cast<uint32_t>(p[0])
+            | (static_cast<uint32_t>(p[1]) << 8)
+            | (static_cast<uint32_t>(p[2]) << 16)
+            | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    inline unsigned hash(uint32_t v)
+    {
+        return static_cast<uint32_t>(v * 2654435761U) >> (32 - hashBits);
+    }
+
+    void putLength(std::string& out, std::size_t len)
+    {
+        while (len >= 255)
+        {
+            out += '\xff';
+            len -= 255;
+        }
+
+        out += static_cast<char>(len);
+    }
+
+    // Appends a sequence of literals followed by a match to out. When
+    // matchLen is 0, the sequence is the last one and has no match part.
+    void putSequence(std::string& out, const unsigned char* literals, std::size_t litLen,
+        std::size_t offset, std::size_t matchLen)
+    {
+        std::size_t ml = matchLen > 0 ? matchLen - minMatch : 0;
+
+        unsigned char token = static_cast<unsigned char>(((litLen < 15 ? litLen : 15) << 4)
+                                                       | (ml < 15 ? ml : 15));
+        out += static_cast<char>(token);
+
+        if (litLen >= 15)
+            putLength(out, litLen - 15);
+
+        out.append(reinterpret_cast<const char*>(literals), litLen);
+
+        if (matchLen > 0)
+        {
+            out += static_cast<char>(offset & 0xff);
+            out += static_cast<char>(offset >> 8);
+
+            if (ml >= 15)
+                putLength(out, ml - 15);
+        }
+    }
+
+    std::size_t getLength(const unsigned char*& ip, const unsigned char* iend)
+    {
+        std::size_t len = 0;
+        unsigned char b;
+        do
+        {
+            if (ip >= iend)
+                throw std::runtime_error("invalid compressed data");
+            b = *ip++;
+            len += b;
+        } while (b == 255);
+
+        return len;
+    }
+
+    void putUInt32(std::ostream& out, uint32_t v)
+    {
+        out << static_cast<char>(v >> 24)
+            << static_cast<char>(v >> 16)
+            << static_cast<char>(v >> 8)
+            << static_cast<char>(v);
+    }
+}
+
+void compress(const char* data, std::size_t size, std::string& out)
+{
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(data);
+    std::vector<std::size_t> table(1 << hashBits, 0);
+
+    std::size_t anchor = 0;
+    std::size_t pos = 0;
+
+    out.reserve(out.size() + size / 2 + 16);
+
+    while (pos + minMatch <= size)
+    {
+        uint32_t v = read32(src + pos);
+        unsigned h = hash(v);
+        std::size_t candidate = table[h];
+        table[h] = pos;
+
+        if (candidate < pos && pos - candidate <= maxOffset
+            && read32(src + candidate) == v)
+        {
+            std::size_t matchLen = minMatch;
+            while (pos + matchLen < size && src[candidate + matchLen] == src[pos + matchLen])
+                ++matchLen;
+
+            putSequence(out, src + anchor, pos - anchor, pos - candidate, matchLen);
+
+            pos += matchLen;
+            anchor = pos;
+        }
+        else
+            ++pos;
+    }
+
+    putSequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+void uncompress(const char* data, std::size_t size, std::string& out, std::size_t rawSize)
+{
+    const unsigned char* ip = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* iend = ip + size;
+
+    // each byte of compressed data expands to at most 255 bytes
+    if (rawSize > size * 255 + 15)
+        throw std::runtime_error("invalid compressed data");
+
+    std::size_t start = out.size();
+    out.reserve(start + rawSize);
+
+    while (true)
+    {
+        if (ip >= iend)
+            throw std::runtime_error("invalid compressed data");
+
+        unsigned char token = *ip++;
+
+        std::size_t litLen = token >> 4;
+        if (litLen == 15)
+            litLen += getLength(ip, iend);
+
+        if (static_cast<std::size_t>(iend - ip) < litLen
+            || out.size() - start + litLen > rawSize)
+            throw std::runtime_error("invalid compressed data");
+
+        out.append(reinterpret_cast<const char*>(ip), litLen);
+        ip += litLen;
+
+        if (ip == iend)
+            break;
+
+        if (iend - ip < 2)
+            throw std::runtime_error("invalid compressed data");
+
+        std::size_t offset = ip[0] | (static_cast<std::size_t>(ip[1]) << 8);
+        ip += 2;
+
+        std::size_t matchLen = token & 15;
+        if (matchLen == 15)
+            matchLen += getLength(ip, iend);
+        matchLen += minMatch;
+
+        std::size_t outSize = out.size() - start;
+        if (offset == 0 || offset > outSize || outSize + matchLen > rawSize)
+            throw std::runtime_error("invalid compressed data");
+
+        std::size_t from = out.size() - offset;
+        if (offset >= matchLen)
+        {
+            out.resize(out.size() + matchLen);
+            ::memcpy(&out[out.size() - matchLen], &out[from], matchLen);
+        }
+        else
+        {
+            // overlapping match repeats the last offset bytes
+            for (std::size_t n = 0; n < matchLen; ++n)
+                out += out[from + n];
+        }
+    }
+
+    if (out.size() - start != rawSize)
+        throw std::runtime_error("invalid compressed data");
+}
+
+std::size_t putFrame(std::ostream& out, const std::string& frame, std::size_t threshold)
+{
+    std::string payload;
+    bool compressed = false;
+
+    if (threshold > 0 && frame.size() >= threshold)
+    {
+        compress(frame.data(), frame.size(), payload);
+        compressed = payload.size() < frame.size();
+        log_debug("compressed frame from " << frame.size() << " to " << payload.size() << " bytes");
+    }
+
+    const std::string& p = compressed ? payload : frame;
+
+    // the sizes are sent as 32 bit values
+    if (static_cast<unsigned long long>(frame.size()) > 0xffffffffull)
+        throw std::length_error("frame too large");
+
+    out << '\xc4' << (compressed ? '\1' : '\0');
+    putUInt32(out, frame.size());
+    putUInt32(out, p.size());
+    out.write(p.data(), p.size());
+
+    return compressed ? payload.size() : 0;
+}
+
+void CompressedFrame::begin(std::size_t maxSize)
+{
+    _state = state_method;
+    _maxSize = maxSize;
+}
+
+bool CompressedFrame::advance(char ch)
+{
+    switch (_state)
+    {
+        case state_method:
+            _method = static_cast<unsigned char>(ch);
+            if (_method > 1)
+                throw std::runtime_error("unknown compression method");
+            _rawSize = 0;
+            _count = 4;
+            _state = state_rawsize;
+            break;
+
+        case state_rawsize:
+            _rawSize = (_rawSize << 8) | static_cast<unsigned char>(ch);
+            if (--_count == 0)
+            {
+                _size = 0;
+                _count = 4;
+                _state = state_size;
+            }
+            break;
+
+        case state_size:
+            _size = (_size << 8) | static_cast<unsigned char>(ch);
+            if (--_count == 0)
+            {
+                if (_method == 0 && _size != _rawSize)
+                    throw std::runtime_error("invalid size of stored frame");
+
+                if (_maxSize > 0 && (_size > _maxSize || _rawSize > _maxSize))
+                {
+                    log_warn("frame of " << _rawSize << " bytes exceeds the limit of " << _maxSize << " bytes");
+                    throw std::runtime_error("frame too large");
+                }
+
+                _payload.clear();
+                _state = state_payload;
+
+                if (_size == 0)
+                    throw std::runtime_error("empty compressed frame");
+            }
+            break;
+
+        case state_payload:
+            _payload += ch;
+            if (_payload.size() >= _size)
+            {
+                _data.clear();
+                if (_method == 0)
+                    _data.swap(_payload);
+                else
+                    uncompress(_payload.data(), _payload.size(), _data, _rawSize);
+
+                _state = state_method;
+                return true;
+            }
+            break;
+    }
+
+    return false;
+}
+
+}
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CXXTOOLS_BIN_COMPRESSOR_H
+#define CXXTOOLS_BIN_COMPRESSOR_H
+
+#include <string>
+#include <iosfwd>
+
+namespace cxxtools
+{
+namespace bin
+{
+
+// Fast LZ77 compression in the style of LZ4, which is used for compressed
+// frames of the binary rpc protocol.
+//
+// A compressed frame starts with the byte 0xc4 followed by a method byte
+// (0 = stored, 1 = compressed), the size of the frame before compression
+// and the size of the payload as 4 byte big endian values and the payload.
+// The uncompressed payload is a complete request or reply.
+//
+// A client, which sends its request in a compressed frame, signals that it
+// accepts compressed frames, so that the server replies in a compressed
+// frame also.
+
+// compresses size bytes from data and appends the result to out
+void compress(const char* data, std::size_t size, std::string& out);
+
+// uncompresses size bytes from data to out; rawSize is the size of the
+// uncompressed data
+void uncompress(const char* data, std::size_t size, std::string& out, std::size_t rawSize);
+
+// The default limit of the size of received frames.
+const std::size_t defaultMaxFrameSize = 64 * 1024 * 1024;
+
+// Writes the request or reply in frame to out. It is compressed, when its
+// size reaches threshold and compressing actually reduces the size.
+// Returns the size of the compressed payload or 0, when it was stored.
+// Throws std::length_error, when the frame does not fit into 4 GiB.
+std::size_t putFrame(std::ostream& out, const std::string& frame, std::size_t threshold);
+
+// Parser for the frame header and the payload after the 0xc4 byte.
+class CompressedFrame
+{
+        enum State
+        {
+            state_method,
+            state_rawsize,
+            state_size,
+            state_payload
+        };
+
+    public:
+        CompressedFrame()
+            : _state(state_method),
+              _maxSize(defaultMaxFrameSize)
+        { }
+
+        // Starts a new frame. Frames, which are larger than maxSize bytes
+        // before or after compression, are rejected before the payload is
+        // read. 0 disables the limit.
+        void begin(std::size_t maxSize = defaultMaxFrameSize);
+
+        // returns true, when the frame is complete
+        bool advance(char ch);
+
+        // the uncompressed content of a complete frame
+        const std::string& data() const
+        { return _data; }
+
+        bool compressed() const
+        { return _method != 0; }
+
+        std::size_t payloadSize() const
+        { return _size; }
+
+    private:
+        State _state;
+        unsigned char _method;
+        unsigned _count;
+        std::size_t _rawSize;
+        std::size_t _size;
+        std::size_t _maxSize;
+        std::string _payload;
+        std::string _data;
+};
+
+}
+}
+
+#endif // CXXTOOLS_BIN_COMPRESSOR_H
@@ -41,7 +41,7 @@ void Deserializer::doDeserialize()
 
     char ch;
     while (_in.get(ch) && !vp.advance(ch))
-        ;
+        vp.readPacked(_in);
 
     if (_in.rdstate() & std::ios::badbit)
         SerializationError::doThrow("binary deserialization failed");
@@ -32,6 +32,7 @@
 #include <cxxtools/serviceprocedure.h>
 #include <cxxtools/remoteexception.h>
 #include <cxxtools/log.h>
+#include <sstream>
 
 log_define("cxxtools.bin.responder")
 
@@ -45,17 +46,18 @@ Responder::~Responder()
         _serviceRegistry.releaseProcedure(_proc);
 }
 
-void Responder::reply(IOStream& out)
+void Responder::reply(std::ostream& out)
 {
     log_info("send reply");
 
     out << '\xc1';
     _formatter.begin(out);
+    _formatter.useDictionary(_useDictionary);
     _result->format(_formatter);
     out << '\xff';
 }
 
-void Responder::replyError(IOStream& out, const char* msg, int rc)
+void Responder::replyError(std::ostream& out, const char* msg, int rc)
 {
     log_info("send error \"" << msg << '"');
 
@@ -69,49 +71,120 @@ void Responder::replyError(IOStream& out, const char* msg, int rc)
 }
 
 bool Responder::onInput(IOStream& ios)
+{
+    if (parse(ios))
+    {
+        call();
+        finish(ios);
+        return true;
+    }
+
+    return false;
+}
+
+bool Responder::parse(IOStream& ios)
 {
     while (ios.buffer().in_avail() > 0)
     {
         if (advance(ios.buffer().sbumpc()))
-        {
-            if (_failed)
-            {
-                replyError(ios, _errorMessage.c_str(), 0);
-            }
-            else
-            {
-                try
-                {
-                    _result = _proc->endCall();
-                    reply(ios);
-                }
-                catch (const RemoteException& e)
-                {
-                    ios.buffer().discard();
-                    replyError(ios, e.what(), e.rc());
-                }
-                catch (const std::exception& e)
-                {
-                    ios.buffer().discard();
-                    replyError(ios, e.what(), 0);
-                }
-            }
+            return true;
+    }
+
+    return false;
+}
 
-            _serviceRegistry.releaseProcedure(_proc);
-            _proc = 0;
-            _args = 0;
-            _result = 0;
-            _state = state_0;
-            _failed = false;
-            _errorMessage.clear();
+void Responder::call()
+{
+    if (_failed)
+        return;
 
-            return true;
-        }
+    if (_deadline > 0 && _deadlineClock.stop().totalMSecs() >= _deadline)
+    {
+        log_info("deadline of " << _deadline << " ms exceeded - request dropped");
+        _failed = true;
+        _errorMessage = "deadline exceeded";
+        return;
+    }
+
+    try
+    {
+        _result = _proc->endCall();
+    }
+    catch (const RemoteException& e)
+    {
+        _failed = true;
+        _errorMessage = e.what();
+        _errorCode = e.rc();
+    }
+    catch (const std::exception& e)
+    {
+        _failed = true;
+        _errorMessage = e.what();
+    }
+}
+
+bool Responder::putReply(std::ostream& out)
+{
+    if (_failed)
+    {
+        replyError(out, _errorMessage.c_str(), _errorCode);
+        return true;
+    }
+
+    try
+    {
+        reply(out);
+        return true;
+    }
+    catch (const RemoteException& e)
+    {
+        _errorMessage = e.what();
+        _errorCode = e.rc();
+    }
+    catch (const std::exception& e)
+    {
+        _errorMessage = e.what();
+        _errorCode = 0;
     }
 
     return false;
 }
 
+void Responder::finish(IOStream& ios)
+{
+    if (_compressed)
+    {
+        std::ostringstream frame;
+        if (!putReply(frame))
+        {
+            frame.str(std::string());
+            replyError(frame, _errorMessage.c_str(), _errorCode);
+        }
+
+        std::string data = frame.str();
+        std::size_t size = putFrame(ios, data, _server.compressionThreshold());
+        if (size > 0)
+            _server.addCompressionStatistics(data.size(), size);
+    }
+    else if (!putReply(ios))
+    {
+        ios.buffer().discard();
+        replyError(ios, _errorMessage.c_str(), _errorCode);
+    }
+
+    _serviceRegistry.releaseProcedure(_proc);
+    _proc = 0;
+    _args = 0;
+    _result = 0;
+    _state = state_0;
+    _failed = false;
+    _errorMessage.clear();
+    _errorCode = 0;
+    _compressed = false;
+    _useDictionary = false;
+    _deadline = 0;
+}
+
 bool Responder::advance(char ch)
 {
     switch (_state)
@@ -121,10 +194,33 @@ bool Responder::advance(char ch)
                 _state = state_method;
             else if (ch == '\xc3')
                 _state = state_domain;
+            else if (ch == '\xc4' && !_compressed)
+            {
+                _compressed = true;
+                _compressedFrame.begin(_server.maxFrameSize());
+                _state = state_compressed;
+            }
+            else if (ch == '\xc6')
+                _useDictionary = true;
+            else if (ch == '\xc5' && _deadline == 0)
+            {
+                _deadlineBytes = 0;
+                _state = state_deadline;
+            }
             else
                 throw std::runtime_error("domain or method name expected");
             break;
 
+        case state_deadline:
+            _deadline = (_deadline << 8) | static_cast<unsigned char>(ch);
+            if (++_deadlineBytes >= 4)
+            {
+                log_debug("deadline " << _deadline << " ms");
+                _deadlineClock.start();
+                _state = state_0;
+            }
+            break;
+
         case state_domain:
             if (ch == '\0')
             {
@@ -208,7 +304,7 @@ bool Responder::advance(char ch)
                 try
                 {
                     (*_args)->fixup(*_deserializer.si());
-                    _deserializer.si()->clear();
+                    _deserializer.si()->recycle();
                     ++_args;
                     _state = state_params;
                 }
@@ -226,6 +322,26 @@ bool Responder::advance(char ch)
                 _state = state_params_skip;
 
             break;
+
+        case state_compressed:
+            if (_compressedFrame.advance(ch))
+            {
+                if (_compressedFrame.compressed())
+                    _server.addCompressionStatistics(_compressedFrame.data().size(), _compressedFrame.payloadSize());
+
+                // the frame contains exactly one request
+                const std::string& data = _compressedFrame.data();
+                _state = state_0;
+                for (std::string::size_type n = 0; n < data.size(); ++n)
+                {
+                    if (advance(data[n]))
+                        return true;
+                }
+
+                throw std::runtime_error("incomplete request in compressed frame");
+            }
+
+            break;
     }
 
     return false;
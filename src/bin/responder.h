@@ -35,6 +35,8 @@
 #include <cxxtools/iostream.h>
 #include <cxxtools/bin/formatter.h>
 #include <cxxtools/serviceregistry.h>
+#include <cxxtools/clock.h>
+#include "compressor.h"
 
 namespace cxxtools
 {
@@ -58,29 +60,49 @@ class Responder
             state_params,
             state_params_skip,
             state_param,
-            state_param_skip
+            state_param_skip,
+            state_compressed,
+            state_deadline
         };
 
     public:
-        explicit Responder(ServiceRegistry& serviceRegistry)
+        Responder(ServiceRegistry& serviceRegistry, RpcServerImpl& server)
             : _serviceRegistry(serviceRegistry),
+              _server(server),
               _state(state_0),
               _proc(0),
               _args(0),
               _result(0),
-              _failed(false)
+              _failed(false),
+              _errorCode(0),
+              _compressed(false),
+              _useDictionary(false),
+              _deadline(0),
+              _deadlineBytes(0)
         { }
 
         ~Responder();
 
         // returns true, if request is ready and reply is put to the socket
         bool onInput(IOStream& ios);
+
+        // returns true, if a complete request is read; the request is
+        // executed by call() and the reply is put to the socket by finish()
+        bool parse(IOStream& ios);
+        void call();
+        void finish(IOStream& ios);
+
         bool advance(char ch);
-        void reply(IOStream& out);
-        void replyError(IOStream& out, const char* msg, int rc);
+        void reply(std::ostream& out);
+        void replyError(std::ostream& out, const char* msg, int rc);
 
     private:
+        // puts the reply or error reply to out; returns false, when
+        // formatting the result failed
+        bool putReply(std::ostream& out);
+
         ServiceRegistry& _serviceRegistry;
+        RpcServerImpl& _server;
         State _state;
         std::string _domain;
         std::string _methodName;
@@ -94,6 +116,20 @@ class Responder
 
         bool _failed;
         std::string _errorMessage;
+        int _errorCode;
+
+        // set, when the request was received in a compressed frame
+        bool _compressed;
+        CompressedFrame _compressedFrame;
+
+        // set, when the client accepts names compressed with a dictionary
+        bool _useDictionary;
+
+        // milliseconds after receiving the request, after which it is not
+        // executed any more; 0 when the client sent no deadline
+        uint32_t _deadline;
+        unsigned _deadlineBytes;
+        Clock _deadlineClock;
 };
 }
 }
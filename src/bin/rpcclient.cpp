@@ -109,6 +109,40 @@ void RpcClient::domain(const std::string& p)
 {
     _impl->domain(p);
 }
+std::size_t RpcClient::compressionThreshold() const
+{
+    return _impl->compressionThreshold();
+}
+
+void RpcClient::compressionThreshold(std::size_t n)
+{
+    _impl->compressionThreshold(n);
+}
+
+CompressionStatistics RpcClient::compressionStatistics() const
+{
+    return _impl->compressionStatistics();
+}
+
+std::size_t RpcClient::deadline() const
+{
+    return _impl->deadline();
+}
+
+void RpcClient::deadline(std::size_t msecs)
+{
+    _impl->deadline(msecs);
+}
+
+bool RpcClient::useDictionary() const
+{
+    return _impl->useDictionary();
+}
+
+void RpcClient::useDictionary(bool sw)
+{
+    _impl->useDictionary(sw);
+}
 
 }
 }
@@ -33,6 +33,8 @@
 #include <cxxtools/selector.h>
 #include <cxxtools/clock.h>
 #include <stdexcept>
+#include <sstream>
+#include "compressor.h"
 
 log_define("cxxtools.bin.rpcclient.impl")
 
@@ -44,9 +46,13 @@ namespace bin
 RpcClientImpl::RpcClientImpl(SelectorBase& selector, const std::string& addr, unsigned short port, const std::string& domain)
     : _proc(0),
       _stream(_socket, 8192, true),
+      _scanner(_compressionStatistics),
       _formatter(_stream),
       _exceptionPending(false),
-      _domain(domain)
+      _domain(domain),
+      _compressionThreshold(0),
+      _deadline(0),
+      _useDictionary(false)
 {
     setSelector(selector);
     connect(addr, port, domain);
@@ -60,9 +66,13 @@ RpcClientImpl::RpcClientImpl(SelectorBase& selector, const std::string& addr, un
 RpcClientImpl::RpcClientImpl(const std::string& addr, unsigned short port, const std::string& domain)
     : _proc(0),
       _stream(_socket, 8192, true),
+      _scanner(_compressionStatistics),
       _formatter(_stream),
       _exceptionPending(false),
-      _domain(domain)
+      _domain(domain),
+      _compressionThreshold(0),
+      _deadline(0),
+      _useDictionary(false)
 {
     connect(addr, port, domain);
 
@@ -216,17 +226,63 @@ void RpcClientImpl::cancel()
 
 void RpcClientImpl::prepareRequest(const String& name, IDecomposer** argv, unsigned argc)
 {
+    if (_compressionThreshold == 0)
+    {
+        putRequest(_stream, name, argv, argc);
+        return;
+    }
+
+    // the request is sent in a compressed frame, which signals the server,
+    // that we accept compressed replies also
+    std::ostringstream frame;
+    _formatter.begin(frame);
+
+    try
+    {
+        putRequest(frame, name, argv, argc);
+    }
+    catch (...)
+    {
+        _formatter.begin(_stream);
+        throw;
+    }
+
+    _formatter.begin(_stream);
+
+    std::string data = frame.str();
+    std::size_t size = putFrame(_stream, data, _compressionThreshold);
+    if (size > 0)
+        _compressionStatistics.add(data.size(), size);
+}
+
+void RpcClientImpl::putRequest(std::ostream& out, const String& name, IDecomposer** argv, unsigned argc)
+{
+    if (_deadline > 0)
+    {
+        uint32_t d = _deadline > 0xffffffff ? 0xffffffff : static_cast<uint32_t>(_deadline);
+        out << '\xc5'
+            << static_cast<char>(d >> 24)
+            << static_cast<char>(d >> 16)
+            << static_cast<char>(d >> 8)
+            << static_cast<char>(d);
+    }
+
+    if (_useDictionary)
+        out << '\xc6';
+
+    _formatter.useDictionary(_useDictionary);
+
     if (_domain.empty())
-        _stream << '\xc0' << name << '\0';
+        out << '\xc0' << name << '\0';
     else
-        _stream << '\xc3' << _domain << '\0' << name << '\0';
+        out << '\xc3' << _domain << '\0' << name << '\0';
 
     for(unsigned n = 0; n < argc; ++n)
     {
         argv[n]->format(_formatter);
     }
 
-    _stream << '\xff';
+    out << '\xff';
 }
 
 void RpcClientImpl::onConnect(net::TcpSocket& socket)
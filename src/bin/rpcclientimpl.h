@@ -36,6 +36,7 @@
 #include <cxxtools/string.h>
 #include <cxxtools/connectable.h>
 #include <cxxtools/deserializerbase.h>
+#include <cxxtools/bin/compressionstatistics.h>
 #include <string>
 #include "scanner.h"
 
@@ -51,7 +52,7 @@ class RpcClient;
 
 class RpcClientImpl : public Connectable
 {
-        RpcClientImpl(RpcClientImpl&) { }
+        RpcClientImpl(RpcClientImpl&) : _scanner(_compressionStatistics) { }
         void operator= (const RpcClientImpl&) { }
 
     public:
@@ -87,8 +88,30 @@ class RpcClientImpl : public Connectable
         void domain(const std::string& p)
         { _domain = p; }
 
+        std::size_t compressionThreshold() const
+        { return _compressionThreshold; }
+
+        void compressionThreshold(std::size_t n)
+        { _compressionThreshold = n; }
+
+        const CompressionStatistics& compressionStatistics() const
+        { return _compressionStatistics; }
+
+        std::size_t deadline() const
+        { return _deadline; }
+
+        void deadline(std::size_t msecs)
+        { _deadline = msecs; }
+
+        bool useDictionary() const
+        { return _useDictionary; }
+
+        void useDictionary(bool sw)
+        { _useDictionary = sw; }
+
     private:
         void prepareRequest(const String& name, IDecomposer** argv, unsigned argc);
+        void putRequest(std::ostream& out, const String& name, IDecomposer** argv, unsigned argc);
         void onConnect(net::TcpSocket& socket);
         void onOutput(StreamBuffer& sb);
         void onInput(StreamBuffer& sb);
@@ -96,6 +119,7 @@ class RpcClientImpl : public Connectable
         IRemoteProcedure* _proc;
         net::TcpSocket _socket;
         IOStream _stream;
+        CompressionStatistics _compressionStatistics;
         Scanner _scanner;
         DeserializerBase _deserializer;
         Formatter _formatter;
@@ -105,6 +129,10 @@ class RpcClientImpl : public Connectable
         std::string _addr;
         unsigned short _port;
         std::string _domain;
+
+        std::size_t _compressionThreshold;
+        std::size_t _deadline;
+        bool _useDictionary;
 };
 
 }
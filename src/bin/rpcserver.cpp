@@ -104,5 +104,39 @@ void RpcServer::maxThreads(unsigned m)
     _impl->maxThreads(m);
 }
 
+bool RpcServer::eventDriven() const
+{
+    return _impl->eventDriven();
+}
+
+void RpcServer::eventDriven(bool sw)
+{
+    _impl->eventDriven(sw);
+}
+std::size_t RpcServer::compressionThreshold() const
+{
+    return _impl->compressionThreshold();
+}
+
+void RpcServer::compressionThreshold(std::size_t n)
+{
+    _impl->compressionThreshold(n);
+}
+
+std::size_t RpcServer::maxFrameSize() const
+{
+    return _impl->maxFrameSize();
+}
+
+void RpcServer::maxFrameSize(std::size_t n)
+{
+    _impl->maxFrameSize(n);
+}
+
+CompressionStatistics RpcServer::compressionStatistics() const
+{
+    return _impl->compressionStatistics();
+}
+
 }
 }
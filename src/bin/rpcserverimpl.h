@@ -40,11 +40,13 @@
 #include <cxxtools/signal.h>
 #include <cxxtools/connectable.h>
 #include <cxxtools/bin/rpcserver.h>
+#include <cxxtools/bin/compressionstatistics.h>
 
 namespace cxxtools
 {
     class EventLoopBase;
     class ServiceProcedure;
+    class ThreadPool;
 
     namespace net
     {
@@ -61,6 +63,8 @@ namespace cxxtools
         class NoWaitingThreadsEvent;
         class ThreadTerminatedEvent;
         class ActiveSocketEvent;
+        class CallFinishedEvent;
+        class SocketReleasedEvent;
 
         class RpcServerImpl : private NonCopyable, public Connectable
         {
@@ -83,6 +87,27 @@ namespace cxxtools
                 void maxThreads(unsigned m)
                 { _maxThreads = m; }
 
+                bool eventDriven() const
+                { return _eventDriven; }
+
+                void eventDriven(bool sw);
+
+                std::size_t compressionThreshold() const
+                { return _compressionThreshold; }
+
+                void compressionThreshold(std::size_t n)
+                { _compressionThreshold = n; }
+
+                std::size_t maxFrameSize() const
+                { return _maxFrameSize; }
+
+                void maxFrameSize(std::size_t n)
+                { _maxFrameSize = n; }
+
+                CompressionStatistics compressionStatistics() const;
+
+                void addCompressionStatistics(std::size_t uncompressed, std::size_t compressed);
+
                 void terminate();
 
                 RpcServer::Runmode runmode() const
@@ -111,7 +136,16 @@ namespace cxxtools
                 void onServerStart(const ServerStartEvent& event);
                 void start();
 
+                // methods for the event driven mode
+                void onConnectionPending(net::TcpServer& listener);
+                void scheduleCall(Socket* socket);
+                void callFinished(Socket* socket);
+                void onCallFinished(const CallFinishedEvent& event);
+                void releaseSocket(Socket* socket);
+                void onSocketReleased(const SocketReleasedEvent& event);
+
                 friend class Worker;
+                friend class Socket;
 
                 ////////////////////////////////////////////////////
 
@@ -134,6 +168,20 @@ namespace cxxtools
                 Threads _terminatedThreads;
                 void threadTerminated(Worker* worker);
 
+                bool _eventDriven;
+                ThreadPool* _threadPool;
+                // the connections of the event driven mode by their id;
+                // released sockets are deleted in the event loop
+                typedef std::map<unsigned long, Socket*> Sockets;
+                Sockets _sockets;
+                std::vector<Socket*> _releasedSockets;
+                unsigned long _nextSocketId;
+
+                std::size_t _compressionThreshold;
+                std::size_t _maxFrameSize;
+                mutable Mutex _compressionMutex;
+                CompressionStatistics _compressionStatistics;
+
                 bool isTerminating() const
                 { return runmode() == RpcServer::Terminating; }
 
@@ -48,6 +48,7 @@ void Scanner::begin(DeserializerBase& handler, IComposer& composer)
     _failed = false;
     _errorCode = 0;
     _errorMessage.clear();
+    _compressed = false;
 }
 
 bool Scanner::advance(char ch)
@@ -66,6 +67,12 @@ bool Scanner::advance(char ch)
                 _state = state_errorcode;
                 _count = 4;
             }
+            else if (ch == '\xc4' && !_compressed)
+            {
+                _compressed = true;
+                _compressedFrame.begin();
+                _state = state_compressed;
+            }
             else
                 throw std::runtime_error("response expected");
             break;
@@ -74,7 +81,7 @@ bool Scanner::advance(char ch)
             if (_vp.advance(ch))
             {
                 _composer->fixup(*_deserializer->si());
-                _deserializer->si()->clear();
+                _deserializer->si()->recycle();
                 _state = state_end;
             }
             break;
@@ -101,6 +108,25 @@ bool Scanner::advance(char ch)
             else
                 throw std::runtime_error("end of response marker expected");
             break;
+
+        case state_compressed:
+            if (_compressedFrame.advance(ch))
+            {
+                if (_compressedFrame.compressed())
+                    _compressionStatistics.add(_compressedFrame.data().size(), _compressedFrame.payloadSize());
+
+                // the frame contains exactly one reply
+                const std::string& data = _compressedFrame.data();
+                _state = state_0;
+                for (std::string::size_type n = 0; n < data.size(); ++n)
+                {
+                    if (advance(data[n]))
+                        return true;
+                }
+
+                throw std::runtime_error("incomplete reply in compressed frame");
+            }
+            break;
     }
 
     return false;
@@ -31,7 +31,9 @@
 
 #include <cxxtools/composer.h>
 #include <cxxtools/bin/valueparser.h>
+#include <cxxtools/bin/compressionstatistics.h>
 #include <string>
+#include "compressor.h"
 
 namespace cxxtools
 {
@@ -40,9 +42,11 @@ namespace cxxtools
         class Scanner
         {
             public:
-                Scanner()
+                explicit Scanner(CompressionStatistics& compressionStatistics)
                     : _state(state_0),
-                      _failed(false)
+                      _failed(false),
+                      _compressed(false),
+                      _compressionStatistics(compressionStatistics)
                 { }
 
                 void begin(DeserializerBase& handler, IComposer& composer);
@@ -58,7 +62,8 @@ namespace cxxtools
                     state_value,
                     state_errorcode,
                     state_errormessage,
-                    state_end
+                    state_end,
+                    state_compressed
                 } _state;
 
                 ValueParser _vp;
@@ -70,6 +75,10 @@ namespace cxxtools
                 bool _failed;
                 int _errorCode;
                 std::string _errorMessage;
+
+                bool _compressed;
+                CompressedFrame _compressedFrame;
+                CompressionStatistics& _compressionStatistics;
         };
     }
 }
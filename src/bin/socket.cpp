@@ -41,8 +41,9 @@ Socket::Socket(RpcServerImpl& server, ServiceRegistry& serviceRegistry, net::Tcp
     : inputSlot(slot(*this, &Socket::onInput)),
       _tcpServer(tcpServer),
       _server(server),
-      _responder(serviceRegistry),
-      _accepted(false)
+      _responder(serviceRegistry, server),
+      _accepted(false),
+      _id(0)
 {
     _stream.attachDevice(*this);
     cxxtools::connect(IODevice::inputReady, *this, &Socket::onIODeviceInput);
@@ -53,8 +54,9 @@ Socket::Socket(Socket& socket)
     : inputSlot(slot(*this, &Socket::onInput)),
       _tcpServer(socket._tcpServer),
       _server(socket._server),
-      _responder(socket._responder._serviceRegistry),
-      _accepted(false)
+      _responder(socket._responder._serviceRegistry, socket._server),
+      _accepted(false),
+      _id(0)
 {
     _stream.attachDevice(*this);
     cxxtools::connect(IODevice::inputReady, *this, &Socket::onIODeviceInput);
@@ -95,10 +97,19 @@ void Socket::onInput(StreamBuffer& sb)
     if (sb.in_avail() == 0 || sb.device()->eof())
     {
         close();
+        if (_server.eventDriven())
+            _server.releaseSocket(this);
         return;
     }
 
-    if (_responder.onInput(_stream))
+    if (_server.eventDriven())
+    {
+        if (_responder.parse(_stream))
+            _server.scheduleCall(this);
+        else
+            sb.beginRead();
+    }
+    else if (_responder.onInput(_stream))
     {
         sb.beginWrite();
         onOutput(sb);
@@ -135,11 +146,26 @@ bool Socket::onOutput(StreamBuffer& sb)
     {
         log_warn("exception occured when processing request: " << e.what());
         close();
+        if (_server.eventDriven())
+            _server.releaseSocket(this);
         return false;
     }
 
     return true;
 }
 
+void Socket::call()
+{
+    _responder.call();
+    _server.callFinished(this);
+}
+
+void Socket::onCallFinished()
+{
+    _responder.finish(_stream);
+    buffer().beginWrite();
+    onOutput(buffer());
+}
+
 }
 }
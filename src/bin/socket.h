@@ -60,10 +60,21 @@ class Socket : public net::TcpSocket, public Connectable
         void onInput(StreamBuffer& sb);
         bool onOutput(StreamBuffer& sb);
 
+        // executes the parsed request; called in a thread of the thread
+        // pool when the server is event driven
+        void call();
+        // puts the reply of the executed request to the socket; called in
+        // the event loop when the server is event driven
+        void onCallFinished();
+
         Signal<Socket&> inputReady;
 
         StreamBuffer& buffer()         { return _stream.buffer(); }
 
+        // identifies the connection in the event driven mode
+        unsigned long id() const       { return _id; }
+        void id(unsigned long n)       { _id = n; }
+
         MethodSlot<void, Socket, StreamBuffer&> inputSlot;
 
         Connection inputConnection;
@@ -77,6 +88,7 @@ class Socket : public net::TcpSocket, public Connectable
         IOStream _stream;
 
         bool _accepted;
+        unsigned long _id;
 };
 
 }
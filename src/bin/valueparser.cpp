@@ -30,9 +30,13 @@
 #include <cxxtools/deserializer.h>
 #include <cxxtools/bin/serializer.h>
 #include <cxxtools/serializationerror.h>
+#include <cxxtools/byteorder.h>
 #include <cxxtools/log.h>
 
+#include <istream>
+#include <algorithm>
 #include <math.h>
+#include <string.h>
 
 log_define("cxxtools.bin.valueparser")
 
@@ -100,6 +104,14 @@ namespace
             case Serializer::TypePlainMap: return "map";
             case Serializer::TypeMultimap:
             case Serializer::TypePlainMultimap: return "multimap";
+            case Serializer::TypePackedInt32:
+            case Serializer::TypePlainPackedInt32:
+            case Serializer::TypePackedInt64:
+            case Serializer::TypePlainPackedInt64:
+            case Serializer::TypePackedFloat:
+            case Serializer::TypePlainPackedFloat:
+            case Serializer::TypePackedDouble:
+            case Serializer::TypePlainPackedDouble: return "array";
             default:
             {
                 std::ostringstream msg;
@@ -111,6 +123,41 @@ namespace
     }
 
     static const char bcdDigits[16] = "0123456789+-. e";
+
+    unsigned packedSize(char packedType)
+    {
+        return packedType == Serializer::TypePackedInt32
+            || packedType == Serializer::TypePackedFloat ? 4 : 8;
+    }
+
+    template <typename T>
+    T getLe(const char* p)
+    {
+        T value;
+        memcpy(&value, p, sizeof(T));
+#ifndef CXXTOOLS_LITTLE_ENDIAN
+        if (isBigEndian())
+        {
+            char* v = reinterpret_cast<char*>(&value);
+            std::reverse(v, v + sizeof(T));
+        }
+#endif
+        return value;
+    }
+
+    // passes the values of a packed array as members to the deserializer
+    template <typename T, typename V>
+    void addPackedValues(DeserializerBase& deserializer, const std::string& data, const char* type)
+    {
+        for (std::size_t n = 0; n + sizeof(T) <= data.size(); n += sizeof(T))
+        {
+            deserializer.beginMember(std::string(), std::string(), SerializationInfo::Void);
+            deserializer.setTypeName(type);
+            deserializer.setCategory(SerializationInfo::Value);
+            deserializer.setValue(static_cast<V>(getLe<T>(data.data() + n)));
+            deserializer.leaveMember();
+        }
+    }
 }
 
 void ValueParser::begin(DeserializerBase& handler)
@@ -122,6 +169,9 @@ void ValueParser::begin(DeserializerBase& handler)
     _int = 0;
     _exp = 0;
     _token.clear();
+    _nameState = name_start;
+    _names.clear();
+    _dictionary = &_names;
 }
 
 
@@ -132,6 +182,9 @@ void ValueParser::beginSkip()
     _int = 0;
     _exp = 0;
     _token.clear();
+    _nameState = name_start;
+    _names.clear();
+    _dictionary = &_names;
 }
 
 
@@ -294,6 +347,18 @@ bool ValueParser::advance(char ch)
                                 _deserializer->setCategory(SerializationInfo::Array);
                             break;
 
+                        case Serializer::TypePackedInt32:
+                        case Serializer::TypePackedInt64:
+                        case Serializer::TypePackedFloat:
+                        case Serializer::TypePackedDouble:
+                            _packedType = tc;
+                            _count = 4;
+                            _nextstate = state_packed_length;
+                            _state = state_name;
+                            if (_deserializer)
+                                _deserializer->setCategory(SerializationInfo::Array);
+                            break;
+
                         case Serializer::TypePair:
                         case Serializer::TypeMap:
                         case Serializer::TypeMultimap:
@@ -399,6 +464,17 @@ bool ValueParser::advance(char ch)
                                 _deserializer->setCategory(SerializationInfo::Array);
                             break;
 
+                        case Serializer::TypePlainPackedInt32:
+                        case Serializer::TypePlainPackedInt64:
+                        case Serializer::TypePlainPackedFloat:
+                        case Serializer::TypePlainPackedDouble:
+                            _packedType = tc & ~0x40;
+                            _count = 4;
+                            _state = state_packed_length;
+                            if (_deserializer)
+                                _deserializer->setCategory(SerializationInfo::Array);
+                            break;
+
                         case Serializer::TypePlainPair:
                         case Serializer::TypePlainMap:
                         case Serializer::TypePlainMultimap:
@@ -419,7 +495,7 @@ bool ValueParser::advance(char ch)
             break;
 
         case state_name:
-            if (ch == '\0')
+            if (processName(ch))
             {
                 log_debug("name=" << _token);
                 if (_deserializer)
@@ -427,12 +503,10 @@ bool ValueParser::advance(char ch)
                 _token.clear();
                 _state = _nextstate;
             }
-            else
-                _token += ch;
             break;
 
         case state_value_type_other:
-            if (ch == '\0')
+            if (processName(ch))
             {
                 log_debug("typename=" << _token);
                 if (_deserializer)
@@ -442,8 +516,6 @@ bool ValueParser::advance(char ch)
                 _state = _nextstate;
                 _nextstate = state_value_value;
             }
-            else
-                _token += ch;
             break;
 
         case state_value_intsign:
@@ -618,6 +690,30 @@ bool ValueParser::advance(char ch)
         case state_lfloat_base:
             return processFloatBase(ch, 0, 16383);
 
+        case state_packed_length:
+            _int = (_int << 8) | static_cast<unsigned char>(ch);
+            if (--_count == 0)
+            {
+                // _int counts the remaining bytes of the values
+                _int *= packedSize(_packedType);
+                _token.clear();
+                if (_int == 0)
+                    return true;
+                _state = state_packed_data;
+            }
+            break;
+
+        case state_packed_data:
+            if (_deserializer)
+                _token += ch;
+
+            if (--_int == 0)
+            {
+                processPacked();
+                return true;
+            }
+            break;
+
         case state_object_type:
             if (static_cast<Serializer::TypeCode>(ch) == Serializer::TypePlainOther
                 || static_cast<Serializer::TypeCode>(ch) == Serializer::TypeOther)
@@ -631,15 +727,13 @@ bool ValueParser::advance(char ch)
             break;
 
         case state_object_type_other:
-            if (ch == '\0')
+            if (processName(ch))
             {
                 if (_deserializer)
                     _deserializer->setTypeName(_token);
                 _token.clear();
                 _state = state_object_member;
             }
-            else
-                _token += ch;
             break;
 
         case state_object_member:
@@ -660,6 +754,7 @@ bool ValueParser::advance(char ch)
             else
                 _next->beginSkip();
 
+            _next->_dictionary = _dictionary;
             _state = state_object_member_value;
             break;
 
@@ -684,15 +779,13 @@ bool ValueParser::advance(char ch)
             break;
 
         case state_array_type_other:
-            if (ch == '\0')
+            if (processName(ch))
             {
                 if (_deserializer)
                     _deserializer->setTypeName(_token);
                 _token.clear();
                 _state = state_array_member;
             }
-            else
-                _token += ch;
             break;
 
         case state_array_member:
@@ -712,6 +805,7 @@ bool ValueParser::advance(char ch)
                 _next->beginSkip();
             }
 
+            _next->_dictionary = _dictionary;
             _next->advance(ch);
             _state = state_array_member_value;
             break;
@@ -742,6 +836,7 @@ bool ValueParser::advance(char ch)
                     _next->beginSkip();
                 }
 
+                _next->_dictionary = _dictionary;
                 _next->advance(ch);
                 _state = state_array_member_value;
             }
@@ -757,6 +852,118 @@ bool ValueParser::advance(char ch)
     return false;
 }
 
+// Reads a zero terminated name into _token. A name starting with \1
+// is added to the dictionary, \2 is followed by the index of a name in
+// the dictionary as a varint. Returns true, when the name is complete.
+bool ValueParser::processName(char ch)
+{
+    switch (_nameState)
+    {
+        case name_start:
+            if (ch == '\1')
+            {
+                _nameState = name_define;
+                return false;
+            }
+            else if (ch == '\2')
+            {
+                _nameState = name_reference;
+                _int = 0;
+                _shift = 0;
+                return false;
+            }
+
+            _nameState = name_plain;
+            // no break
+
+        case name_plain:
+        case name_define:
+            if (ch != '\0')
+            {
+                _token += ch;
+                return false;
+            }
+
+            if (_nameState == name_define)
+                _dictionary->push_back(_token);
+            break;
+
+        case name_reference:
+            if (_shift > 28)
+                SerializationError::doThrow("invalid name reference");
+
+            _int |= static_cast<uint64_t>(ch & '\x7f') << _shift;
+            _shift += 7;
+            if (ch & '\x80')
+                return false;
+
+            if (_int >= _dictionary->size())
+                SerializationError::doThrow("invalid name reference");
+
+            _token = (*_dictionary)[_int];
+            _int = 0;
+            break;
+    }
+
+    _nameState = name_start;
+    return true;
+}
+
+void ValueParser::readPacked(std::istream& in)
+{
+    ValueParser* vp = this;
+    while ((vp->_state == state_object_member_value
+            || vp->_state == state_array_member_value) && vp->_next)
+        vp = vp->_next;
+
+    if (vp->_state != state_packed_data)
+        return;
+
+    // the buffer grows with the data actually read
+    while (vp->_int > 1)
+    {
+        std::streamsize n = static_cast<std::streamsize>(std::min(vp->_int - 1, uint64_t(65536)));
+        std::string::size_type size = vp->_token.size();
+        vp->_token.resize(size + n);
+        in.read(&vp->_token[size], n);
+        n = in.gcount();
+        vp->_token.resize(size + n);
+        if (!vp->_deserializer)
+            vp->_token.clear();
+
+        vp->_int -= n;
+        if (n == 0)
+            break;
+    }
+}
+
+void ValueParser::processPacked()
+{
+    if (_deserializer)
+    {
+        switch (_packedType)
+        {
+            case Serializer::TypePackedInt32:
+                addPackedValues<int32_t, DeserializerBase::int_type>(*_deserializer, _token, "int");
+                break;
+
+            case Serializer::TypePackedInt64:
+                addPackedValues<int64_t, DeserializerBase::int_type>(*_deserializer, _token, "int");
+                break;
+
+            case Serializer::TypePackedFloat:
+                addPackedValues<float, long double>(*_deserializer, _token, "double");
+                break;
+
+            case Serializer::TypePackedDouble:
+                addPackedValues<double, long double>(*_deserializer, _token, "double");
+                break;
+        }
+    }
+
+    _token.clear();
+}
+
 bool ValueParser::processFloatBase(char ch, unsigned shift, unsigned expOffset)
 {
     _int = (_int << 8) | static_cast<unsigned char>(ch);
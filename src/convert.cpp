@@ -30,6 +30,7 @@
 #include <iomanip>
 #include <limits>
 #include <cctype>
+#include <cstring>
 
 namespace cxxtools
 {
@@ -41,65 +42,49 @@ void _skipws(IterT& it, IterT end)
         ++it;
 }
 
-template<typename T>
-class nullterm_array_iterator : public std::iterator<std::input_iterator_tag, T>
+// Copies a string of ascii characters to a char buffer, so that numbers can
+// be parsed using the fast routines for contiguous character data.
+static bool _narrowAscii(const String& str, char* buf, std::size_t bufsize)
 {
-    public:
-        nullterm_array_iterator()
-        : _ptr(0)
-        { }
+    if (str.size() >= bufsize)
+        return false;
 
-        explicit nullterm_array_iterator(const T* ptr)
-        : _ptr(ptr)
-        {
-            if(*_ptr == '\0')
-                _ptr = 0;
-        }
+    const Char* p = str.data();
+    for (std::size_t n = 0; n < str.size(); ++n)
+    {
+        std::char_traits<Char>::int_type ch = std::char_traits<Char>::to_int_type(p[n]);
+        if (ch <= 0 || ch >= 0x80)
+            return false;
+        buf[n] = static_cast<char>(ch);
+    }
 
-        nullterm_array_iterator<T>& operator=(const nullterm_array_iterator<T>& it)
-        {
-            _ptr = it._ptr;
-            return *this;
-        }
-
-        bool operator==(const nullterm_array_iterator<T>& it) const
-        {
-            return _ptr == it._ptr;
-        }
-
-        bool operator!=(const nullterm_array_iterator<T>& it) const
-        {
-            return _ptr != it._ptr;
-        }
-
-        const T& operator*() const
-        {
-            return *_ptr;
-        }
-
-        nullterm_array_iterator<T>& operator++()
-        {
-            if(*++_ptr == '\0')
-                _ptr = 0;
-
-            return *this;
-        }
+    buf[str.size()] = '\0';
+    return true;
+}
 
-        nullterm_array_iterator<T> operator++(int)
-        {
-            if(*++_ptr == '\0')
-                _ptr = 0;
+template <typename T>
+bool _convertInt(T& n, const char* str, const char* end)
+{
+    bool ok = false;
+    const char* r = getInt(str, end, ok, n);
 
-            return *this;
-        }
+    if (ok)
+        _skipws(r, end);
 
-    private:
-        const T* _ptr;
-};
+    return ok && r == end;
+}
 
 template <typename T>
 void convertInt(T& n, const String& str, const char* typeto)
 {
+    char buf[64];
+    if (_narrowAscii(str, buf, sizeof(buf)))
+    {
+        if (!_convertInt(n, buf, buf + str.size()))
+            ConversionError::doThrow(typeto, "String", buf);
+        return;
+    }
+
     bool ok = false;
     String::const_iterator r = getInt( str.begin(), str.end(), ok, n, DecimalFormat<Char>() );
 
@@ -114,35 +99,41 @@ void convertInt(T& n, const String& str, const char* typeto)
 template <typename T>
 void convertInt(T& n, const std::string& str, const char* typeto)
 {
-    bool ok = false;
-    std::string::const_iterator r = getInt( str.begin(), str.end(), ok, n );
-
-    if (ok)
-        _skipws(r, str.end());
-
-    if( r != str.end() || ! ok )
+    if (!_convertInt(n, str.data(), str.data() + str.size()))
         ConversionError::doThrow(typeto, "string", str.c_str());
 }
 
 
 template <typename T>
 void convertInt(T& n, const char* str, const char* typeto)
+{
+    if (!_convertInt(n, str, str + std::strlen(str)))
+        ConversionError::doThrow(typeto, "char*");
+}
+
+template <typename T>
+bool _convertFloat(T& n, const char* str, const char* end)
 {
     bool ok = false;
-    nullterm_array_iterator<char> it(str);
-    nullterm_array_iterator<char> end;
-    it = getInt( it, end, ok, n );
+    const char* r = getFloat(str, end, ok, n);
 
     if (ok)
-        _skipws(it, end);
+        _skipws(r, end);
 
-    if( it != end || ! ok )
-        ConversionError::doThrow(typeto, "char*");
+    return ok && r == end;
 }
 
 template <typename T>
 void convertFloat(T& n, const String& str, const char* typeto)
 {
+    char buf[64];
+    if (_narrowAscii(str, buf, sizeof(buf)))
+    {
+        if (!_convertFloat(n, buf, buf + str.size()))
+            ConversionError::doThrow(typeto, "String", buf);
+        return;
+    }
+
     bool ok = false;
     String::const_iterator r = getFloat(str.begin(), str.end(), ok, n, FloatFormat<Char>() );
 
@@ -157,13 +148,7 @@ void convertFloat(T& n, const String& str, const char* typeto)
 template <typename T>
 void convertFloat(T& n, const std::string& str, const char* typeto)
 {
-    bool ok = false;
-    std::string::const_iterator r = getFloat(str.begin(), str.end(), ok, n);
-
-    if (ok)
-        _skipws(r, str.end());
-
-    if(r != str.end() || ! ok)
+    if (!_convertFloat(n, str.data(), str.data() + str.size()))
         ConversionError::doThrow(typeto, "string", str.c_str());
 }
 
@@ -171,15 +156,7 @@ void convertFloat(T& n, const std::string& str, const char* typeto)
 template <typename T>
 void convertFloat(T& n, const char* str, const char* typeto)
 {
-    bool ok = false;
-    nullterm_array_iterator<char> it(str);
-    nullterm_array_iterator<char> end;
-    it = getFloat( it, end, ok, n );
-
-    if (ok)
-        _skipws(it, end);
-
-    if( it != end || ! ok )
+    if (!_convertFloat(n, str, str + std::strlen(str)))
         ConversionError::doThrow(typeto, "char*", str);
 }
 
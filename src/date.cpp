@@ -142,9 +142,10 @@ void operator>>=(const SerializationInfo& si, Date& date)
     if (si.category() == cxxtools::SerializationInfo::Object)
     {
         unsigned short year, month, day;
-        si.getMember("year") >>= year;
-        si.getMember("month") >>= month;
-        si.getMember("day") >>= day;
+        cxxtools::SerializationInfo::Hint hint;
+        si.getMember("year", hint) >>= year;
+        si.getMember("month", hint) >>= month;
+        si.getMember("day", hint) >>= day;
         date.set(year, month, day);
     }
     else
@@ -61,6 +61,11 @@ namespace cxxtools
         _current->setValue(value);
     }
 
+    void DeserializerBase::setValue(const char* value, std::size_t len)
+    {
+        _current->setValue(value, len);
+    }
+
     void DeserializerBase::setValue(bool value)
     {
         _current->setValue(value);
@@ -88,6 +93,18 @@ namespace cxxtools
 
     void DeserializerBase::beginMember(const std::string& name, const std::string& type, SerializationInfo::Category category)
     {
+        if (_elementComposer && _current == &_si && _si.memberCount() > 0)
+        {
+            // reuse the node of the previous element
+            SerializationInfo& child = *_si.begin();
+            child.recycle();
+            child.setName(name);
+            child.setTypeName(type);
+            child.setCategory(category);
+            _current = &child;
+            return;
+        }
+
         SerializationInfo& child = _current->addMember(name);
         child.setTypeName(type);
         child.setCategory(category);
@@ -100,6 +117,9 @@ namespace cxxtools
         if( !p )
             SerializationError::doThrow("invalid member");
 
+        if (_elementComposer && p == &_si)
+            _elementComposer->fixup(*_current);
+
         _current = p;
     }
 
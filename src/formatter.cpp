@@ -66,5 +66,41 @@ void Formatter::addNull(const std::string& name, const std::string& type)
     addValueString(name, type, String());
 }
 
+void Formatter::addArray(const std::string& name, const std::string& type,
+                         const int32_t* values, std::size_t count)
+{
+    beginArray(name, type);
+    for (std::size_t n = 0; n < count; ++n)
+        addValueInt(std::string(), "int", values[n]);
+    finishArray();
+}
+
+void Formatter::addArray(const std::string& name, const std::string& type,
+                         const int64_t* values, std::size_t count)
+{
+    beginArray(name, type);
+    for (std::size_t n = 0; n < count; ++n)
+        addValueInt(std::string(), "int", values[n]);
+    finishArray();
+}
+
+void Formatter::addArray(const std::string& name, const std::string& type,
+                         const float* values, std::size_t count)
+{
+    beginArray(name, type);
+    for (std::size_t n = 0; n < count; ++n)
+        addValueFloat(std::string(), "double", values[n]);
+    finishArray();
+}
+
+void Formatter::addArray(const std::string& name, const std::string& type,
+                         const double* values, std::size_t count)
+{
+    beginArray(name, type);
+    for (std::size_t n = 0; n < count; ++n)
+        addValueFloat(std::string(), "double", values[n]);
+    finishArray();
+}
+
 }
 
@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Shortest decimal representation of floating point numbers using the
+ * Grisu2 algorithm described by Florian Loitsch in "Printing
+ * Floating-Point Numbers Quickly and Accurately with Integers" (PLDI 2010).
+ *
+ * Grisu2 always produces digits, which read back to the same value. In
+ * very rare cases the result is one digit longer than the shortest
+ * possible representation.
+ */
+
+#include <cxxtools/convert.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace cxxtools
+{
+
+namespace
+{
+    struct DiyFp
+    {
+        uint64_t f;
+        int e;
+
+        DiyFp()
+        { }
+
+        DiyFp(uint64_t f_, int e_)
+            : f(f_),
+              e(e_)
+        { }
+
+        DiyFp operator- (const DiyFp& rhs) const
+        {
+            return DiyFp(f - rhs.f, e);
+        }
+
+        DiyFp operator* (const DiyFp& rhs) const
+        {
+            const uint64_t M32 = 0xFFFFFFFFu;
+            uint64_t a = f >> 32;
+            uint64_t b = f & M32;
+            uint64_t c = rhs.f >> 32;
+            uint64_t d = rhs.f & M32;
+            uint64_t ac = a * c;
+            uint64_t bc = b * c;
+            uint64_t ad = a * d;
+            uint64_t bd = b * d;
+            uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+            tmp += 1u << 31;  // round
+            return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + rhs.e + 64);
+        }
+
+        DiyFp normalize() const
+        {
+            DiyFp res = *this;
+            while (!(res.f & (static_cast<uint64_t>(1) << 63)))
+            {
+                res.f <<= 1;
+                --res.e;
+            }
+            return res;
+        }
+    };
+
+    // normalized significands and binary exponents of 10^k for k = -348, -340, ..., 340
+    const uint64_t cachedPowersF[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+    };
+
+    const short cachedPowersE[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066
+    };
+
+    const uint64_t pow10[] = {
+        1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+        10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+        100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+        100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+        100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+    };
+
+    // returns a cached power c = 10^-K, so that the exponent of w * c
+    // falls into the range [-60, -32] for a normalized w with exponent e
+    DiyFp cachedPower(int e, int& K)
+    {
+        double dk = (-61 - e) * 0.30102999566398114 + 347;  // log10(2)
+        int k = static_cast<int>(dk);
+        if (dk - k > 0.0)
+            ++k;
+
+        unsigned index = static_cast<unsigned>((k >> 3) + 1);
+        K = -(-348 + static_cast<int>(index << 3));
+        return DiyFp(cachedPowersF[index], cachedPowersE[index]);
+    }
+
+    int countDecimalDigits(uint32_t n)
+    {
+        int count = 1;
+        while (n >= 10)
+        {
+            n /= 10;
+            ++count;
+        }
+        return count;
+    }
+
+    void grisuRound(char* buffer, int len, uint64_t delta, uint64_t rest,
+                    uint64_t tenKappa, uint64_t wpw)
+    {
+        // move the last digit towards w as long as we stay in the
+        // rounding interval
+        while (rest < wpw && delta - rest >= tenKappa
+            && (rest + tenKappa < wpw || wpw - rest > rest + tenKappa - wpw))
+        {
+            --buffer[len - 1];
+            rest += tenKappa;
+        }
+    }
+
+    int digitGen(const DiyFp& W, const DiyFp& Mp, uint64_t delta, char* buffer, int& K)
+    {
+        const DiyFp one(static_cast<uint64_t>(1) << -Mp.e, Mp.e);
+        const DiyFp wpw = Mp - W;
+        uint32_t p1 = static_cast<uint32_t>(Mp.f >> -one.e);
+        uint64_t p2 = Mp.f & (one.f - 1);
+        int kappa = countDecimalDigits(p1);
+        int len = 0;
+
+        while (kappa > 0)
+        {
+            uint32_t div = static_cast<uint32_t>(pow10[kappa - 1]);
+            uint32_t d = p1 / div;
+            p1 %= div;
+
+            if (d || len)
+                buffer[len++] = static_cast<char>('0' + d);
+
+            --kappa;
+            uint64_t tmp = (static_cast<uint64_t>(p1) << -one.e) + p2;
+            if (tmp <= delta)
+            {
+                K += kappa;
+                grisuRound(buffer, len, delta, tmp, pow10[kappa] << -one.e, wpw.f);
+                return len;
+            }
+        }
+
+        for (;;)
+        {
+            p2 *= 10;
+            delta *= 10;
+            char d = static_cast<char>(p2 >> -one.e);
+            if (d || len)
+                buffer[len++] = static_cast<char>('0' + d);
+
+            p2 &= one.f - 1;
+            --kappa;
+            if (p2 < delta)
+            {
+                K += kappa;
+                grisuRound(buffer, len, delta, p2, one.f,
+                           -kappa < 20 ? wpw.f * pow10[-kappa] : 0);
+                return len;
+            }
+        }
+    }
+
+    // f and e describe the value f * 2^e; hidden is the implicit leading
+    // bit of normalized values of the type
+    int grisu2(uint64_t f, int e, uint64_t hidden, char* buffer, int& K)
+    {
+        const DiyFp v(f, e);
+
+        // boundaries m+ and m- of the rounding interval of v
+        DiyFp mPlus = DiyFp((f << 1) + 1, e - 1).normalize();
+        DiyFp mMinus = f == hidden ? DiyFp((f << 2) - 1, e - 2)
+                                   : DiyFp((f << 1) - 1, e - 1);
+        mMinus.f <<= mMinus.e - mPlus.e;
+        mMinus.e = mPlus.e;
+
+        const DiyFp cmk = cachedPower(mPlus.e, K);
+        const DiyFp W = v.normalize() * cmk;
+        DiyFp Wp = mPlus * cmk;
+        DiyFp Wm = mMinus * cmk;
+        ++Wm.f;
+        --Wp.f;
+
+        return digitGen(W, Wp, Wp.f - Wm.f, buffer, K);
+    }
+}
+
+int shortestDigits(double d, char* digits, int& exp10)
+{
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+
+    const uint64_t hidden = static_cast<uint64_t>(1) << 52;
+    int biasedE = static_cast<int>((bits >> 52) & 0x7FF);
+    uint64_t significand = bits & (hidden - 1);
+
+    if (biasedE != 0)
+        return grisu2(significand + hidden, biasedE - 1075, hidden, digits, exp10);
+    else
+        return grisu2(significand, -1074, hidden, digits, exp10);
+}
+
+int shortestDigits(float d, char* digits, int& exp10)
+{
+    uint32_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+
+    const uint32_t hidden = static_cast<uint32_t>(1) << 23;
+    int biasedE = static_cast<int>((bits >> 23) & 0xFF);
+    uint32_t significand = bits & (hidden - 1);
+
+    if (biasedE != 0)
+        return grisu2(significand + hidden, biasedE - 150, hidden, digits, exp10);
+    else
+        return grisu2(significand, -149, hidden, digits, exp10);
+}
+
+}
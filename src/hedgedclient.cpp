@@ -0,0 +1,488 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cxxtools/hedgedclient.h>
+#include <cxxtools/remoteprocedure.h>
+#include <cxxtools/selector.h>
+#include <cxxtools/connectable.h>
+#include <cxxtools/timer.h>
+#include <cxxtools/clock.h>
+#include <cxxtools/ioerror.h>
+#include <cxxtools/log.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+log_define("cxxtools.hedgedclient")
+
+namespace cxxtools
+{
+
+class HedgedClientImpl : public Connectable
+{
+        // number of latencies used for calculating the hedge delay
+        static const std::size_t maxLatencies = 128;
+        // the hedge delay is not calculated before that many latencies are known
+        static const std::size_t minLatencies = 20;
+
+        // Keeps the results passed by one of the clients, so that only the
+        // results of the request, which wins, are passed to the composer of
+        // the caller.
+        class LegComposer : public IComposer
+        {
+                std::vector<SerializationInfo> _results;
+
+            public:
+                void clear()
+                { _results.clear(); }
+
+                virtual void fixup(const SerializationInfo& si)
+                { _results.push_back(si); }
+
+                void fixupTo(IComposer& r) const
+                {
+                    for (std::vector<SerializationInfo>::const_iterator it = _results.begin(); it != _results.end(); ++it)
+                        r.fixup(*it);
+                }
+        };
+
+        // Proxy procedure, which receives the completion of the request to
+        // one of the clients.
+        class Leg : public IRemoteProcedure
+        {
+                HedgedClientImpl& _impl;
+                LegComposer _composer;
+                bool _started;
+                bool _finished;
+                bool _failed;
+                int _rc;
+                std::string _msg;
+                Clock _clock;
+
+            public:
+                Leg(HedgedClientImpl& impl, RemoteClient& client, const String& name)
+                    : IRemoteProcedure(client, name),
+                      _impl(impl),
+                      _started(false),
+                      _finished(false),
+                      _failed(false),
+                      _rc(0)
+                { }
+
+                void setFault(int rc, const std::string& msg)
+                {
+                    _failed = true;
+                    _rc = rc;
+                    _msg = msg;
+                }
+
+                bool failed() const
+                { return _failed; }
+
+                int rc() const
+                { return _rc; }
+
+                const std::string& msg() const
+                { return _msg; }
+
+                bool started() const
+                { return _started; }
+
+                bool finished() const
+                { return _finished; }
+
+                bool running() const
+                { return _started && !_finished; }
+
+                LegComposer& composer()
+                { return _composer; }
+
+                void start()
+                {
+                    _started = true;
+                    _composer.clear();
+                    _clock.start();
+                }
+
+                Timespan finish()
+                {
+                    _finished = true;
+                    return _clock.stop();
+                }
+
+                void onFinished()
+                { _impl.onLegFinished(*this); }
+        };
+
+    public:
+        HedgedClientImpl(SelectorBase& selector, RemoteClient& primary, RemoteClient& secondary);
+        ~HedgedClientImpl();
+
+        void beginCall(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc);
+        void endCall();
+        void wait(std::size_t msecs);
+        void cancel();
+
+        const IRemoteProcedure* activeProcedure() const
+        { return _proc; }
+
+        std::size_t hedgeDelay() const
+        { return std::max(_hedgeDelay, _minHedgeDelay); }
+
+        std::size_t minHedgeDelay() const
+        { return _minHedgeDelay; }
+
+        void minHedgeDelay(std::size_t msecs)
+        { _minHedgeDelay = msecs; }
+
+        std::size_t hedgedCalls() const
+        { return _hedgedCalls; }
+
+    private:
+        void beginLeg(unsigned n);
+        void releaseLegs();
+        void onTimeout();
+        void onLegFinished(Leg& leg);
+        void finishCall();
+        void addLatency(const Timespan& latency);
+
+        SelectorBase& _selector;
+        RemoteClient* _clients[2];
+        Leg* _legs[2];
+        Timer _timer;
+
+        IComposer* _r;
+        IRemoteProcedure* _proc;
+        std::vector<IDecomposer*> _argv;
+        bool _exceptionPending;
+
+        std::vector<std::size_t> _latencies;
+        std::size_t _latencyPos;
+        std::size_t _hedgeDelay;
+        std::size_t _minHedgeDelay;
+        std::size_t _hedgedCalls;
+};
+
+HedgedClientImpl::HedgedClientImpl(SelectorBase& selector, RemoteClient& primary, RemoteClient& secondary)
+    : _selector(selector),
+      _r(0),
+      _proc(0),
+      _exceptionPending(false),
+      _latencyPos(0),
+      _hedgeDelay(0),
+      _minHedgeDelay(10),
+      _hedgedCalls(0)
+{
+    _clients[0] = &primary;
+    _clients[1] = &secondary;
+    _legs[0] = _legs[1] = 0;
+
+    selector.add(_timer);
+    cxxtools::connect(_timer.timeout, *this, &HedgedClientImpl::onTimeout);
+}
+
+HedgedClientImpl::~HedgedClientImpl()
+{
+    cancel();
+    releaseLegs();
+}
+
+void HedgedClientImpl::beginCall(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc)
+{
+    if (_proc)
+        throw std::logic_error("asyncronous request already running");
+
+    releaseLegs();
+
+    _r = &r;
+    _argv.assign(argv, argv + argc);
+    _legs[0] = new Leg(*this, *_clients[0], method.name());
+    _legs[1] = new Leg(*this, *_clients[1], method.name());
+
+    _proc = &method;
+
+    try
+    {
+        beginLeg(0);
+    }
+    catch (...)
+    {
+        _proc = 0;
+        throw;
+    }
+
+    log_debug("hedge request \"" << method.name() << "\" after " << hedgeDelay() << " ms");
+    _timer.start(hedgeDelay());
+}
+
+void HedgedClientImpl::endCall()
+{
+    _proc = 0;
+
+    if (_exceptionPending)
+    {
+        _exceptionPending = false;
+        throw;
+    }
+}
+
+void HedgedClientImpl::wait(std::size_t msecs)
+{
+    Clock clock;
+    if (msecs != RemoteClient::WaitInfinite)
+        clock.start();
+
+    std::size_t remaining = msecs;
+
+    while (activeProcedure() != 0)
+    {
+        if (_selector.wait(remaining) == false)
+            throw IOTimeout();
+
+        if (msecs != RemoteClient::WaitInfinite)
+        {
+            std::size_t diff = static_cast<std::size_t>(clock.stop().totalMSecs());
+            remaining = diff >= msecs ? 0 : msecs - diff;
+        }
+    }
+}
+
+void HedgedClientImpl::cancel()
+{
+    _timer.stop();
+
+    for (unsigned n = 0; n < 2; ++n)
+    {
+        if (_legs[n] && _legs[n]->running())
+        {
+            _legs[n]->finish();
+            _legs[n]->cancel();
+        }
+    }
+
+    _proc = 0;
+}
+
+void HedgedClientImpl::beginLeg(unsigned n)
+{
+    _legs[n]->start();
+    _clients[n]->beginCall(_legs[n]->composer(), *_legs[n], _argv.empty() ? 0 : &_argv[0], _argv.size());
+}
+
+void HedgedClientImpl::releaseLegs()
+{
+    for (unsigned n = 0; n < 2; ++n)
+    {
+        delete _legs[n];
+        _legs[n] = 0;
+    }
+}
+
+void HedgedClientImpl::onTimeout()
+{
+    _timer.stop();
+
+    if (_proc && !_legs[1]->started())
+    {
+        log_debug("no reply within " << hedgeDelay() << " ms - send hedged request");
+        ++_hedgedCalls;
+        beginLeg(1);
+    }
+}
+
+void HedgedClientImpl::onLegFinished(Leg& leg)
+{
+    unsigned other = &leg == _legs[0] ? 1 : 0;
+
+    Timespan latency = leg.finish();
+
+    // The clients report errors either with a fault or with an exception,
+    // which is rethrown by endCall while the error is handled.
+    bool failed = leg.failed();
+    if (!failed)
+    {
+        try
+        {
+            leg.client().endCall();
+        }
+        catch (...)
+        {
+            failed = true;
+        }
+    }
+
+    if (failed)
+    {
+        if (!_legs[other]->started())
+        {
+            log_debug("request failed - send hedged request immediately");
+            _timer.stop();
+            ++_hedgedCalls;
+            beginLeg(other);
+            return;
+        }
+
+        if (_legs[other]->running())
+        {
+            log_debug("request failed - wait for hedged request");
+            return;
+        }
+
+        if (leg.failed())
+            _proc->setFault(leg.rc(), leg.msg());
+        else
+            _exceptionPending = true;
+    }
+    else
+    {
+        addLatency(latency);
+
+        if (_legs[other]->running())
+        {
+            log_debug("cancel slower request");
+            _legs[other]->finish();
+            _legs[other]->cancel();
+        }
+
+        try
+        {
+            leg.composer().fixupTo(*_r);
+        }
+        catch (...)
+        {
+            _exceptionPending = true;
+            finishCall();
+            return;
+        }
+    }
+
+    finishCall();
+}
+
+void HedgedClientImpl::finishCall()
+{
+    _timer.stop();
+
+    IRemoteProcedure* proc = _proc;
+    _proc = 0;
+    proc->onFinished();
+
+    // a pending exception is rethrown, when the caller did not fetch it
+    // with endCall
+    if (_exceptionPending)
+    {
+        _exceptionPending = false;
+        throw;
+    }
+}
+
+void HedgedClientImpl::addLatency(const Timespan& latency)
+{
+    std::size_t msecs = static_cast<std::size_t>(latency.totalMSecs());
+
+    if (_latencies.size() < maxLatencies)
+        _latencies.push_back(msecs);
+    else
+        _latencies[_latencyPos] = msecs;
+
+    _latencyPos = (_latencyPos + 1) % maxLatencies;
+
+    if (_latencies.size() >= minLatencies)
+    {
+        std::vector<std::size_t> l(_latencies);
+        std::vector<std::size_t>::iterator p95 = l.begin() + l.size() * 95 / 100;
+        std::nth_element(l.begin(), p95, l.end());
+        _hedgeDelay = *p95;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+// HedgedClient
+//
+HedgedClient::HedgedClient(SelectorBase& selector, RemoteClient& primary, RemoteClient& secondary)
+    : _impl(new HedgedClientImpl(selector, primary, secondary))
+{
+}
+
+HedgedClient::~HedgedClient()
+{
+    delete _impl;
+}
+
+void HedgedClient::beginCall(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc)
+{
+    _impl->beginCall(r, method, argv, argc);
+}
+
+void HedgedClient::endCall()
+{
+    _impl->endCall();
+}
+
+void HedgedClient::call(IComposer& r, IRemoteProcedure& method, IDecomposer** argv, unsigned argc)
+{
+    _impl->beginCall(r, method, argv, argc);
+    _impl->wait(WaitInfinite);
+}
+
+const IRemoteProcedure* HedgedClient::activeProcedure() const
+{
+    return _impl->activeProcedure();
+}
+
+void HedgedClient::cancel()
+{
+    _impl->cancel();
+}
+
+void HedgedClient::wait(std::size_t msecs)
+{
+    _impl->wait(msecs);
+}
+
+std::size_t HedgedClient::hedgeDelay() const
+{
+    return _impl->hedgeDelay();
+}
+
+std::size_t HedgedClient::minHedgeDelay() const
+{
+    return _impl->minHedgeDelay();
+}
+
+void HedgedClient::minHedgeDelay(std::size_t msecs)
+{
+    _impl->minHedgeDelay(msecs);
+}
+
+std::size_t HedgedClient::hedgedCalls() const
+{
+    return _impl->hedgedCalls();
+}
+
+}
@@ -42,12 +42,20 @@ namespace cxxtools
 namespace json
 {
 Responder::Responder(ServiceRegistry& serviceRegistry)
-    : _serviceRegistry(serviceRegistry)
+    : _serviceRegistry(serviceRegistry),
+      _proc(0),
+      _id(0),
+      _result(0),
+      _failed(false),
+      _remoteException(false),
+      _errorCode(0)
 {
 }
 
 Responder::~Responder()
 {
+    if (_proc)
+        _serviceRegistry.releaseProcedure(_proc);
 }
 
 void Responder::begin()
@@ -60,28 +68,23 @@ void Responder::finalize(std::ostream& out)
 {
     log_trace("finalize");
 
-    std::string methodName;
-    ServiceProcedure* proc = 0;
-
-    TextOStream ts(out, new Utf8Codec());
-    JsonFormatter formatter;
-
-    formatter.begin(ts);
-
-    formatter.beginObject(std::string(), std::string());
-    formatter.addValueString("jsonrpc", "string", L"2.0");
+    call();
+    reply(out);
+}
 
+void Responder::call()
+{
     try
     {
-        _deserializer.si()->getMember("method") >>= methodName;
+        _deserializer.si()->getMember("method") >>= _methodName;
 
-        log_debug("method = " << methodName);
-        proc = _serviceRegistry.getProcedure(methodName);
-        if( ! proc )
-            throw std::runtime_error("no such procedure \"" + methodName + '"');
+        log_debug("method = " << _methodName);
+        _proc = _serviceRegistry.getProcedure(_methodName);
+        if( ! _proc )
+            throw std::runtime_error("no such procedure \"" + _methodName + '"');
 
         // compose arguments
-        IComposer** args = proc->beginCall();
+        IComposer** args = _proc->beginCall();
 
         // process args
         const SerializationInfo* paramsPtr = _deserializer.si()->findMember("params");
@@ -106,18 +109,69 @@ void Responder::finalize(std::ostream& out)
         if (it != params.end())
             throw RemoteException("too many arguments");
 
-        IDecomposer::formatEach(_deserializer.si()->getMember("id"), formatter);
+        _id = &_deserializer.si()->getMember("id");
+
+        _result = _proc->endCall();
+    }
+    catch (const RemoteException& e)
+    {
+        log_debug("method \"" << _methodName << "\" exited with RemoteException: " << e.what());
+
+        _failed = true;
+        _remoteException = true;
+        _errorMessage = e.what();
+        _errorCode = e.rc();
+    }
+    catch (const std::exception& e)
+    {
+        log_debug("method \"" << _methodName << "\" exited with exception: " << e.what());
+
+        _failed = true;
+        _errorMessage = e.what();
+    }
+}
+
+void Responder::reply(std::ostream& out)
+{
+    TextOStream ts(out, new Utf8Codec());
+    JsonFormatter formatter;
+
+    formatter.begin(ts);
 
-        IDecomposer* result;
-        result = proc->endCall();
+    formatter.beginObject(std::string(), std::string());
+    formatter.addValueString("jsonrpc", "string", L"2.0");
+
+    try
+    {
+        if (_id)
+            IDecomposer::formatEach(*_id, formatter);
 
-        formatter.beginValue("result");
-        result->format(formatter);
-        formatter.finishValue();
+        if (_failed)
+        {
+            if (_remoteException)
+            {
+                formatter.beginObject("error", std::string());
+
+                formatter.addValueInt("code", "int", static_cast<Formatter::int_type>(_errorCode));
+                formatter.addValueStdString("message", std::string(), _errorMessage);
+
+                formatter.finishObject();
+            }
+            else
+            {
+                formatter.addValueStdString("error", std::string(), _errorMessage);
+            }
+        }
+        else
+        {
+            formatter.beginValue("result");
+            _result->format(formatter);
+            formatter.finishValue();
+        }
     }
     catch (const RemoteException& e)
     {
-        log_debug("method \"" << methodName << "\" exited with RemoteException: " << e.what());
+        log_debug("method \"" << _methodName << "\" exited with RemoteException: " << e.what());
 
         formatter.beginObject("error", std::string());
 
@@ -128,14 +182,23 @@ void Responder::finalize(std::ostream& out)
     }
     catch (const std::exception& e)
     {
-        log_debug("method \"" << methodName << "\" exited with exception: " << e.what());
+        log_debug("method \"" << _methodName << "\" exited with exception: " << e.what());
         formatter.addValueStdString("error", std::string(), e.what());
     }
 
     formatter.finishObject();
 
-    if (proc)
-        _serviceRegistry.releaseProcedure(proc);
+    if (_proc)
+        _serviceRegistry.releaseProcedure(_proc);
+
+    _methodName.clear();
+    _proc = 0;
+    _id = 0;
+    _result = 0;
+    _failed = false;
+    _remoteException = false;
+    _errorMessage.clear();
+    _errorCode = 0;
 }
 
 bool Responder::advance(char ch)
@@ -39,6 +39,7 @@ namespace cxxtools
 {
 
 class ServiceRegistry;
+class ServiceProcedure;
 
 namespace json
 {
@@ -56,14 +57,26 @@ class Responder
         bool advance(char ch);
         void finalize(std::ostream& out);
 
+        // finalize is split into call, which executes the procedure, and
+        // reply, which puts the result to the stream
+        void call();
+        void reply(std::ostream& out);
+
     private:
 
         ServiceRegistry& _serviceRegistry;
         JsonParser _parser;
         DeserializerBase _deserializer;
 
+        std::string _methodName;
+        ServiceProcedure* _proc;
+        const SerializationInfo* _id;
+        IDecomposer* _result;
+
         bool _failed;
+        bool _remoteException;
         std::string _errorMessage;
+        int _errorCode;
 };
 }
 }
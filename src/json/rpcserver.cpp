@@ -94,5 +94,15 @@ void RpcServer::maxThreads(unsigned m)
     _impl->maxThreads(m);
 }
 
+bool RpcServer::eventDriven() const
+{
+    return _impl->eventDriven();
+}
+
+void RpcServer::eventDriven(bool sw)
+{
+    _impl->eventDriven(sw);
+}
+
 }
 }
@@ -32,6 +32,7 @@
 
 #include <cxxtools/eventloop.h>
 #include <cxxtools/net/tcpserver.h>
+#include <cxxtools/threadpool.h>
 #include <cxxtools/log.h>
 
 #include <signal.h>
@@ -93,6 +94,38 @@ class ThreadTerminatedEvent : public BasicEvent<ThreadTerminatedEvent>
         Worker* worker() const   { return _worker; }
 };
 
+// Sent from the thread pool in event driven mode, when a procedure
+// call has finished and the reply can be sent. The socket is passed by
+// its id, so that a socket, which was released meanwhile, is not used.
+class CallFinishedEvent : public BasicEvent<CallFinishedEvent>
+{
+        const RpcServerImpl* _server;
+        unsigned long _socketId;
+
+    public:
+        CallFinishedEvent(const RpcServerImpl* server, unsigned long socketId)
+            : _server(server),
+              _socketId(socketId)
+            { }
+
+        const RpcServerImpl* server() const   { return _server; }
+        unsigned long socketId() const        { return _socketId; }
+};
+
+// Sent in event driven mode, when a socket is released, so that it is
+// deleted in the event loop and not in its own signal handler.
+class SocketReleasedEvent : public BasicEvent<SocketReleasedEvent>
+{
+        const RpcServerImpl* _server;
+
+    public:
+        explicit SocketReleasedEvent(const RpcServerImpl* server)
+            : _server(server)
+            { }
+
+        const RpcServerImpl* server() const   { return _server; }
+};
+
 
 RpcServerImpl::RpcServerImpl(EventLoopBase& eventLoop, Signal<RpcServer::Runmode>& runmodeChanged, ServiceRegistry& serviceRegistry)
     : _runmode(RpcServer::Stopped),
@@ -101,12 +134,17 @@ RpcServerImpl::RpcServerImpl(EventLoopBase& eventLoop, Signal<RpcServer::Runmode
       inputSlot(slot(*this, &RpcServerImpl::onInput)),
       _serviceRegistry(serviceRegistry),
       _minThreads(5),
-      _maxThreads(200)
+      _maxThreads(200),
+      _eventDriven(false),
+      _threadPool(0),
+      _nextSocketId(0)
 {
     _eventLoop.event.subscribe(slot(*this, &RpcServerImpl::onIdleSocket));
     _eventLoop.event.subscribe(slot(*this, &RpcServerImpl::onNoWaitingThreads));
     _eventLoop.event.subscribe(slot(*this, &RpcServerImpl::onThreadTerminated));
     _eventLoop.event.subscribe(slot(*this, &RpcServerImpl::onServerStart));
+    _eventLoop.event.subscribe(slot(*this, &RpcServerImpl::onCallFinished));
+    _eventLoop.event.subscribe(slot(*this, &RpcServerImpl::onSocketReleased));
 
     connect(_eventLoop.exited, *this, &RpcServerImpl::terminate);
 
@@ -136,7 +174,15 @@ void RpcServerImpl::listen(const std::string& ip, unsigned short int port, int b
     try
     {
         _listener.push_back(listener);
-        _queue.put(new Socket(*this, _serviceRegistry, *listener));
+        if (!_eventDriven)
+        {
+            _queue.put(new Socket(*this, _serviceRegistry, *listener));
+        }
+        else if (runmode() == RpcServer::Running)
+        {
+            connect(listener->connectionPending, *this, &RpcServerImpl::onConnectionPending);
+            _eventLoop.add(*listener);
+        }
     }
     catch (...)
     {
@@ -146,11 +192,40 @@ void RpcServerImpl::listen(const std::string& ip, unsigned short int port, int b
 
 }
 
+void RpcServerImpl::eventDriven(bool sw)
+{
+    if (runmode() != RpcServer::Stopped)
+        throw std::logic_error("mode of rpc server can't be changed after start");
+
+    _eventDriven = sw;
+}
+
 void RpcServerImpl::start()
 {
     log_trace("start server");
     runmode(RpcServer::Starting);
 
+    if (_eventDriven)
+    {
+        log_debug("start event driven server with " << maxThreads() << " threads");
+
+        // accept sockets are not needed since the listeners are
+        // processed in the event loop
+        while (!_queue.empty())
+            delete _queue.get();
+
+        for (unsigned n = 0; n < _listener.size(); ++n)
+        {
+            connect(_listener[n]->connectionPending, *this, &RpcServerImpl::onConnectionPending);
+            _eventLoop.add(*_listener[n]);
+        }
+
+        _threadPool = new ThreadPool(maxThreads());
+
+        runmode(RpcServer::Running);
+        return;
+    }
+
     MutexLock lock(_threadMutex);
     while (_threads.size() < minThreads())
     {
@@ -189,6 +264,23 @@ void RpcServerImpl::terminate()
             _terminatedThreads.clear();
         }
 
+        if (_threadPool)
+        {
+            _threadPool->stop(true);
+            delete _threadPool;
+            _threadPool = 0;
+        }
+
+        for (Sockets::iterator it = _sockets.begin(); it != _sockets.end(); ++it)
+            delete it->second;
+
+        _sockets.clear();
+
+        for (unsigned n = 0; n < _releasedSockets.size(); ++n)
+            delete _releasedSockets[n];
+
+        _releasedSockets.clear();
+
         for (unsigned n = 0; n < _listener.size(); ++n)
             delete _listener[n];
         _listener.clear();
@@ -334,5 +426,78 @@ void RpcServerImpl::onInput(Socket& socket)
     }
 }
 
+void RpcServerImpl::onConnectionPending(net::TcpServer& listener)
+{
+    Socket* socket = new Socket(*this, _serviceRegistry, listener);
+
+    try
+    {
+        socket->accept();
+    }
+    catch (const std::exception& e)
+    {
+        log_warn("failed to accept connection: " << e.what());
+        delete socket;
+        return;
+    }
+
+    log_info("new connection accepted from " << socket->getPeerAddr());
+
+    socket->id(++_nextSocketId);
+    _sockets[socket->id()] = socket;
+    socket->setSelector(&_eventLoop);
+    socket->inputConnection = connect(socket->buffer().inputReady, socket->inputSlot);
+}
+
+void RpcServerImpl::scheduleCall(Socket* socket)
+{
+    log_debug("schedule call of socket " << static_cast<void*>(socket));
+    _threadPool->schedule(callable(*socket, &Socket::call));
+}
+
+void RpcServerImpl::callFinished(Socket* socket)
+{
+    _eventLoop.commitEvent(CallFinishedEvent(this, socket->id()));
+}
+
+void RpcServerImpl::onCallFinished(const CallFinishedEvent& event)
+{
+    if (event.server() != this)
+        return;
+
+    Sockets::iterator it = _sockets.find(event.socketId());
+    if (it == _sockets.end())
+    {
+        log_debug("socket " << event.socketId() << " already released");
+        return;
+    }
+
+    it->second->onCallFinished();
+}
+
+void RpcServerImpl::releaseSocket(Socket* socket)
+{
+    log_debug("release socket " << socket->id());
+    log_info("client " << socket->getPeerAddr() << " closed connection");
+
+    // the socket is released from its own signal handler, so it is
+    // deleted later in the event loop
+    socket->removeSelector();
+    _sockets.erase(socket->id());
+    _releasedSockets.push_back(socket);
+    _eventLoop.commitEvent(SocketReleasedEvent(this));
+}
+
+void RpcServerImpl::onSocketReleased(const SocketReleasedEvent& event)
+{
+    if (event.server() != this)
+        return;
+
+    for (unsigned n = 0; n < _releasedSockets.size(); ++n)
+        delete _releasedSockets[n];
+
+    _releasedSockets.clear();
+}
+
 }
 }
@@ -45,6 +45,7 @@ namespace cxxtools
 {
     class EventLoopBase;
     class ServiceProcedure;
+    class ThreadPool;
 
     namespace net
     {
@@ -61,6 +62,8 @@ namespace cxxtools
         class NoWaitingThreadsEvent;
         class ThreadTerminatedEvent;
         class ActiveSocketEvent;
+        class CallFinishedEvent;
+        class SocketReleasedEvent;
 
         class RpcServerImpl : private NonCopyable, public Connectable
         {
@@ -83,6 +86,11 @@ namespace cxxtools
                 void maxThreads(unsigned m)
                 { _maxThreads = m; }
 
+                bool eventDriven() const
+                { return _eventDriven; }
+
+                void eventDriven(bool sw);
+
                 void terminate();
 
                 RpcServer::Runmode runmode() const
@@ -111,7 +119,16 @@ namespace cxxtools
                 void onServerStart(const ServerStartEvent& event);
                 void start();
 
+                // methods for the event driven mode
+                void onConnectionPending(net::TcpServer& listener);
+                void scheduleCall(Socket* socket);
+                void callFinished(Socket* socket);
+                void onCallFinished(const CallFinishedEvent& event);
+                void releaseSocket(Socket* socket);
+                void onSocketReleased(const SocketReleasedEvent& event);
+
                 friend class Worker;
+                friend class Socket;
 
                 ////////////////////////////////////////////////////
 
@@ -134,6 +151,15 @@ namespace cxxtools
                 Threads _terminatedThreads;
                 void threadTerminated(Worker* worker);
 
+                bool _eventDriven;
+                ThreadPool* _threadPool;
+                // the connections of the event driven mode by their id;
+                // released sockets are deleted in the event loop
+                typedef std::map<unsigned long, Socket*> Sockets;
+                Sockets _sockets;
+                std::vector<Socket*> _releasedSockets;
+                unsigned long _nextSocketId;
+
                 bool isTerminating() const
                 { return runmode() == RpcServer::Terminating; }
 
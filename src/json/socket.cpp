@@ -42,7 +42,8 @@ Socket::Socket(RpcServerImpl& server, ServiceRegistry& serviceRegistry, net::Tcp
       _tcpServer(tcpServer),
       _server(server),
       _responder(serviceRegistry),
-      _accepted(false)
+      _accepted(false),
+      _id(0)
 {
     _stream.attachDevice(*this);
     cxxtools::connect(IODevice::inputReady, *this, &Socket::onIODeviceInput);
@@ -55,7 +56,8 @@ Socket::Socket(Socket& socket)
       _tcpServer(socket._tcpServer),
       _server(socket._server),
       _responder(socket._responder._serviceRegistry),
-      _accepted(false)
+      _accepted(false),
+      _id(0)
 {
     _stream.attachDevice(*this);
     cxxtools::connect(IODevice::inputReady, *this, &Socket::onIODeviceInput);
@@ -97,6 +99,8 @@ void Socket::onInput(StreamBuffer& sb)
     if (sb.in_avail() == 0 || sb.device()->eof())
     {
         close();
+        if (_server.eventDriven())
+            _server.releaseSocket(this);
         return;
     }
 
@@ -104,6 +108,12 @@ void Socket::onInput(StreamBuffer& sb)
     {
         if (_responder.advance(sb.sbumpc()))
         {
+            if (_server.eventDriven())
+            {
+                _server.scheduleCall(this);
+                return;
+            }
+
             _responder.finalize(_stream);
             buffer().beginWrite();
             onOutput(sb);
@@ -142,11 +152,26 @@ bool Socket::onOutput(StreamBuffer& sb)
     {
         log_warn("exception occured when processing request: " << e.what());
         close();
+        if (_server.eventDriven())
+            _server.releaseSocket(this);
         return false;
     }
 
     return true;
 }
 
+void Socket::call()
+{
+    _responder.call();
+    _server.callFinished(this);
+}
+
+void Socket::onCallFinished()
+{
+    _responder.reply(_stream);
+    buffer().beginWrite();
+    onOutput(buffer());
+}
+
 }
 }
@@ -27,17 +27,29 @@
  */
 
 #include <cxxtools/jsondeserializer.h>
+#include <cxxtools/jsonutf8parser.h>
 
 namespace cxxtools
 {
     JsonDeserializer::JsonDeserializer(std::istream& in, TextCodec<Char, char>* codec)
         : _ts(new TextIStream(in, codec)),
-          _in(*_ts)
+          _in(_ts),
+          _data(0),
+          _size(0)
     { }
 
     JsonDeserializer::JsonDeserializer(TextIStream& in)
         : _ts(0),
-          _in(in)
+          _in(&in),
+          _data(0),
+          _size(0)
+    { }
+
+    JsonDeserializer::JsonDeserializer(const char* data, std::size_t size)
+        : _ts(0),
+          _in(0),
+          _data(data),
+          _size(size)
     { }
 
     JsonDeserializer::~JsonDeserializer()
@@ -47,20 +59,31 @@ namespace cxxtools
 
     void JsonDeserializer::doDeserialize()
     {
+        if (_in == 0)
+        {
+            JsonUtf8Parser parser;
+            const char* end = _data + _size;
+            const char* p = parser.parse(_data, end, *this);
+            p = JsonUtf8Parser::skipWhitespace(p, end);
+            if (p != end)
+                SerializationError::doThrow(std::string("unexpected character '") + *p + "' after end");
+            return;
+        }
+
         JsonParser parser;
         parser.begin(*this);
         Char ch;
         int ret;
-        while (_in.get(ch))
+        while (_in->get(ch))
         {
             ret = parser.advance(ch);
             if (ret == -1)
-                _in.putback(ch);
+                _in->putback(ch);
             if (ret != 0)
                 return;
         }
 
-        if (_in.rdstate() & std::ios::badbit)
+        if (_in->rdstate() & std::ios::badbit)
             SerializationError::doThrow("json deserialization failed");
 
         parser.finish();
@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cxxtools/jsonlinesreader.h>
+#include <cxxtools/jsonutf8parser.h>
+#include <cxxtools/deserializerbase.h>
+#include <cxxtools/serializationerror.h>
+#include <cxxtools/threadpool.h>
+#include <cxxtools/mutex.h>
+#include <cxxtools/condition.h>
+#include <cxxtools/method.h>
+#include <cxxtools/convert.h>
+#include <cxxtools/log.h>
+#include <istream>
+#include <string>
+#include <vector>
+
+log_define("cxxtools.json.lines")
+
+namespace cxxtools
+{
+
+namespace
+{
+    bool isEmptyLine(const std::string& line)
+    {
+        const char* end = line.data() + line.size();
+        return JsonUtf8Parser::skipWhitespace(line.data(), end) == end;
+    }
+
+    void parseLine(JsonUtf8Parser& parser, const std::string& line, DeserializerBase& deserializer)
+    {
+        const char* end = line.data() + line.size();
+        deserializer.begin();
+        const char* p = parser.parse(line.data(), end, deserializer);
+        p = JsonUtf8Parser::skipWhitespace(p, end);
+        if (p != end)
+            SerializationError::doThrow(std::string("unexpected character '") + *p + "' after end");
+    }
+
+    void throwLineError(const std::string& msg, unsigned lineNumber)
+    {
+        SerializationError::doThrow(msg + " in line " + convert<std::string>(lineNumber));
+    }
+
+    // Lines, which are parsed together in a thread of the pool.
+    class Batch : private NonCopyable
+    {
+        public:
+            std::vector<std::string> lines;
+            std::vector<unsigned> lineNumbers;
+            std::vector<DeserializerBase*> records;
+            std::vector<std::string> errors;
+            unsigned count;
+            unsigned pos;
+
+            explicit Batch(unsigned size)
+                : lines(size),
+                  lineNumbers(size),
+                  count(0),
+                  pos(0),
+                  _done(true)
+            { }
+
+            ~Batch()
+            {
+                for (unsigned n = 0; n < records.size(); ++n)
+                    delete records[n];
+            }
+
+            void start()
+            {
+                while (records.size() < count)
+                    records.push_back(new DeserializerBase());
+                errors.assign(count, std::string());
+                pos = 0;
+                _done = false;
+            }
+
+            void parse()
+            {
+                for (unsigned n = 0; n < count; ++n)
+                {
+                    try
+                    {
+                        parseLine(_parser, lines[n], *records[n]);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        errors[n] = e.what();
+                    }
+                }
+
+                MutexLock lock(_mutex);
+                _done = true;
+                _finished.broadcast();
+            }
+
+            void wait()
+            {
+                MutexLock lock(_mutex);
+                while (!_done)
+                    _finished.wait(lock);
+            }
+
+        private:
+            JsonUtf8Parser _parser;
+            Mutex _mutex;
+            Condition _finished;
+            bool _done;
+    };
+}
+
+class JsonLinesReaderImpl
+{
+        static const unsigned batchSize = 256;
+
+        std::istream& _in;
+        unsigned _linesRead;
+        unsigned _lineNumber;
+        bool _eof;
+
+        // sequential reading
+        std::string _line;
+        JsonUtf8Parser _parser;
+        DeserializerBase _deserializer;
+
+        // parallel reading
+        ThreadPool* _pool;
+        std::vector<Batch*> _batches;
+        unsigned _current;
+
+        bool readLine(std::string& line);
+        void fill(Batch& batch);
+
+    public:
+        JsonLinesReaderImpl(std::istream& in, unsigned threads);
+        ~JsonLinesReaderImpl();
+
+        const SerializationInfo* next();
+        const SerializationInfo* nextParallel();
+
+        unsigned lineNumber() const
+        { return _lineNumber; }
+};
+
+JsonLinesReaderImpl::JsonLinesReaderImpl(std::istream& in, unsigned threads)
+    : _in(in),
+      _linesRead(0),
+      _lineNumber(0),
+      _eof(false),
+      _pool(0),
+      _current(0)
+{
+    if (threads > 0)
+    {
+        log_debug("read json lines in " << threads << " threads");
+
+        _pool = new ThreadPool(threads);
+        for (unsigned n = 0; n < threads * 2; ++n)
+            _batches.push_back(new Batch(batchSize));
+
+        for (unsigned n = 0; n < _batches.size(); ++n)
+            fill(*_batches[n]);
+    }
+}
+
+JsonLinesReaderImpl::~JsonLinesReaderImpl()
+{
+    // the thread pool finishes the scheduled batches before it is gone
+    delete _pool;
+    for (unsigned n = 0; n < _batches.size(); ++n)
+        delete _batches[n];
+}
+
+bool JsonLinesReaderImpl::readLine(std::string& line)
+{
+    while (!_eof)
+    {
+        if (!std::getline(_in, line))
+        {
+            _eof = true;
+            break;
+        }
+
+        ++_linesRead;
+        if (!isEmptyLine(line))
+            return true;
+    }
+
+    return false;
+}
+
+void JsonLinesReaderImpl::fill(Batch& batch)
+{
+    batch.count = 0;
+    while (batch.count < batch.lines.size() && readLine(batch.lines[batch.count]))
+        batch.lineNumbers[batch.count++] = _linesRead;
+
+    batch.start();
+    if (batch.count > 0)
+        _pool->schedule(callable(batch, &Batch::parse));
+    else
+        batch.parse();
+}
+
+const SerializationInfo* JsonLinesReaderImpl::next()
+{
+    if (_pool)
+        return nextParallel();
+
+    if (!readLine(_line))
+        return 0;
+
+    _lineNumber = _linesRead;
+
+    try
+    {
+        parseLine(_parser, _line, _deserializer);
+    }
+    catch (const SerializationError& e)
+    {
+        throwLineError(e.what(), _lineNumber);
+    }
+
+    return _deserializer.si();
+}
+
+const SerializationInfo* JsonLinesReaderImpl::nextParallel()
+{
+    while (true)
+    {
+        Batch& batch = *_batches[_current];
+        batch.wait();
+
+        if (batch.pos < batch.count)
+        {
+            unsigned pos = batch.pos++;
+            _lineNumber = batch.lineNumbers[pos];
+            if (!batch.errors[pos].empty())
+                throwLineError(batch.errors[pos], _lineNumber);
+            return batch.records[pos]->si();
+        }
+
+        // the last batch was not filled completely
+        if (batch.count < batch.lines.size())
+            return 0;
+
+        fill(batch);
+        _current = (_current + 1) % _batches.size();
+    }
+}
+
+JsonLinesReader::JsonLinesReader(std::istream& in, unsigned threads)
+    : _impl(new JsonLinesReaderImpl(in, threads))
+{
+}
+
+JsonLinesReader::~JsonLinesReader()
+{
+    delete _impl;
+}
+
+const SerializationInfo* JsonLinesReader::next()
+{
+    return _impl->next();
+}
+
+unsigned JsonLinesReader::lineNumber() const
+{
+    return _impl->lineNumber();
+}
+
+}
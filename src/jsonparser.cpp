@@ -31,6 +31,7 @@
 #include <cxxtools/serializationerror.h>
 #include <cxxtools/utf8codec.h>
 #include <cxxtools/log.h>
+#include <cxxtools/convert.h>
 #include <cctype>
 
 log_define("cxxtools.json.parser")
@@ -126,7 +127,7 @@ int JsonParser::advance(Char ch)
             }
             else if ((ch >= '0' && ch <= '9') || ch == '+' || ch == '-')
             {
-                _token = ch;
+                _number = ch.narrow();
                 _state = state_number;
                 _deserializer->setCategory(SerializationInfo::Value);
             }
@@ -300,27 +301,21 @@ int JsonParser::advance(Char ch)
         case state_number:
             if (std::isspace(ch.value()))
             {
-                log_debug("set int value \"" << _token << '"');
-                _deserializer->setValue(_token);
-                _deserializer->setTypeName("int");
-                _token.clear();
+                setIntValue();
                 return 1;
             }
             else if (ch == '.' || ch == 'e' || ch == 'E')
             {
-                _token += ch;
+                _number += ch.narrow();
                 _state = state_float;
             }
             else if (ch >= '0' && ch <= '9')
             {
-                _token += ch;
+                _number += ch.narrow();
             }
             else
             {
-                log_debug("set int value \"" << _token << '"');
-                _deserializer->setValue(_token);
-                _deserializer->setTypeName("int");
-                _token.clear();
+                setIntValue();
                 return -1;
             }
             break;
@@ -328,21 +323,15 @@ int JsonParser::advance(Char ch)
         case state_float:
             if (std::isspace(ch.value()))
             {
-                log_debug("set double value \"" << _token << '"');
-                _deserializer->setValue(_token);
-                _deserializer->setTypeName("double");
-                _token.clear();
+                setFloatValue();
                 return 1;
             }
             else if ((ch >= '0' && ch <= '9') || ch == '+' || ch == '-'
                     || ch == '.' || ch == 'e' || ch == 'E')
-                _token += ch;
+                _number += ch.narrow();
             else
             {
-                log_debug("set double value \"" << _token << '"');
-                _deserializer->setValue(_token);
-                _deserializer->setTypeName("double");
-                _token.clear();
+                setFloatValue();
                 return -1;
             }
             break;
@@ -437,15 +426,11 @@ void JsonParser::finish()
             SerializationError::doThrow("unexpected end");
 
         case state_number:
-            _deserializer->setValue(_token);
-            _deserializer->setTypeName("int");
-            _token.clear();
+            setIntValue();
             break;
 
         case state_float:
-            _deserializer->setValue(_token);
-            _deserializer->setTypeName("double");
-            _token.clear();
+            setFloatValue();
             break;
 
         case state_token:
@@ -469,4 +454,42 @@ void JsonParser::finish()
     }
 }
 
+void JsonParser::setIntValue()
+{
+    log_debug("set int value \"" << _number << '"');
+
+    const char* b = _number.data();
+    const char* e = b + _number.size();
+    bool ok = false;
+
+    DeserializerBase::int_type i;
+    if (getInt(b, e, ok, i) == e && ok)
+    {
+        _deserializer->setValue(i);
+    }
+    else
+    {
+        DeserializerBase::unsigned_type u;
+        if (getInt(b, e, ok, u) == e && ok)
+            _deserializer->setValue(u);
+        else
+            _deserializer->setValue(_number);  // out of range; keep the text
+    }
+
+    _deserializer->setTypeName("int");
+    _number.clear();
+}
+
+void JsonParser::setFloatValue()
+{
+    log_debug("set double value \"" << _number << '"');
+
+    // The text is kept, so that the value is converted with the precision
+    // of the target type. Parsing it to a double here would lose digits
+    // for long double.
+    _deserializer->setValue(_number);
+    _deserializer->setTypeName("double");
+    _number.clear();
+}
+
 }
@@ -0,0 +1,635 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cxxtools/jsonreader.h>
+#include "jsonutf8.h"
+#include <cxxtools/serializationerror.h>
+#include <cxxtools/conversionerror.h>
+#include <cxxtools/utf8codec.h>
+#include <cxxtools/convert.h>
+#include <cxxtools/log.h>
+#include <istream>
+#include <string.h>
+
+log_define("cxxtools.json.reader")
+
+namespace cxxtools
+{
+
+namespace
+{
+    using jsonutf8::isWhitespace;
+
+    void throwUnexpectedEnd()
+    {
+        SerializationError::doThrow("unexpected end");
+    }
+
+    void throwInvalidCharacter(char ch)
+    {
+        SerializationError::doThrow(std::string("invalid character '") + ch + '\'');
+    }
+
+    bool isNumberChar(char ch)
+    {
+        return (ch >= '0' && ch <= '9') || ch == '-' || ch == '+'
+            || ch == '.' || ch == 'e' || ch == 'E';
+    }
+
+    bool isFloatText(const char* p, std::size_t size)
+    {
+        for (std::size_t n = 0; n < size; ++n)
+            if (p[n] == '.' || p[n] == 'e' || p[n] == 'E')
+                return true;
+        return false;
+    }
+}
+
+JsonReader::JsonReader(std::istream& in, std::size_t bufferSize)
+    : _in(in),
+      _buffer(bufferSize > 16 ? bufferSize : 16),
+      _begin(0),
+      _end(0),
+      _token(0),
+      _tokenSize(0),
+      _nonAscii(false),
+      _eof(false),
+      _state(state_value),
+      _event(None)
+{
+}
+
+// Moves the unprocessed data to the start of the buffer and appends
+// what the stream has available. Data starting at _begin is kept, so
+// positions relative to _begin stay valid.
+bool JsonReader::fill()
+{
+    if (_eof)
+        return false;
+
+    if (_begin > 0)
+    {
+        if (_end > _begin)
+            memmove(&_buffer[0], &_buffer[_begin], _end - _begin);
+        _end -= _begin;
+        _begin = 0;
+    }
+
+    if (_end == _buffer.size())
+        _buffer.resize(_buffer.size() * 2);
+
+    std::streambuf* sb = _in.rdbuf();
+    if (sb == 0 || sb->sgetc() == std::streambuf::traits_type::eof())
+    {
+        log_debug("end of input");
+        _eof = true;
+        return false;
+    }
+
+    // read what is available without blocking once more
+    std::streamsize n = sb->in_avail();
+    std::streamsize space = static_cast<std::streamsize>(_buffer.size() - _end);
+    if (n <= 0)
+        n = 1;
+    else if (n > space)
+        n = space;
+
+    n = sb->sgetn(&_buffer[_end], n);
+    log_debug(n << " bytes read");
+    _end += n;
+    return n > 0;
+}
+
+// Makes sure, that at least n bytes are available at _begin.
+bool JsonReader::available(std::size_t n)
+{
+    while (_end - _begin < n)
+        if (!fill())
+            return false;
+    return true;
+}
+
+void JsonReader::skipWhitespace()
+{
+    while (available(1))
+    {
+        char ch = _buffer[_begin];
+        if (isWhitespace(ch))
+            ++_begin;
+        else if (ch == '/')
+        {
+            if (!available(2))
+                throwUnexpectedEnd();
+
+            if (_buffer[_begin + 1] == '/')
+            {
+                _begin += 2;
+                while (true)
+                {
+                    const char* b = &_buffer[0];
+                    const char* e = static_cast<const char*>(memchr(b + _begin, '\n', _end - _begin));
+                    if (e)
+                    {
+                        _begin = e - b + 1;
+                        break;
+                    }
+
+                    _begin = _end;
+                    if (!fill())
+                        return;
+                }
+            }
+            else if (_buffer[_begin + 1] == '*')
+            {
+                _begin += 2;
+                while (true)
+                {
+                    if (!available(2))
+                        throwUnexpectedEnd();
+                    if (_buffer[_begin] == '*' && _buffer[_begin + 1] == '/')
+                        break;
+                    ++_begin;
+                }
+
+                _begin += 2;
+            }
+            else
+                throwInvalidCharacter(_buffer[_begin + 1]);
+        }
+        else
+            break;
+    }
+}
+
+// Reads the string at _begin, which starts with a quote, into the token.
+// The string is collected in the buffer and unescaped in place.
+void JsonReader::readString()
+{
+    _nonAscii = false;
+
+    bool escaped = false;
+    std::size_t off = 1;
+    while (true)
+    {
+        if (!available(off + 1))
+            throwUnexpectedEnd();
+
+        const char* b = &_buffer[0];
+        const char* p = jsonutf8::findStringSpecial(b + _begin + off, b + _end, _nonAscii);
+        off = p - b - _begin;
+        if (p == b + _end)
+            continue;
+
+        if (*p == '"')
+            break;
+
+        // skip the escaped character; the rest of the sequence contains no specials
+        escaped = true;
+        off += 2;
+    }
+
+    char* s = &_buffer[_begin + 1];
+    const char* e = &_buffer[_begin + off];
+    _token = _begin + 1;
+
+    if (escaped)
+    {
+        const char* p = static_cast<const char*>(memchr(s, '\\', e - s));
+        char* out = const_cast<char*>(p);
+        while (p != e)
+        {
+            if (*p == '\\')
+                p = jsonutf8::unescape(p + 1, e, out, _nonAscii);
+            else
+                *out++ = *p++;
+        }
+
+        _tokenSize = out - s;
+    }
+    else
+        _tokenSize = e - s;
+
+    _begin += off + 1;
+}
+
+void JsonReader::readNumber()
+{
+    std::size_t off = 1;
+    while (available(off + 1) && isNumberChar(_buffer[_begin + off]))
+        ++off;
+
+    _token = _begin;
+    _tokenSize = off;
+    _begin += off;
+}
+
+void JsonReader::readToken()
+{
+    std::size_t off = 1;
+    while (available(off + 1) && std::isalpha(static_cast<unsigned char>(_buffer[_begin + off])))
+        ++off;
+
+    _token = _begin;
+    _tokenSize = off;
+    _begin += off;
+
+    if (jsonutf8::isTokenEqual(data(), _tokenSize, "true")
+        || jsonutf8::isTokenEqual(data(), _tokenSize, "false"))
+        _event = BoolValue;
+    else if (jsonutf8::isTokenEqual(data(), _tokenSize, "null"))
+        _event = NullValue;
+    else
+        SerializationError::doThrow("invalid token \"" + str() + '"');
+}
+
+JsonReader::Event JsonReader::next()
+{
+    _tokenSize = 0;
+
+    while (true)
+    {
+        switch (_state)
+        {
+            case state_after_value:
+                if (_stack.empty())
+                {
+                    // end of a top level value; the next one may follow
+                    _state = state_value;
+                    break;
+                }
+
+                skipWhitespace();
+                if (!available(1))
+                    throwUnexpectedEnd();
+
+                if (_buffer[_begin] == ',')
+                {
+                    ++_begin;
+                    _state = _stack.back() == '{' ? state_key : state_value;
+                }
+                else if (_buffer[_begin] == '}' && _stack.back() == '{')
+                {
+                    ++_begin;
+                    _stack.pop_back();
+                    return _event = EndObject;
+                }
+                else if (_buffer[_begin] == ']' && _stack.back() == '[')
+                {
+                    ++_begin;
+                    _stack.pop_back();
+                    return _event = EndArray;
+                }
+                else
+                    throwInvalidCharacter(_buffer[_begin]);
+                break;
+
+            case state_first_key:
+                skipWhitespace();
+                if (!available(1))
+                    throwUnexpectedEnd();
+
+                if (_buffer[_begin] == '}')
+                {
+                    ++_begin;
+                    _stack.pop_back();
+                    _state = state_after_value;
+                    return _event = EndObject;
+                }
+
+                _state = state_key;
+                break;
+
+            case state_key:
+                skipWhitespace();
+                if (!available(1))
+                    throwUnexpectedEnd();
+                if (_buffer[_begin] != '"')
+                    throwInvalidCharacter(_buffer[_begin]);
+
+                readString();
+                _state = state_colon;
+                return _event = Key;
+
+            case state_colon:
+                skipWhitespace();
+                if (!available(1))
+                    throwUnexpectedEnd();
+                if (_buffer[_begin] != ':')
+                    throwInvalidCharacter(_buffer[_begin]);
+
+                ++_begin;
+                _state = state_value;
+                break;
+
+            case state_first_value:
+                skipWhitespace();
+                if (!available(1))
+                    throwUnexpectedEnd();
+
+                if (_buffer[_begin] == ']')
+                {
+                    ++_begin;
+                    _stack.pop_back();
+                    _state = state_after_value;
+                    return _event = EndArray;
+                }
+
+                _state = state_value;
+                break;
+
+            case state_value:
+            {
+                skipWhitespace();
+                if (!available(1))
+                {
+                    if (!_stack.empty())
+                        throwUnexpectedEnd();
+                    return _event = End;
+                }
+
+                char ch = _buffer[_begin];
+                if (ch == '{')
+                {
+                    ++_begin;
+                    _stack.push_back('{');
+                    _state = state_first_key;
+                    return _event = BeginObject;
+                }
+                else if (ch == '[')
+                {
+                    ++_begin;
+                    _stack.push_back('[');
+                    _state = state_first_value;
+                    return _event = BeginArray;
+                }
+
+                _state = state_after_value;
+
+                if (ch == '"')
+                {
+                    readString();
+                    return _event = StringValue;
+                }
+                else if (ch == '-' || (ch >= '0' && ch <= '9'))
+                {
+                    readNumber();
+                    return _event = NumberValue;
+                }
+                else if (std::isalpha(static_cast<unsigned char>(ch)))
+                {
+                    readToken();
+                    return _event;
+                }
+
+                throwInvalidCharacter(ch);
+            }
+        }
+    }
+}
+
+void JsonReader::skipString()
+{
+    ++_begin;
+    while (true)
+    {
+        const char* b = &_buffer[0];
+        const char* p = jsonutf8::findStringSpecial(b + _begin, b + _end, _nonAscii);
+        _begin = p - b;
+        if (_begin == _end)
+        {
+            if (!fill())
+                throwUnexpectedEnd();
+        }
+        else if (*p == '"')
+        {
+            ++_begin;
+            return;
+        }
+        else
+        {
+            if (!available(2))
+                throwUnexpectedEnd();
+            _begin += 2;
+        }
+    }
+}
+
+// Skips the content of the current object or array up to its end by
+// scanning the bytes for brackets. No tokens are built.
+void JsonReader::skipContainer()
+{
+    unsigned level = 1;
+    while (true)
+    {
+        if (!available(1))
+            throwUnexpectedEnd();
+
+        switch (_buffer[_begin])
+        {
+            case '"':
+                skipString();
+                break;
+
+            case '/':
+                skipWhitespace();
+                break;
+
+            case '{':
+            case '[':
+                ++level;
+                ++_begin;
+                break;
+
+            case '}':
+            case ']':
+                ++_begin;
+                if (--level == 0)
+                {
+                    _event = _stack.back() == '{' ? EndObject : EndArray;
+                    _stack.pop_back();
+                    _state = state_after_value;
+                    return;
+                }
+                break;
+
+            default:
+                ++_begin;
+        }
+    }
+}
+
+void JsonReader::skip()
+{
+    switch (_event)
+    {
+        case Key:
+            next();
+            if (_event == BeginObject || _event == BeginArray)
+                skipContainer();
+            _tokenSize = 0;
+            break;
+
+        case BeginObject:
+        case BeginArray:
+            skipContainer();
+            break;
+
+        default:
+            break;
+    }
+}
+
+String JsonReader::toString() const
+{
+    return Utf8Codec::decode(data(), size());
+}
+
+bool JsonReader::toBool() const
+{
+    if (_event == BoolValue)
+        return _tokenSize == 4;  // true
+
+    bool ret;
+    convert(ret, str());
+    return ret;
+}
+
+JsonReader::int_type JsonReader::toInt() const
+{
+    bool ok = false;
+    int_type ret;
+    if (getInt(data(), data() + size(), ok, ret) != data() + size() || !ok)
+        ConversionError::doThrow("int", "json", str().c_str());
+    return ret;
+}
+
+JsonReader::unsigned_type JsonReader::toUnsigned() const
+{
+    bool ok = false;
+    unsigned_type ret;
+    if (getInt(data(), data() + size(), ok, ret) != data() + size() || !ok)
+        ConversionError::doThrow("unsigned", "json", str().c_str());
+    return ret;
+}
+
+double JsonReader::toDouble() const
+{
+    bool ok = false;
+    double ret;
+    if (getFloat(data(), data() + size(), ok, ret) != data() + size() || !ok)
+        ConversionError::doThrow("double", "json", str().c_str());
+    return ret;
+}
+
+void JsonReader::get(SerializationInfo& si)
+{
+    if (_event == Key)
+    {
+        si.setName(str());
+        next();
+    }
+
+    getValue(si);
+}
+
+void JsonReader::getValue(SerializationInfo& si)
+{
+    switch (_event)
+    {
+        case BeginObject:
+            si.setCategory(SerializationInfo::Object);
+            while (next() != EndObject)
+            {
+                SerializationInfo& member = si.addMember(str());
+                next();
+                getValue(member);
+            }
+            break;
+
+        case BeginArray:
+            si.setCategory(SerializationInfo::Array);
+            while (next() != EndArray)
+                getValue(si.addMember(std::string()));
+            break;
+
+        case StringValue:
+            si.setCategory(SerializationInfo::Value);
+            if (_nonAscii)
+                si.setValue(toString());
+            else
+                si.setValue(data(), size());
+            si.setTypeName("string");
+            break;
+
+        case NumberValue:
+        {
+            si.setCategory(SerializationInfo::Value);
+            const char* b = data();
+            const char* e = b + size();
+            bool ok = false;
+            if (isFloatText(b, size()))
+            {
+                double d;
+                if (getFloat(b, e, ok, d) == e && ok)
+                    si.setValue(d);
+                else
+                    si.setValue(b, size());
+                si.setTypeName("double");
+            }
+            else
+            {
+                int_type i;
+                unsigned_type u;
+                if (getInt(b, e, ok, i) == e && ok)
+                    si.setValue(i);
+                else if (getInt(b, e, ok, u) == e && ok)
+                    si.setValue(u);
+                else
+                    si.setValue(b, size());
+                si.setTypeName("int");
+            }
+            break;
+        }
+
+        case BoolValue:
+            si.setCategory(SerializationInfo::Value);
+            si.setValue(toBool());
+            si.setTypeName("bool");
+            break;
+
+        case NullValue:
+            si.setTypeName("null");
+            si.setNull();
+            break;
+
+        default:
+            SerializationError::doThrow("no json value to read");
+    }
+}
+
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CXXTOOLS_JSONUTF8_H
+#define CXXTOOLS_JSONUTF8_H
+
+#include <cctype>
+#include <cstddef>
+
+namespace cxxtools
+{
+
+// Helpers of the json parsers, which work on utf-8 encoded bytes.
+namespace jsonutf8
+{
+    inline bool isWhitespace(char ch)
+    {
+        return std::isspace(static_cast<unsigned char>(ch));
+    }
+
+    /// Returns the position of the first quote or backslash in [p, end).
+    /// Sets nonAscii, when there is a byte with the high bit set before.
+    const char* findStringSpecial(const char* p, const char* end, bool& nonAscii);
+
+    /// Decodes the escape sequence at p, which is the character after the
+    /// backslash, and writes the utf-8 encoded result to out. Returns the
+    /// position after the sequence. The output is always shorter than the
+    /// input, so the decoding may happen in place.
+    const char* unescape(const char* p, const char* end, char*& out, bool& nonAscii);
+
+    /// Compares case insensitive with a lower case token.
+    bool isTokenEqual(const char* p, std::size_t len, const char* token);
+}
+
+}
+
+#endif // CXXTOOLS_JSONUTF8_H
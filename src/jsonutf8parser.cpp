@@ -0,0 +1,695 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <cxxtools/jsonutf8parser.h>
+#include "jsonutf8.h"
+#include <cxxtools/deserializerbase.h>
+#include <cxxtools/formatter.h>
+#include <cxxtools/serializationerror.h>
+#include <cxxtools/utf8codec.h>
+#include <cxxtools/convert.h>
+#include <cxxtools/log.h>
+#include <cctype>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define CXXTOOLS_JSON_SSE2
+#endif
+
+log_define("cxxtools.json.utf8parser")
+
+namespace cxxtools
+{
+
+namespace jsonutf8
+{
+
+namespace
+{
+    void throwUnexpectedEnd()
+    {
+        SerializationError::doThrow("unexpected end");
+    }
+
+    const char* parseHex4(const char* p, const char* end, uint32_t& value)
+    {
+        if (end - p < 4)
+            throwUnexpectedEnd();
+
+        value = 0;
+        for (unsigned n = 0; n < 4; ++n, ++p)
+        {
+            char ch = *p;
+            if (ch >= '0' && ch <= '9')
+                value = (value << 4) | (ch - '0');
+            else if (ch >= 'a' && ch <= 'f')
+                value = (value << 4) | (ch - 'a' + 10);
+            else if (ch >= 'A' && ch <= 'F')
+                value = (value << 4) | (ch - 'A' + 10);
+            else
+                SerializationError::doThrow(std::string("invalid character '") + ch + "' in hex sequence");
+        }
+
+        return p;
+    }
+
+    char* putUtf8(char* out, uint32_t ch)
+    {
+        if (ch < 0x80)
+            *out++ = static_cast<char>(ch);
+        else if (ch < 0x800)
+        {
+            *out++ = static_cast<char>(0xC0 | (ch >> 6));
+            *out++ = static_cast<char>(0x80 | (ch & 0x3F));
+        }
+        else if (ch < 0x10000)
+        {
+            *out++ = static_cast<char>(0xE0 | (ch >> 12));
+            *out++ = static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (ch & 0x3F));
+        }
+        else
+        {
+            *out++ = static_cast<char>(0xF0 | (ch >> 18));
+            *out++ = static_cast<char>(0x80 | ((ch >> 12) & 0x3F));
+            *out++ = static_cast<char>(0x80 | ((ch >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (ch & 0x3F));
+        }
+
+        return out;
+    }
+}
+
+const char* findStringSpecial(const char* p, const char* end, bool& nonAscii)
+{
+#ifdef CXXTOOLS_JSON_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while (end - p >= 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int special = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                                     _mm_cmpeq_epi8(v, backslash)));
+        int high = _mm_movemask_epi8(v);
+        if (special != 0)
+        {
+            int idx = __builtin_ctz(special);
+            if (high & ((1 << idx) - 1))
+                nonAscii = true;
+            return p + idx;
+        }
+
+        if (high)
+            nonAscii = true;
+        p += 16;
+    }
+#else
+    // 8 bytes at a time: a byte is zero after xor with the searched
+    // character; (x - 0x01..) & ~x & 0x80.. detects zero bytes
+    const uint64_t ones = 0x0101010101010101ull;
+    const uint64_t highs = 0x8080808080808080ull;
+    while (end - p >= 8)
+    {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        uint64_t q = v ^ (ones * '"');
+        uint64_t b = v ^ (ones * '\\');
+        if ((((q - ones) & ~q) | ((b - ones) & ~b)) & highs)
+            break;
+
+        if (v & highs)
+            nonAscii = true;
+        p += 8;
+    }
+#endif
+
+    for ( ; p != end; ++p)
+    {
+        if (*p == '"' || *p == '\\')
+            break;
+        if (*p & 0x80)
+            nonAscii = true;
+    }
+
+    return p;
+}
+
+const char* unescape(const char* p, const char* end, char*& out, bool& nonAscii)
+{
+    if (p == end)
+        throwUnexpectedEnd();
+
+    switch (*p)
+    {
+        case '"':
+        case '\\':
+        case '/': *out++ = *p; break;
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'r': *out++ = '\r'; break;
+        case 't': *out++ = '\t'; break;
+
+        case 'u':
+        {
+            uint32_t ch;
+            p = parseHex4(p + 1, end, ch);
+
+            // surrogate pair
+            if (ch >= 0xD800 && ch < 0xDC00
+                && end - p >= 6 && p[0] == '\\' && p[1] == 'u')
+            {
+                uint32_t low;
+                const char* pp = parseHex4(p + 2, end, low);
+                if (low >= 0xDC00 && low < 0xE000)
+                {
+                    ch = 0x10000 + ((ch - 0xD800) << 10) + (low - 0xDC00);
+                    p = pp;
+                }
+            }
+
+            if (ch >= 0x80)
+                nonAscii = true;
+            out = putUtf8(out, ch);
+            return p;
+        }
+
+        default:
+            SerializationError::doThrow(std::string("invalid character '") + *p + "' in string");
+    }
+
+    return p + 1;
+}
+
+bool isTokenEqual(const char* p, std::size_t len, const char* token)
+{
+    if (len != strlen(token))
+        return false;
+
+    for (std::size_t n = 0; n < len; ++n)
+        if (std::tolower(static_cast<unsigned char>(p[n])) != token[n])
+            return false;
+
+    return true;
+}
+
+}
+
+namespace
+{
+    using jsonutf8::isWhitespace;
+    using jsonutf8::findStringSpecial;
+    using jsonutf8::isTokenEqual;
+
+    const unsigned maxDepth = 1024;
+
+    void throwUnexpectedEnd()
+    {
+        SerializationError::doThrow("unexpected end");
+    }
+
+    void throwInvalidCharacter(char ch)
+    {
+        SerializationError::doThrow(std::string("invalid character '") + ch + '\'');
+    }
+
+    // Parses the string starting behind the opening quote. Without escape
+    // sequences the result points into the input, otherwise into buffer.
+    const char* parseString(const char* p, const char* end, std::string& buffer,
+        const char*& data, std::size_t& size, bool& nonAscii)
+    {
+        nonAscii = false;
+
+        const char* s = p;
+        p = findStringSpecial(p, end, nonAscii);
+        if (p == end)
+            throwUnexpectedEnd();
+
+        if (*p == '"')
+        {
+            data = s;
+            size = p - s;
+            return p + 1;
+        }
+
+        buffer.assign(s, p);
+
+        while (true)
+        {
+            // *p is a backslash
+            char tmp[4];
+            char* out = tmp;
+            p = jsonutf8::unescape(p + 1, end, out, nonAscii);
+            buffer.append(tmp, out - tmp);
+
+            s = p;
+            p = findStringSpecial(p, end, nonAscii);
+            if (p == end)
+                throwUnexpectedEnd();
+
+            buffer.append(s, p);
+
+            if (*p == '"')
+            {
+                data = buffer.data();
+                size = buffer.size();
+                return p + 1;
+            }
+        }
+    }
+
+    // passes the values to a DeserializerBase
+    class DeserializerHandler
+    {
+            DeserializerBase& _deserializer;
+
+        public:
+            explicit DeserializerHandler(DeserializerBase& deserializer)
+                : _deserializer(deserializer)
+            { }
+
+            void beginObject(const std::string&)
+            { _deserializer.setCategory(SerializationInfo::Object); }
+
+            void beginMember(const std::string& name)
+            { _deserializer.beginMember(name, std::string(), SerializationInfo::Void); }
+
+            void finishMember()
+            { _deserializer.leaveMember(); }
+
+            void finishObject()
+            { }
+
+            void beginArray(const std::string&)
+            { _deserializer.setCategory(SerializationInfo::Array); }
+
+            void beginElement()
+            { _deserializer.beginMember(std::string(), std::string(), SerializationInfo::Void); }
+
+            void finishElement()
+            { _deserializer.leaveMember(); }
+
+            void finishArray()
+            { }
+
+            void stringValue(const std::string&, const char* data, std::size_t size, bool nonAscii)
+            {
+                _deserializer.setCategory(SerializationInfo::Value);
+                if (nonAscii)
+                    _deserializer.setValue(Utf8Codec::decode(data, size));
+                else
+                    _deserializer.setValue(data, size);
+                _deserializer.setTypeName("string");
+            }
+
+            void intValue(const std::string&, DeserializerBase::int_type value)
+            {
+                _deserializer.setCategory(SerializationInfo::Value);
+                _deserializer.setValue(value);
+                _deserializer.setTypeName("int");
+            }
+
+            void unsignedValue(const std::string&, DeserializerBase::unsigned_type value)
+            {
+                _deserializer.setCategory(SerializationInfo::Value);
+                _deserializer.setValue(value);
+                _deserializer.setTypeName("int");
+            }
+
+            void numberText(const std::string&, const std::string& type, const char* data, std::size_t size)
+            {
+                _deserializer.setCategory(SerializationInfo::Value);
+                _deserializer.setValue(data, size);
+                _deserializer.setTypeName(type);
+            }
+
+            void boolValue(const std::string&, bool value)
+            {
+                _deserializer.setCategory(SerializationInfo::Value);
+                _deserializer.setValue(value);
+                _deserializer.setTypeName("bool");
+            }
+
+            void nullValue(const std::string&)
+            {
+                _deserializer.setTypeName("null");
+                _deserializer.setNull();
+            }
+    };
+
+    // passes the values as events to a Formatter
+    class FormatterHandler
+    {
+            Formatter& _formatter;
+
+        public:
+            explicit FormatterHandler(Formatter& formatter)
+                : _formatter(formatter)
+            { }
+
+            void beginObject(const std::string& name)
+            { _formatter.beginObject(name, std::string()); }
+
+            void beginMember(const std::string& name)
+            { _formatter.beginMember(name); }
+
+            void finishMember()
+            { _formatter.finishMember(); }
+
+            void finishObject()
+            { _formatter.finishObject(); }
+
+            void beginArray(const std::string& name)
+            { _formatter.beginArray(name, std::string()); }
+
+            void beginElement()
+            { }
+
+            void finishElement()
+            { }
+
+            void finishArray()
+            { _formatter.finishArray(); }
+
+            void stringValue(const std::string& name, const char* data, std::size_t size, bool nonAscii)
+            {
+                if (nonAscii)
+                    _formatter.addValueString(name, "string", Utf8Codec::decode(data, size));
+                else
+                    _formatter.addValueStdString(name, "string", std::string(data, size));
+            }
+
+            void intValue(const std::string& name, Formatter::int_type value)
+            { _formatter.addValueInt(name, "int", value); }
+
+            void unsignedValue(const std::string& name, Formatter::unsigned_type value)
+            { _formatter.addValueUnsigned(name, "int", value); }
+
+            void numberText(const std::string& name, const std::string& type, const char* data, std::size_t size)
+            { _formatter.addValueStdString(name, type, std::string(data, size)); }
+
+            void boolValue(const std::string& name, bool value)
+            { _formatter.addValueBool(name, "bool", value); }
+
+            void nullValue(const std::string& name)
+            { _formatter.addNull(name, "null"); }
+    };
+}
+
+template <typename HandlerType>
+class JsonUtf8ParserImpl
+{
+        JsonUtf8Parser& _parser;
+        HandlerType& _handler;
+        const char* _end;
+        unsigned _depth;   // nesting of objects and arrays in this parse run
+
+        const char* parseObject(const char* p, const std::string& name);
+        const char* parseArray(const char* p, const std::string& name);
+        const char* parseNumber(const char* p, const std::string& name);
+        const char* parseToken(const char* p, const std::string& name);
+
+        const char* skipWhitespace(const char* p)
+        {
+            return JsonUtf8Parser::skipWhitespace(p, _end);
+        }
+
+    public:
+        JsonUtf8ParserImpl(JsonUtf8Parser& parser, HandlerType& handler, const char* end)
+            : _parser(parser),
+              _handler(handler),
+              _end(end),
+              _depth(0)
+        { }
+
+        const char* parseValue(const char* p, const std::string& name);
+};
+
+template <typename HandlerType>
+const char* JsonUtf8ParserImpl<HandlerType>::parseValue(const char* p, const std::string& name)
+{
+    p = skipWhitespace(p);
+    if (p == _end)
+        throwUnexpectedEnd();
+
+    char ch = *p;
+    if (ch == '{')
+        return parseObject(p + 1, name);
+    else if (ch == '[')
+        return parseArray(p + 1, name);
+    else if (ch == '"')
+    {
+        const char* data;
+        std::size_t size;
+        bool nonAscii;
+        p = parseString(p + 1, _end, _parser._buffer, data, size, nonAscii);
+        log_debug("set string value \"" << std::string(data, size) << '"');
+        _handler.stringValue(name, data, size, nonAscii);
+        return p;
+    }
+    else if ((ch >= '0' && ch <= '9') || ch == '+' || ch == '-')
+        return parseNumber(p, name);
+    else
+        return parseToken(p, name);
+}
+
+template <typename HandlerType>
+const char* JsonUtf8ParserImpl<HandlerType>::parseObject(const char* p, const std::string& name)
+{
+    if (++_depth > maxDepth)
+        SerializationError::doThrow("json structure nested too deep");
+
+    _handler.beginObject(name);
+
+    p = skipWhitespace(p);
+    if (p == _end)
+        throwUnexpectedEnd();
+
+    if (*p != '}')
+    {
+        std::string memberName;
+        while (true)
+        {
+            if (*p != '"')
+                throwInvalidCharacter(*p);
+
+            const char* data;
+            std::size_t size;
+            bool nonAscii;
+            p = parseString(p + 1, _end, _parser._buffer, data, size, nonAscii);
+            memberName.assign(data, size);
+
+            p = skipWhitespace(p);
+            if (p == _end)
+                throwUnexpectedEnd();
+            if (*p != ':')
+                throwInvalidCharacter(*p);
+
+            log_debug("begin object member " << memberName);
+            _handler.beginMember(memberName);
+            p = parseValue(p + 1, memberName);
+            log_debug("leave member");
+            _handler.finishMember();
+
+            p = skipWhitespace(p);
+            if (p == _end)
+                throwUnexpectedEnd();
+
+            if (*p == '}')
+                break;
+            if (*p != ',')
+                throwInvalidCharacter(*p);
+
+            p = skipWhitespace(p + 1);
+            if (p == _end)
+                throwUnexpectedEnd();
+        }
+    }
+
+    _handler.finishObject();
+    --_depth;
+    return p + 1;
+}
+
+template <typename HandlerType>
+const char* JsonUtf8ParserImpl<HandlerType>::parseArray(const char* p, const std::string& name)
+{
+    if (++_depth > maxDepth)
+        SerializationError::doThrow("json structure nested too deep");
+
+    _handler.beginArray(name);
+
+    p = skipWhitespace(p);
+    if (p == _end)
+        throwUnexpectedEnd();
+
+    if (*p != ']')
+    {
+        const std::string noName;
+        while (true)
+        {
+            log_debug("begin array member");
+            _handler.beginElement();
+            p = parseValue(p, noName);
+            log_debug("leave member");
+            _handler.finishElement();
+
+            p = skipWhitespace(p);
+            if (p == _end)
+                throwUnexpectedEnd();
+
+            if (*p == ']')
+                break;
+            if (*p != ',')
+                throwInvalidCharacter(*p);
+            ++p;
+        }
+    }
+
+    _handler.finishArray();
+    --_depth;
+    return p + 1;
+}
+
+template <typename HandlerType>
+const char* JsonUtf8ParserImpl<HandlerType>::parseNumber(const char* p, const std::string& name)
+{
+    const char* b = p;
+    bool isFloat = false;
+    for (++p; p != _end; ++p)
+    {
+        char ch = *p;
+        if (ch == '.' || ch == 'e' || ch == 'E')
+            isFloat = true;
+        else if (!(ch >= '0' && ch <= '9') && !(isFloat && (ch == '+' || ch == '-')))
+            break;
+    }
+
+    if (isFloat)
+    {
+        // The text is kept, so that the value is converted with the
+        // precision of the target type.
+        log_debug("set double value \"" << std::string(b, p) << '"');
+        _handler.numberText(name, "double", b, p - b);
+    }
+    else
+    {
+        bool ok = false;
+
+        log_debug("set int value \"" << std::string(b, p) << '"');
+        DeserializerBase::int_type i;
+        DeserializerBase::unsigned_type u;
+        if (getInt(b, p, ok, i) == p && ok)
+            _handler.intValue(name, i);
+        else if (getInt(b, p, ok, u) == p && ok)
+            _handler.unsignedValue(name, u);
+        else
+            _handler.numberText(name, "int", b, p - b);  // out of range; keep the text
+    }
+
+    return p;
+}
+
+template <typename HandlerType>
+const char* JsonUtf8ParserImpl<HandlerType>::parseToken(const char* p, const std::string& name)
+{
+    const char* b = p;
+    while (p != _end && std::isalpha(static_cast<unsigned char>(*p)))
+        ++p;
+
+    if (p == b)
+        throwInvalidCharacter(*p);
+
+    if (isTokenEqual(b, p - b, "true"))
+        _handler.boolValue(name, true);
+    else if (isTokenEqual(b, p - b, "false"))
+        _handler.boolValue(name, false);
+    else if (isTokenEqual(b, p - b, "null"))
+        _handler.nullValue(name);
+    else
+        SerializationError::doThrow("invalid token \"" + std::string(b, p) + '"');
+
+    return p;
+}
+
+const char* JsonUtf8Parser::skipWhitespace(const char* p, const char* end)
+{
+    while (p != end)
+    {
+        if (isWhitespace(*p))
+            ++p;
+        else if (*p == '/')
+        {
+            if (++p == end)
+                throwUnexpectedEnd();
+
+            if (*p == '/')
+            {
+                const char* e = static_cast<const char*>(memchr(p, '\n', end - p));
+                p = (e == 0 ? end : e + 1);
+            }
+            else if (*p == '*')
+            {
+                for (++p; ; ++p)
+                {
+                    if (end - p < 2)
+                        throwUnexpectedEnd();
+                    if (p[0] == '*' && p[1] == '/')
+                        break;
+                }
+
+                p += 2;
+            }
+            else
+                throwInvalidCharacter(*p);
+        }
+        else
+            break;
+    }
+
+    return p;
+}
+
+const char* JsonUtf8Parser::parse(const char* begin, const char* end, DeserializerBase& deserializer)
+{
+    DeserializerHandler handler(deserializer);
+    JsonUtf8ParserImpl<DeserializerHandler> impl(*this, handler, end);
+    return impl.parseValue(begin, std::string());
+}
+
+const char* JsonUtf8Parser::parse(const char* begin, const char* end, Formatter& formatter)
+{
+    FormatterHandler handler(formatter);
+    JsonUtf8ParserImpl<FormatterHandler> impl(*this, handler, end);
+    return impl.parseValue(begin, std::string());
+}
+
+}
@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <cxxtools/loadbalancer.h>
+#include <cxxtools/remoteclient.h>
+#include <cxxtools/clock.h>
+#include <cxxtools/mutex.h>
+#include <cxxtools/log.h>
+#include <stdexcept>
+#include <vector>
+
+log_define("cxxtools.loadbalancer")
+
+namespace cxxtools
+{
+
+class LoadBalancerImpl
+{
+    public:
+        struct Endpoint
+        {
+            std::string host;
+            unsigned short port;
+            unsigned outstanding;
+            std::size_t requests;
+            std::size_t failures;
+            unsigned consecutiveFailures;
+            bool ejected;
+            Timespan ejectedUntil;
+            double latency;   // moving average in milliseconds
+
+            std::vector<RemoteClient*> idle;
+            std::size_t connections;
+
+            Endpoint(const std::string& host_, unsigned short port_)
+                : host(host_),
+                  port(port_),
+                  outstanding(0),
+                  requests(0),
+                  failures(0),
+                  consecutiveFailures(0),
+                  ejected(false),
+                  latency(0),
+                  connections(0)
+            { }
+
+            // the expected cost of sending another request to the endpoint
+            double score() const
+            { return (outstanding + 1) * (latency + 1); }
+        };
+
+        typedef std::vector<Endpoint> Endpoints;
+
+        Endpoints endpoints;
+        unsigned failureThreshold;
+        std::size_t ejectTime;
+        std::size_t maxIdle;
+        uint32_t seed;
+        mutable Mutex mutex;
+
+        LoadBalancerImpl()
+            : failureThreshold(3),
+              ejectTime(10000),
+              maxIdle(16),
+              seed(0x2545f491)
+        { }
+
+        unsigned random(unsigned n)
+        {
+            // xorshift
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            return seed % n;
+        }
+
+        bool available(const Endpoint& e, const Timespan& now) const
+        {
+            // an ejected endpoint gets a single probe request, when the eject time is over
+            return !e.ejected || (e.ejectedUntil <= now && e.outstanding == 0);
+        }
+
+        unsigned select();
+};
+
+unsigned LoadBalancerImpl::select()
+{
+    Timespan now = Clock::getSystemTicks();
+
+    std::vector<unsigned> candidates;
+    candidates.reserve(endpoints.size());
+    for (unsigned n = 0; n < endpoints.size(); ++n)
+        if (available(endpoints[n], now))
+            candidates.push_back(n);
+
+    if (candidates.empty())
+    {
+        // all endpoints are ejected - try the one, which is ejected for the shortest time
+        unsigned best = 0;
+        for (unsigned n = 1; n < endpoints.size(); ++n)
+            if (endpoints[n].ejectedUntil < endpoints[best].ejectedUntil)
+                best = n;
+        return best;
+    }
+
+    if (candidates.size() == 1)
+        return candidates[0];
+
+    unsigned a = random(candidates.size());
+    unsigned b = random(candidates.size() - 1);
+    if (b >= a)
+        ++b;
+
+    a = candidates[a];
+    b = candidates[b];
+    return endpoints[b].score() < endpoints[a].score() ? b : a;
+}
+
+LoadBalancer::LoadBalancer()
+    : _impl(new LoadBalancerImpl())
+{
+}
+
+LoadBalancer::~LoadBalancer()
+{
+    for (LoadBalancerImpl::Endpoints::iterator it = _impl->endpoints.begin(); it != _impl->endpoints.end(); ++it)
+        for (unsigned n = 0; n < it->idle.size(); ++n)
+            delete it->idle[n];
+
+    delete _impl;
+}
+
+void LoadBalancer::addEndpoint(const std::string& host, unsigned short port)
+{
+    MutexLock lock(_impl->mutex);
+    _impl->endpoints.push_back(LoadBalancerImpl::Endpoint(host, port));
+}
+
+unsigned LoadBalancer::endpoints() const
+{
+    MutexLock lock(_impl->mutex);
+    return _impl->endpoints.size();
+}
+
+LoadBalancer::EndpointInfo LoadBalancer::endpointInfo(unsigned n) const
+{
+    MutexLock lock(_impl->mutex);
+
+    const LoadBalancerImpl::Endpoint& e = _impl->endpoints.at(n);
+
+    EndpointInfo info;
+    info.host = e.host;
+    info.port = e.port;
+    info.outstanding = e.outstanding;
+    info.requests = e.requests;
+    info.failures = e.failures;
+    info.connections = e.connections;
+    info.ejected = e.ejected;
+    info.latency = Timespan(static_cast<int64_t>(e.latency * 1000));
+    return info;
+}
+
+unsigned LoadBalancer::failureThreshold() const
+{
+    MutexLock lock(_impl->mutex);
+    return _impl->failureThreshold;
+}
+
+void LoadBalancer::failureThreshold(unsigned n)
+{
+    MutexLock lock(_impl->mutex);
+    _impl->failureThreshold = n;
+}
+
+std::size_t LoadBalancer::ejectTime() const
+{
+    MutexLock lock(_impl->mutex);
+    return _impl->ejectTime;
+}
+
+void LoadBalancer::ejectTime(std::size_t msecs)
+{
+    MutexLock lock(_impl->mutex);
+    _impl->ejectTime = msecs;
+}
+
+std::size_t LoadBalancer::maxIdle() const
+{
+    MutexLock lock(_impl->mutex);
+    return _impl->maxIdle;
+}
+
+void LoadBalancer::maxIdle(std::size_t n)
+{
+    MutexLock lock(_impl->mutex);
+    _impl->maxIdle = n;
+}
+
+RemoteClient* LoadBalancer::acquire(unsigned& endpoint)
+{
+    MutexLock lock(_impl->mutex);
+
+    if (_impl->endpoints.empty())
+        throw std::logic_error("no endpoints for load balancer");
+
+    endpoint = _impl->select();
+    LoadBalancerImpl::Endpoint& e = _impl->endpoints[endpoint];
+
+    log_debug("select endpoint " << e.host << ':' << e.port << " outstanding " << e.outstanding << " latency " << e.latency << " ms");
+
+    RemoteClient* client;
+    if (e.idle.empty())
+    {
+        client = createClient(e.host, e.port);
+        ++e.connections;
+        log_debug("new connection to " << e.host << ':' << e.port << "; " << e.connections << " connections");
+    }
+    else
+    {
+        client = e.idle.back();
+        e.idle.pop_back();
+    }
+
+    ++e.outstanding;
+    ++e.requests;
+
+    return client;
+}
+
+bool LoadBalancer::release(unsigned endpoint, RemoteClient* client, const Timespan& latency, bool failed)
+{
+    MutexLock lock(_impl->mutex);
+
+    LoadBalancerImpl::Endpoint& e = _impl->endpoints[endpoint];
+
+    --e.outstanding;
+
+    // A failed connection is in an unknown state and is not reused.
+    bool keep = !failed && e.idle.size() < _impl->maxIdle;
+    if (keep)
+    {
+        e.idle.push_back(client);
+    }
+    else
+    {
+        --e.connections;
+        log_debug("drop connection to " << e.host << ':' << e.port << "; " << e.connections << " connections");
+    }
+
+    if (failed)
+    {
+        ++e.failures;
+        if (++e.consecutiveFailures >= _impl->failureThreshold)
+        {
+            log_warn("endpoint " << e.host << ':' << e.port << " failed " << e.consecutiveFailures << " times - eject for " << _impl->ejectTime << " ms");
+            e.ejected = true;
+            e.ejectedUntil = Clock::getSystemTicks() + Timespan(static_cast<int64_t>(_impl->ejectTime) * 1000);
+        }
+    }
+    else
+    {
+        if (e.ejected)
+            log_info("endpoint " << e.host << ':' << e.port << " is healthy again");
+
+        e.ejected = false;
+        e.consecutiveFailures = 0;
+
+        double msecs = latency.totalUSecs() / 1000.0;
+        e.latency = e.latency == 0 ? msecs : e.latency * 0.8 + msecs * 0.2;
+    }
+
+    return keep;
+}
+
+}
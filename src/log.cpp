@@ -26,83 +26,53 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include "config.h"
 #include <cxxtools/log/cxxtools.h>
 #include <cxxtools/refcounted.h>
 #include <cxxtools/smartptr.h>
 #include <cxxtools/convert.h>
 #include <cxxtools/mutex.h>
+#include <cxxtools/condition.h>
+#include <cxxtools/thread.h>
 #include <cxxtools/atomicity.h>
 #include <cxxtools/serializationinfo.h>
 #include <cxxtools/xml/xmldeserializer.h>
 #include <cxxtools/propertiesdeserializer.h>
 #include <cxxtools/net/udp.h>
 #include <cxxtools/fileinfo.h>
+#include <cxxtools/systemerror.h>
 #include <vector>
+#include <algorithm>
+#include <stdexcept>
 #include <map>
 #include <fstream>
 #include <sstream>
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 #include <fcntl.h>
 #include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <time.h>
 #include <pthread.h>
 
 namespace cxxtools
 {
   namespace
   {
-    Mutex loggersMutex;
     Mutex logMutex;
-    Mutex poolMutex;
     atomic_t mutexWaitCount = 0;
 
-    template <typename T, unsigned MaxPoolSize = 8>
-    class LPool
-    {
-        std::vector<T*> pool;
-        Mutex mutex;
-
-      public:
-        ~LPool()
-        {
-          for (unsigned n = 0; n < pool.size(); ++n)
-            delete pool[n];
-        }
-
-        T* getInstance()
-        {
-          if (pool.empty())
-          {
-            // we don't care about locking here since it is not dangerous to get a false answer
-            return new T();
-          }
-
-          T* impl;
-
-          {
-            MutexLock lock(poolMutex);
-            if (pool.empty())
-              return new T();
-
-            impl = pool.back();
-            pool.pop_back();
-          }
-
-          return impl;
-        }
-
-        void releaseInstance(T* inst)
-        {
-          MutexLock lock(poolMutex);
-
-          if (pool.size() < MaxPoolSize)
-            pool.push_back(inst);
-          else
-            delete inst;
-        }
+    // guards LoggerManager::_impl; log messages are written with a read
+    // lock, so that the appenders are not replaced or destroyed while used
+    ReadWriteMutex implMutex;
 
-    };
+    // number of log messages, which had to wait for the log mutex and the
+    // total time waited in microseconds
+    atomic_t mutexWaits = 0;
+    atomic_t mutexWaitTime = 0;
 
     class ScopedAtomicIncrementer
     {
@@ -121,16 +91,92 @@ namespace cxxtools
         }
     };
 
-    void logentry(std::string& entry, const char* level, const std::string& category)
+    //////////////////////////////////////////////////////////////////////
+    // prefix of log entries cached per thread; the date is formatted once
+    // per second and pid and thread id once per thread, so that the entries
+    // can be formatted without locking
+    //
+    struct LogEntryCache
+    {
+      time_t sec;
+      char date[20];
+      char tz[6];        // offset to utc "+hh:mm"
+      unsigned forkCount;
+      char id[64];       // "[pid.thread] "
+      unsigned idlen;
+    };
+
+    pthread_key_t logEntryCacheKey;
+    pthread_once_t logEntryCacheOnce = PTHREAD_ONCE_INIT;
+    unsigned forkCount = 0;
+
+    void deleteLogEntryCache(void* p)
+    {
+      delete static_cast<LogEntryCache*>(p);
+    }
+
+    void incrementForkCount()
+    {
+      ++forkCount;
+    }
+
+    void createLogEntryCacheKey()
+    {
+      pthread_key_create(&logEntryCacheKey, deleteLogEntryCache);
+
+      // the pid changes in the child process
+      pthread_atfork(0, 0, incrementForkCount);
+    }
+
+    LogEntryCache& getLogEntryCache()
+    {
+      pthread_once(&logEntryCacheOnce, createLogEntryCacheKey);
+
+      LogEntryCache* cache = static_cast<LogEntryCache*>(pthread_getspecific(logEntryCacheKey));
+      if (cache == 0)
+      {
+        cache = new LogEntryCache();
+        cache->sec = 0;
+        cache->idlen = 0;
+        pthread_setspecific(logEntryCacheKey, cache);
+      }
+
+      if (cache->idlen == 0 || cache->forkCount != forkCount)
+      {
+        char* p = cache->id;
+        *p++ = '[';
+        p = putInt(p, getpid());
+        *p++ = '.';
+        p = putInt(p, (unsigned long)pthread_self());
+        *p++ = ']';
+        *p++ = ' ';
+        cache->idlen = p - cache->id;
+        cache->forkCount = forkCount;
+      }
+
+      return *cache;
+    }
+
+    // formats the current time as "YYYY-MM-DD HH:MM:SS.uuuuu" into buffer
+    void logtime(LogEntryCache& cache, char* buffer, bool coarseTime)
     {
       struct timeval t;
-      gettimeofday(&t, 0);
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_REALTIME_COARSE)
+      if (coarseTime)
+      {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+        t.tv_sec = ts.tv_sec;
+        t.tv_usec = ts.tv_nsec / 1000;
+      }
+      else
+#endif
+        gettimeofday(&t, 0);
 
       // format date only once per second:
-      static char date[20];
-      static time_t psec = 0;
+      char* date = cache.date;
       time_t sec = static_cast<time_t>(t.tv_sec);
-      if (sec != psec)
+      if (sec != cache.sec)
       {
         struct tm tt;
         localtime_r(&sec, &tt);
@@ -157,31 +203,219 @@ namespace cxxtools
         date[18] = static_cast<char>('0' + tt.tm_sec % 10);
         date[19] = '.';
 
-        psec = sec;
+        // the offset of the local time to utc for syslog
+        struct tm gt;
+        gmtime_r(&sec, &gt);
+        int offset = (tt.tm_hour - gt.tm_hour) * 60 + tt.tm_min - gt.tm_min;
+        if (tt.tm_year != gt.tm_year ? tt.tm_year > gt.tm_year : tt.tm_yday > gt.tm_yday)
+          offset += 24 * 60;
+        else if (tt.tm_year != gt.tm_year || tt.tm_yday != gt.tm_yday)
+          offset -= 24 * 60;
+
+        char* tz = cache.tz;
+        tz[0] = offset < 0 ? '-' : '+';
+        if (offset < 0)
+          offset = -offset;
+        tz[1] = static_cast<char>('0' + offset / 600);
+        tz[2] = static_cast<char>('0' + offset / 60 % 10);
+        tz[3] = ':';
+        tz[4] = static_cast<char>('0' + offset % 60 / 10);
+        tz[5] = static_cast<char>('0' + offset % 10);
+
+        cache.sec = sec;
       }
 
-      entry.append(date, 20);
+      memcpy(buffer, date, 20);
+      buffer[20] = static_cast<char>('0' + t.tv_usec / 100000 % 10);
+      buffer[21] = static_cast<char>('0' + t.tv_usec / 10000 % 10);
+      buffer[22] = static_cast<char>('0' + t.tv_usec / 1000 % 10);
+      buffer[23] = static_cast<char>('0' + t.tv_usec / 100 % 10);
+      buffer[24] = static_cast<char>('0' + t.tv_usec / 10 % 10);
+    }
+
+    void logentry(std::string& entry, const char* level, const std::string& category, bool coarseTime = false)
+    {
+      LogEntryCache& cache = getLogEntryCache();
+
+      char time[26];
+      logtime(cache, time, coarseTime);
+      time[25] = ' ';
 
-      entry += static_cast<char>('0' + t.tv_usec / 100000 % 10);
-      entry += static_cast<char>('0' + t.tv_usec / 10000 % 10);
-      entry += static_cast<char>('0' + t.tv_usec / 1000 % 10);
-      entry += static_cast<char>('0' + t.tv_usec / 100 % 10);
-      entry += static_cast<char>('0' + t.tv_usec / 10 % 10);
+      entry.append(time, 26);
+      entry.append(cache.id, cache.idlen);
+      entry += level;
       entry += ' ';
-      entry += '[';
-      char str[64];
-      char* p = putInt(str, getpid());
-      entry.append(str, p - str);
-      entry += '.';
-      p = putInt(str, (unsigned long)pthread_self());
-      entry.append(str, p - str);
-      entry += "] ";
+      entry += category;
+      entry += " - ";
+    }
+
+    // appends str as a json string without the quotes; bytes >= 0x80 are
+    // passed unchanged, so that utf-8 stays utf-8
+    void jsonStringOut(std::string& out, const char* str, std::size_t len)
+    {
+      static const char hex[] = "0123456789abcdef";
+
+      const char* end = str + len;
+      for (const char* p = str; p != end; ++p)
+      {
+        unsigned char ch = static_cast<unsigned char>(*p);
+        if (ch >= 0x20 && ch != '"' && ch != '\\')
+        {
+          out += *p;
+          continue;
+        }
+
+        out += '\\';
+        switch (ch)
+        {
+          case '"':  out += '"'; break;
+          case '\\': out += '\\'; break;
+          case '\b': out += 'b'; break;
+          case '\f': out += 'f'; break;
+          case '\n': out += 'n'; break;
+          case '\r': out += 'r'; break;
+          case '\t': out += 't'; break;
+          default:
+            out += "u00";
+            out += hex[ch >> 4];
+            out += hex[ch & 0xf];
+        }
+      }
+    }
+
+    // formats v into the buffer ending at end and returns the start
+    char* formatUnsigned(char* end, unsigned long long v)
+    {
+      char* p = end;
+      do
+      {
+        *--p = static_cast<char>('0' + v % 10);
+        v /= 10;
+      } while (v > 0);
+
+      return p;
+    }
+
+    void putUnsigned(std::string& out, unsigned long long v)
+    {
+      char digits[24];
+      char* p = formatUnsigned(digits + sizeof(digits), v);
+      out.append(p, digits + sizeof(digits) - p);
+    }
+
+    // appends the json entry up to and including the opening quote of
+    // the message
+    void logentryJson(std::string& entry, const char* level, const std::string& category, bool coarseTime = false)
+    {
+      LogEntryCache& cache = getLogEntryCache();
+
+      char time[25];
+      logtime(cache, time, coarseTime);
+      time[10] = 'T';
+
+      entry += "{\"time\":\"";
+      entry.append(time, 25);
+      entry.append(cache.tz, sizeof(cache.tz));
+      entry += "\",\"level\":\"";
       entry += level;
+      entry += "\",\"category\":\"";
+      jsonStringOut(entry, category.data(), category.size());
+      entry += "\",\"pid\":";
+
+      // cache.id is "[pid.thread] "
+      const char* dot = static_cast<const char*>(memchr(cache.id, '.', cache.idlen));
+      entry.append(cache.id + 1, dot - cache.id - 1);
+      entry += ",\"thread\":";
+      entry.append(dot + 1, cache.idlen - (dot - cache.id) - 3);
+      entry += ",\"message\":\"";
+    }
+
+    // settings for formatting log entries
+    struct LogFormat
+    {
+      enum Type { Text, Json, Syslog };
+
+      Type type;
+      bool coarseTime;
+      unsigned facility;     // syslog facility
+      std::string hostname;  // syslog hostname and app-name
+      std::string appname;
+
+      LogFormat()
+        : type(Text),
+          coarseTime(false),
+          facility(1)
+      { }
+    };
+
+    unsigned syslogSeverity(const char* level)
+    {
+      switch (level[0])
+      {
+        case 'F': return 2;  // critical
+        case 'E': return 3;
+        case 'W': return 4;
+        case 'I': return 6;
+        default:  return 7;  // debug
+      }
+    }
+
+    // appends the header of a syslog message as described in RFC 5424;
+    // the category is prepended to the message
+    void logentrySyslog(std::string& entry, const char* level, const std::string& category, const LogFormat& format)
+    {
+      LogEntryCache& cache = getLogEntryCache();
+
+      char time[25];
+      logtime(cache, time, format.coarseTime);
+      time[10] = 'T';
+
+      entry += '<';
+      putUnsigned(entry, format.facility * 8 + syslogSeverity(level));
+      entry += ">1 ";
+      entry.append(time, 25);
+      entry.append(cache.tz, sizeof(cache.tz));
       entry += ' ';
+      entry += format.hostname;
+      entry += ' ';
+      entry += format.appname;
+      entry += ' ';
+
+      // cache.id is "[pid.thread] "
+      const char* dot = static_cast<const char*>(memchr(cache.id, '.', cache.idlen));
+      entry.append(cache.id + 1, dot - cache.id - 1);
+
+      entry += " - - ";  // no msgid and structured data
       entry += category;
       entry += " - ";
     }
 
+    // formats a complete log entry into msg; fields are the json members
+    // added with LogField
+    void formatLogEntry(std::string& msg, const char* level, const std::string& category,
+                        const char* state, const std::string& text, const std::string& fields,
+                        const LogFormat& format)
+    {
+      if (format.type == LogFormat::Json)
+      {
+        logentryJson(msg, level, category, format.coarseTime);
+        jsonStringOut(msg, state, strlen(state));
+        jsonStringOut(msg, text.data(), text.size());
+        msg += '"';
+        msg += fields;
+        msg += '}';
+      }
+      else
+      {
+        if (format.type == LogFormat::Syslog)
+          logentrySyslog(msg, level, category, format);
+        else
+          logentry(msg, level, category, format.coarseTime);
+        msg += state;
+        msg += text;
+      }
+    }
+
     class LogAppender : public RefCounted
     {
       public:
@@ -327,16 +561,31 @@ namespace cxxtools
     }
 
     //////////////////////////////////////////////////////////////////////
-    // UdpAppender
+    // UdpAppender - sends log messages as datagrams
+    //
+    // When packing, messages are joined with line feeds into datagrams of
+    // up to maxDatagram bytes; otherwise each message is a datagram of its
+    // own as required for syslog. The datagrams are collected and sent in
+    // batches with a single system call.
     //
     class UdpAppender : public LogAppender
     {
         net::UdpSender _loghost;
-        std::string _msg;
+        unsigned _maxDatagram;
+        bool _pack;
+
+        // the strings are reused; _count is the number of datagrams to send
+        std::vector<std::string> _datagrams;
+        unsigned _count;
+
+        static const unsigned maxBatch = 64;
 
       public:
-        UdpAppender(const std::string& host, unsigned short int port, bool broadcast = true)
-          : _loghost(host, port, broadcast)
+        UdpAppender(const std::string& host, unsigned short int port, bool broadcast, unsigned maxDatagram, bool pack)
+          : _loghost(host, port, broadcast),
+            _maxDatagram(maxDatagram > 0 ? maxDatagram : 1),
+            _pack(pack),
+            _count(0)
         { }
 
         virtual void putMessage(const std::string& msg);
@@ -345,196 +594,752 @@ namespace cxxtools
 
     void UdpAppender::putMessage(const std::string& msg)
     {
-      _msg = msg;
+      std::string::size_type size = std::min<std::string::size_type>(msg.size(), _maxDatagram);
+
+      if (_pack && _count > 0 && _datagrams[_count - 1].size() + 1 + size <= _maxDatagram)
+      {
+        std::string& datagram = _datagrams[_count - 1];
+        datagram += '\n';
+        datagram.append(msg, 0, size);
+        return;
+      }
+
+      if (_count == _datagrams.size())
+        _datagrams.push_back(std::string());
+
+      _datagrams[_count++].assign(msg, 0, size);
     }
 
     void UdpAppender::finish(bool flush)
     {
+      if (_count == 0 || (!flush && _count < maxBatch))
+        return;
+
       try
       {
-        _loghost.send(_msg);
+        _loghost.sendBatch(&_datagrams[0], _count);
       }
       catch (const std::exception&)
       {
       }
-      _msg.clear();
+
+      _count = 0;
     }
 
     //////////////////////////////////////////////////////////////////////
-    Logger::log_level_type str2loglevel(const std::string& level, const std::string& category = std::string())
+    // AsyncAppender - passes the messages to a background thread, which
+    // writes them in batches to the actual appender
+    //
+    class AsyncAppender : public LogAppender
     {
-      char l = level.empty() ? '\0' : level[0];
-      switch (l)
-      {
-        case 'f':
-        case 'F': return Logger::LOG_LEVEL_FATAL;
-        case 'e':
-        case 'E': return Logger::LOG_LEVEL_ERROR;
-        case 'w':
-        case 'W': return Logger::LOG_LEVEL_WARN;
-        case 'i':
-        case 'I': return Logger::LOG_LEVEL_INFO;
-        case 'd':
-        case 'D': return Logger::LOG_LEVEL_DEBUG;
-        case 't':
-        case 'T': return Logger::LOG_LEVEL_TRACE;
-        default:
-                  {
-                    std::string msg = "unknown log level \"" + level + '\"';
-                    if (!category.empty())
-                      msg += " for category \"" + category + '"';
-                    throw std::runtime_error(msg);
-                  }
-      }
-    }
-  }
+        SmartPtr<LogAppender> _appender;
+
+        // messages filled by the logging threads and the batch written
+        // by the writer thread; they are swapped, when the writer is ready
+        std::vector<std::string> _messages;
+        std::vector<std::string> _batch;
+        // written messages, which are passed back to the logging threads,
+        // so that their buffers are reused
+        std::vector<std::string> _free;
+        unsigned _maxMessages;
+        bool _block;
+        unsigned _dropped;
+        // messages, which the appender failed to write, and the last
+        // error; they are only accessed by the writer thread
+        unsigned _failed;
+        std::string _failure;
+        LogFormat _format;
+
+        bool _running;
+        bool _writing;
+        Mutex _mutex;
+        Condition _notEmpty;
+        Condition _notFull;
+        Condition _written;
+        AttachedThread _thread;
+
+        void run();
+        void write(const std::string& msg);
 
-  //////////////////////////////////////////////////////////////////////
-  // Logger
-  //
+      public:
+        AsyncAppender(LogAppender* appender, unsigned maxMessages, bool block, const LogFormat& format);
+        ~AsyncAppender();
 
-  //////////////////////////////////////////////////////////////////////
-  // LoggerManagerConfiguration
-  //
+        // Moves the message into the queue. When the queue is full, the
+        // method waits or drops the message depending on the overflow
+        // policy. With flush set it waits until the message is written.
+        void putMessage(std::string& msg, bool flush);
 
-  class LoggerManagerConfiguration::Impl
-  {
-    public:
-      typedef std::map<std::string, Logger::log_level_type> LogLevels;
+        virtual void putMessage(const std::string& msg);
+        virtual void finish(bool flush);
+    };
 
-    private:
-      friend void operator>>= (const SerializationInfo& si, LoggerManagerConfiguration::Impl& loggerManagerConfigurationImpl);
-      std::string _fname;
-      unsigned _maxfilesize;
-      unsigned _maxbackupindex;
-      std::string _loghost;
-      unsigned short _logport;
-      bool _broadcast;
-      bool _tostdout;  // flag for console output: true=stdout, false=stderr
+    AsyncAppender::AsyncAppender(LogAppender* appender, unsigned maxMessages, bool block, const LogFormat& format)
+      : _appender(appender),
+        _maxMessages(maxMessages > 0 ? maxMessages : 1),
+        _block(block),
+        _dropped(0),
+        _failed(0),
+        _format(format),
+        _running(true),
+        _writing(false),
+        _thread(callable(*this, &AsyncAppender::run))
+    {
+      _messages.reserve(_maxMessages);
+      _batch.reserve(_maxMessages);
+      _thread.start();
+    }
 
-      Logger::log_level_type _rootLevel;
-      LogLevels _logLevels;
+    AsyncAppender::~AsyncAppender()
+    {
+      {
+        MutexLock lock(_mutex);
+        _running = false;
+        _notEmpty.signal();
+      }
 
-    public:
-      Impl()
-        : _maxfilesize(0),
-          _maxbackupindex(0),
-          _logport(0),
-          _broadcast(true),
-          _rootLevel(Logger::LOG_LEVEL_FATAL)
-      { }
+      // the writer thread writes the pending messages before it terminates
+      _thread.join();
+    }
 
-      const std::string& fname() const          { return _fname; }
-      unsigned maxfilesize() const              { return _maxfilesize; }
-      unsigned maxbackupindex() const           { return _maxbackupindex; }
-      const std::string& loghost() const        { return _loghost; }
-      unsigned short logport() const            { return _logport; }
-      bool broadcast() const                    { return _broadcast; }
-      bool tostdout() const                     { return _tostdout; }
+    void AsyncAppender::putMessage(std::string& msg, bool flush)
+    {
+      MutexLock lock(_mutex);
 
-      Logger::log_level_type rootLevel() const  { return _rootLevel; }
-      Logger::log_level_type logLevel(const std::string& category) const;
-      const LogLevels& logLevels() const        { return _logLevels; }
-  };
+      while (_messages.size() >= _maxMessages)
+      {
+        if (!_block && !flush)
+        {
+          ++_dropped;
+          return;
+        }
 
-  LoggerManagerConfiguration::LoggerManagerConfiguration()
-    : _impl(new LoggerManagerConfiguration::Impl())
-  {
-  }
+        _notFull.wait(lock);
+      }
 
-  LoggerManagerConfiguration::LoggerManagerConfiguration(const LoggerManagerConfiguration& c)
-    : _impl(new Impl(*c._impl))
-  {
-  }
+      if (_messages.empty())
+        _notEmpty.signal();
 
-  LoggerManagerConfiguration& LoggerManagerConfiguration::operator=(const LoggerManagerConfiguration& c)
-  {
-    delete _impl;
-    _impl = 0;
-    _impl = new Impl(*c._impl);
-    return *this;
-  }
+      _messages.push_back(std::string());
+      _messages.back().swap(msg);
 
-  LoggerManagerConfiguration::~LoggerManagerConfiguration()
-  {
-    delete _impl;
-  }
+      if (!_free.empty())
+      {
+        msg.swap(_free.back());
+        _free.pop_back();
+      }
 
-  Logger::log_level_type LoggerManagerConfiguration::rootLevel() const
-  {
-    return _impl->rootLevel();
-  }
+      if (flush)
+      {
+        while (!_messages.empty() || _writing)
+          _written.wait(lock);
+      }
+    }
 
-  Logger::log_level_type LoggerManagerConfiguration::logLevel(const std::string& category) const
-  {
-    return _impl->logLevel(category);
-  }
+    void AsyncAppender::putMessage(const std::string& msg)
+    {
+      std::string m(msg);
+      putMessage(m, false);
+    }
 
-  Logger::log_level_type LoggerManagerConfiguration::Impl::logLevel(const std::string& category) const
-  {
-    // check for exact match of category in log level settings
-    LogLevels::const_iterator lit = _logLevels.find(category);
-    if (lit != _logLevels.end())
-      return lit->second;
+    void AsyncAppender::finish(bool flush)
+    {
+      if (!flush)
+        return;
 
-    // find best match of category in log level settings
-    std::string::size_type best_len = 0;
-    Logger::log_level_type best_level = _rootLevel;
+      MutexLock lock(_mutex);
+      while (!_messages.empty() || _writing)
+        _written.wait(lock);
+    }
 
-    for (LogLevels::const_iterator it = _logLevels.begin(); it != _logLevels.end(); ++it)
+    void AsyncAppender::run()
     {
-      if (it->first.size() > best_len
-        && it->first.size() < category.size()
-        && category.at(it->first.size()) == '.'
-        && category.compare(0, it->first.size(), it->first) == 0)
+      MutexLock lock(_mutex);
+
+      while (true)
       {
-        best_len = it->first.size();
-        best_level = it->second;
-      }
-    }
+        while (_running && _messages.empty())
+          _notEmpty.wait(lock);
 
-    return best_level;
-  }
+        if (_messages.empty())
+          break;
 
-  void operator>>= (const SerializationInfo& si, LoggerManagerConfiguration::Impl& impl)
-  {
-    if (si.getMember("file", impl._fname))
-    {
-      std::string s;
-      if (si.getMember("maxfilesize", s))
-      {
-        bool ok = true;
-        std::string::iterator it = getInt(s.begin(), s.end(), ok, impl._maxfilesize);
-        if (!ok)
-          throw std::runtime_error("failed to read maxfilesize (\"" + s + "\")");
-        if (it != s.end())
+        _batch.swap(_messages);
+        unsigned dropped = _dropped;
+        _dropped = 0;
+        _writing = true;
+        _notFull.broadcast();
+
+        lock.unlock();
+
+        for (unsigned n = 0; n < _batch.size(); ++n)
+          write(_batch[n]);
+
+        if (dropped > 0)
         {
-          switch (*it)
-          {
-            case 'k':
-            case 'K':
-              impl._maxfilesize *= 1024;
-              break;
-
-            case 'm':
-            case 'M':
-              impl._maxfilesize *= 1024 * 1024;
-              break;
-
-            case 'g':
-            case 'G':
-              impl._maxfilesize *= 1024 * 1024 * 1024;
-              break;
-          }
+          std::string msg;
+          formatLogEntry(msg, "WARN", "cxxtools.log", "",
+              convert<std::string>(dropped) + " log messages dropped",
+              std::string(), _format);
+          write(msg);
         }
 
-        si.getMember("maxbackupindex") >>= impl._maxbackupindex;
-      }
-    }
-    else if (si.getMember("logport", impl._logport))
+        if (_failed > 0)
+        {
+          // the count is kept for the next batch, when the report fails too
+          unsigned failed = _failed;
+          _failed = 0;
+
+          std::string msg;
+          formatLogEntry(msg, "WARN", "cxxtools.log", "",
+              convert<std::string>(failed) + " log messages lost: " + _failure,
+              std::string(), _format);
+          write(msg);
+          if (_failed > 0)
+            _failed = failed;
+        }
+
+        try
+        {
+          _appender->finish(true);
+        }
+        catch (const std::exception& e)
+        {
+          _failure = e.what();
+        }
+
+        lock.lock();
+
+        for (unsigned n = 0; n < _batch.size() && _free.size() < _maxMessages; ++n)
+        {
+          _free.push_back(std::string());
+          _free.back().swap(_batch[n]);
+        }
+
+        _batch.clear();
+        _writing = false;
+        _written.broadcast();
+      }
+    }
+
+    void AsyncAppender::write(const std::string& msg)
+    {
+      try
+      {
+        _appender->putMessage(msg);
+        _appender->finish(false);
+      }
+      catch (const std::exception& e)
+      {
+        ++_failed;
+        _failure = e.what();
+      }
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // RingBuffer - a memory mapped file used as a circular buffer for log
+    // entries
+    //
+    // The file starts with a header of ringBufferOffset bytes followed by
+    // the buffer, which size is a power of 2. The header holds the total
+    // number of bytes written as a 64 bit number. A record consists of the
+    // 32 bit magic number, the 32 bit size of the message, the 64 bit
+    // position of the record and the message and is padded to 8 bytes.
+    // The position is written last and marks the record as complete.
+    // Records, which are not complete or were overwritten, are skipped by
+    // the reader. The layout does not depend on the platform.
+    //
+    struct RingBufferHeader
+    {
+      char magic[8];
+      uint32_t size;
+      uint32_t reserved;
+      volatile uint64_t pos;
+    };
+
+    const char ringBufferMagic[8] = "cxxring";
+    const uint32_t ringRecordMagic = 0xf10c5a7e;
+    const unsigned ringBufferOffset = 4096;
+    const unsigned ringRecordHeaderSize = 16;
+
+    // atomic operations on the 64 bit positions; atomic_t has only 32 bits
+    // on many platforms, so that the positions would overflow after 2 GB
+#if defined(__ATOMIC_SEQ_CST)
+    inline uint64_t ringPosGet(volatile uint64_t& pos)
+    { return __atomic_load_n(&pos, __ATOMIC_ACQUIRE); }
+
+    inline void ringPosSet(volatile uint64_t& pos, uint64_t value)
+    { __atomic_store_n(&pos, value, __ATOMIC_RELEASE); }
+
+    inline uint64_t ringPosAdd(volatile uint64_t& pos, uint64_t add)
+    { return __atomic_fetch_add(&pos, add, __ATOMIC_SEQ_CST); }
+#else
+    // without 64 bit atomics the writers of the process are serialized
+    Mutex ringPosMutex;
+
+    inline uint64_t ringPosGet(volatile uint64_t& pos)
+    { MutexLock lock(ringPosMutex); return pos; }
+
+    inline void ringPosSet(volatile uint64_t& pos, uint64_t value)
+    { MutexLock lock(ringPosMutex); pos = value; }
+
+    inline uint64_t ringPosAdd(volatile uint64_t& pos, uint64_t add)
+    { MutexLock lock(ringPosMutex); uint64_t ret = pos; pos += add; return ret; }
+#endif
+
+    class RingBuffer
+    {
+        char* _map;
+        size_t _mapSize;
+        size_t _mask;
+
+        RingBuffer(const RingBuffer&);
+        RingBuffer& operator=(const RingBuffer&);
+
+      public:
+        // opens or creates the file for writing; an existing file of the
+        // same size is continued
+        RingBuffer(const std::string& fname, unsigned size);
+
+        // opens an existing file for reading
+        explicit RingBuffer(const std::string& fname);
+
+        ~RingBuffer()
+        { ::munmap(_map, _mapSize); }
+
+        RingBufferHeader& header()
+        { return *reinterpret_cast<RingBufferHeader*>(_map); }
+
+        char* data()
+        { return _map + ringBufferOffset; }
+
+        size_t size() const
+        { return _mask + 1; }
+
+        // copies data from and to the buffer at the position, wrapping
+        // around at the end
+        void read(uint64_t pos, void* dest, size_t n);
+        void write(uint64_t pos, const void* src, size_t n);
+
+        volatile uint64_t& recordPos(uint64_t pos)
+        { return *reinterpret_cast<volatile uint64_t*>(data() + ((pos + 8) & _mask)); }
+    };
+
+    RingBuffer::RingBuffer(const std::string& fname, unsigned size)
+    {
+      size_t s = 4096;
+      while (s < size)
+        s <<= 1;
+
+      int fd = ::open(fname.c_str(), O_RDWR | O_CREAT, 0666);
+      if (fd < 0)
+        throw SystemError("open", "failed to open log ring buffer \"" + fname + '"');
+
+      struct stat st;
+      bool init = ::fstat(fd, &st) != 0
+               || static_cast<size_t>(st.st_size) != ringBufferOffset + s;
+
+      if (init && (::ftruncate(fd, 0) != 0 || ::ftruncate(fd, ringBufferOffset + s) != 0))
+      {
+        ::close(fd);
+        throw SystemError("ftruncate", "failed to resize log ring buffer \"" + fname + '"');
+      }
+
+      _mapSize = ringBufferOffset + s;
+      _mask = s - 1;
+      void* p = ::mmap(0, _mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if (p == MAP_FAILED)
+        throw SystemError("mmap", "failed to map log ring buffer \"" + fname + '"');
+
+      _map = static_cast<char*>(p);
+
+      if (init || memcmp(header().magic, ringBufferMagic, sizeof(ringBufferMagic)) != 0
+               || header().size != s)
+      {
+        memset(_map, 0, ringBufferOffset);
+        memcpy(header().magic, ringBufferMagic, sizeof(ringBufferMagic));
+        header().size = s;
+      }
+    }
+
+    RingBuffer::RingBuffer(const std::string& fname)
+    {
+      int fd = ::open(fname.c_str(), O_RDONLY);
+      if (fd < 0)
+        throw SystemError("open", "failed to open log ring buffer \"" + fname + '"');
+
+      RingBufferHeader h;
+      struct stat st;
+      if (::read(fd, &h, sizeof(h)) != static_cast<ssize_t>(sizeof(h))
+        || memcmp(h.magic, ringBufferMagic, sizeof(ringBufferMagic)) != 0
+        || h.size == 0 || (h.size & (h.size - 1)) != 0
+        || ::fstat(fd, &st) != 0
+        || static_cast<size_t>(st.st_size) < ringBufferOffset + h.size)
+      {
+        ::close(fd);
+        throw std::runtime_error("\"" + fname + "\" is not a log ring buffer");
+      }
+
+      _mapSize = ringBufferOffset + h.size;
+      _mask = h.size - 1;
+      void* p = ::mmap(0, _mapSize, PROT_READ, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if (p == MAP_FAILED)
+        throw SystemError("mmap", "failed to map log ring buffer \"" + fname + '"');
+
+      _map = static_cast<char*>(p);
+    }
+
+    void RingBuffer::read(uint64_t pos, void* dest, size_t n)
+    {
+      size_t offset = static_cast<size_t>(pos & _mask);
+      size_t n1 = std::min(n, size() - offset);
+      memcpy(dest, data() + offset, n1);
+      memcpy(static_cast<char*>(dest) + n1, data(), n - n1);
+    }
+
+    void RingBuffer::write(uint64_t pos, const void* src, size_t n)
+    {
+      size_t offset = static_cast<size_t>(pos & _mask);
+      size_t n1 = std::min(n, size() - offset);
+      memcpy(data() + offset, src, n1);
+      memcpy(data(), static_cast<const char*>(src) + n1, n - n1);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // RingBufferAppender - writes log entries into a ring buffer
+    //
+    // Writers reserve space by incrementing the write position atomically,
+    // so they neither lock nor block. The file is shared with the page
+    // cache, so the last entries are kept, when the process crashes.
+    //
+    class RingBufferAppender : public LogAppender
+    {
+        RingBuffer _buffer;
+
+      public:
+        RingBufferAppender(const std::string& fname, unsigned size)
+          : _buffer(fname, size)
+        { }
+
+        virtual void putMessage(const std::string& msg);
+
+        virtual void finish(bool)
+        { }
+    };
+
+    void RingBufferAppender::putMessage(const std::string& msg)
+    {
+      // a message may take at most a quarter of the buffer
+      uint32_t n = std::min<size_t>(msg.size(), _buffer.size() / 4 - ringRecordHeaderSize);
+      size_t recordSize = (ringRecordHeaderSize + n + 7) & ~size_t(7);
+
+      uint64_t pos = ringPosAdd(_buffer.header().pos, recordSize);
+
+      uint32_t head[2] = { ringRecordMagic, n };
+      _buffer.write(pos, head, sizeof(head));
+      _buffer.write(pos + ringRecordHeaderSize, msg.data(), n);
+
+      // commit the record
+      ringPosSet(_buffer.recordPos(pos), pos);
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    Logger::log_level_type str2loglevel(const std::string& level, const std::string& category = std::string())
+    {
+      char l = level.empty() ? '\0' : level[0];
+      switch (l)
+      {
+        case 'f':
+        case 'F': return Logger::LOG_LEVEL_FATAL;
+        case 'e':
+        case 'E': return Logger::LOG_LEVEL_ERROR;
+        case 'w':
+        case 'W': return Logger::LOG_LEVEL_WARN;
+        case 'i':
+        case 'I': return Logger::LOG_LEVEL_INFO;
+        case 'd':
+        case 'D': return Logger::LOG_LEVEL_DEBUG;
+        case 't':
+        case 'T': return Logger::LOG_LEVEL_TRACE;
+        default:
+                  {
+                    std::string msg = "unknown log level \"" + level + '\"';
+                    if (!category.empty())
+                      msg += " for category \"" + category + '"';
+                    throw std::runtime_error(msg);
+                  }
+      }
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // Logger
+  //
+
+  //////////////////////////////////////////////////////////////////////
+  // LoggerManagerConfiguration
+  //
+
+  class LoggerManagerConfiguration::Impl
+  {
+    public:
+      typedef std::map<std::string, Logger::log_level_type> LogLevels;
+
+      struct LogLimit
+      {
+        unsigned limit;
+        double sample;
+
+        LogLimit()
+          : limit(0),
+            sample(1.0)
+        { }
+      };
+
+      typedef std::map<std::string, LogLimit> LogLimits;
+
+    private:
+      friend void operator>>= (const SerializationInfo& si, LoggerManagerConfiguration::Impl& loggerManagerConfigurationImpl);
+      std::string _fname;
+      std::string _ringbuffer;
+      unsigned _ringbuffersize;
+      unsigned _maxfilesize;
+      unsigned _maxbackupindex;
+      std::string _loghost;
+      unsigned short _logport;
+      bool _broadcast;
+      bool _tostdout;  // flag for console output: true=stdout, false=stderr
+      LogFormat _format;
+      unsigned _maxdatagram;
+      unsigned _watch;   // seconds between checks of the configuration file
+      bool _async;
+      unsigned _asyncqueuesize;
+      bool _asyncblock;  // overflow policy: true=block, false=drop messages
+
+      Logger::log_level_type _rootLevel;
+      LogLevels _logLevels;
+      LogLimits _logLimits;
+
+    public:
+      Impl()
+        : _ringbuffersize(16 * 1024 * 1024),
+          _maxfilesize(0),
+          _maxbackupindex(0),
+          _logport(0),
+          _broadcast(true),
+          _maxdatagram(1472),
+          _watch(0),
+          _async(false),
+          _asyncqueuesize(8192),
+          _asyncblock(true),
+          _rootLevel(Logger::LOG_LEVEL_FATAL)
+      { }
+
+      const std::string& fname() const          { return _fname; }
+      const std::string& ringbuffer() const     { return _ringbuffer; }
+      unsigned ringbuffersize() const           { return _ringbuffersize; }
+      unsigned maxfilesize() const              { return _maxfilesize; }
+      unsigned maxbackupindex() const           { return _maxbackupindex; }
+      const std::string& loghost() const        { return _loghost; }
+      unsigned short logport() const            { return _logport; }
+      bool broadcast() const                    { return _broadcast; }
+      bool tostdout() const                     { return _tostdout; }
+      const LogFormat& format() const           { return _format; }
+      bool json() const                         { return _format.type == LogFormat::Json; }
+      unsigned maxdatagram() const              { return _maxdatagram; }
+      unsigned watch() const                    { return _watch; }
+      bool async() const                        { return _async; }
+      unsigned asyncqueuesize() const           { return _asyncqueuesize; }
+      bool asyncblock() const                   { return _asyncblock; }
+
+      Logger::log_level_type rootLevel() const  { return _rootLevel; }
+      Logger::log_level_type logLevel(const std::string& category) const;
+      const LogLevels& logLevels() const        { return _logLevels; }
+
+      // returns a new limiter for the category or 0, when it is not limited
+      LogLimiter* logLimiter(const std::string& category) const;
+
+      void setLogLevel(const std::string& category, Logger::log_level_type level);
+
+      // takes the log levels and limits from another configuration
+      void setLevels(const Impl& impl);
+  };
+
+  LoggerManagerConfiguration::LoggerManagerConfiguration()
+    : _impl(new LoggerManagerConfiguration::Impl())
+  {
+  }
+
+  LoggerManagerConfiguration::LoggerManagerConfiguration(const LoggerManagerConfiguration& c)
+    : _impl(new Impl(*c._impl))
+  {
+  }
+
+  LoggerManagerConfiguration& LoggerManagerConfiguration::operator=(const LoggerManagerConfiguration& c)
+  {
+    delete _impl;
+    _impl = 0;
+    _impl = new Impl(*c._impl);
+    return *this;
+  }
+
+  LoggerManagerConfiguration::~LoggerManagerConfiguration()
+  {
+    delete _impl;
+  }
+
+  Logger::log_level_type LoggerManagerConfiguration::rootLevel() const
+  {
+    return _impl->rootLevel();
+  }
+
+  Logger::log_level_type LoggerManagerConfiguration::logLevel(const std::string& category) const
+  {
+    return _impl->logLevel(category);
+  }
+
+  namespace
+  {
+    // returns the setting of the category or the best matching parent
+    // category or 0, when nothing matches
+    template <typename T>
+    const T* findCategory(const std::map<std::string, T>& settings, const std::string& category)
+    {
+      // check for exact match of category in settings
+      typename std::map<std::string, T>::const_iterator lit = settings.find(category);
+      if (lit != settings.end())
+        return &lit->second;
+
+      // find best match of category in settings
+      std::string::size_type best_len = 0;
+      const T* best = 0;
+
+      for (typename std::map<std::string, T>::const_iterator it = settings.begin(); it != settings.end(); ++it)
+      {
+        if (it->first.size() > best_len
+          && it->first.size() < category.size()
+          && category.at(it->first.size()) == '.'
+          && category.compare(0, it->first.size(), it->first) == 0)
+        {
+          best_len = it->first.size();
+          best = &it->second;
+        }
+      }
+
+      return best;
+    }
+  }
+
+  Logger::log_level_type LoggerManagerConfiguration::Impl::logLevel(const std::string& category) const
+  {
+    const Logger::log_level_type* level = findCategory(_logLevels, category);
+    return level ? *level : _rootLevel;
+  }
+
+  void LoggerManagerConfiguration::Impl::setLogLevel(const std::string& category, Logger::log_level_type level)
+  {
+    if (category.empty())
+      _rootLevel = level;
+    else
+      _logLevels[category] = level;
+  }
+
+  void LoggerManagerConfiguration::Impl::setLevels(const Impl& impl)
+  {
+    _rootLevel = impl._rootLevel;
+    _logLevels = impl._logLevels;
+    _logLimits = impl._logLimits;
+  }
+
+  LogLimiter* LoggerManagerConfiguration::Impl::logLimiter(const std::string& category) const
+  {
+    const LogLimit* limit = findCategory(_logLimits, category);
+    if (limit == 0 || (limit->limit == 0 && limit->sample >= 1.0))
+      return 0;
+
+    return new LogLimiter(limit->limit, limit->sample);
+  }
+
+  namespace
+  {
+    // returns the syslog facility code of a name like "local0" or a number
+    unsigned syslogFacility(const std::string& name)
+    {
+      static const char* names[] = {
+        "kern", "user", "mail", "daemon", "auth", "syslog", "lpr", "news",
+        "uucp", "cron", "authpriv", "ftp", "ntp", "security", "console", "solaris-cron",
+        "local0", "local1", "local2", "local3", "local4", "local5", "local6", "local7" };
+
+      for (unsigned n = 0; n < sizeof(names) / sizeof(names[0]); ++n)
+        if (name == names[n])
+          return n;
+
+      unsigned facility = 0;
+      bool ok = true;
+      std::string::const_iterator it = getInt(name.begin(), name.end(), ok, facility);
+      if (!ok || it != name.end() || facility > 23)
+        throw std::runtime_error("unknown syslog facility \"" + name + '"');
+
+      return facility;
+    }
+
+    // reads a size with an optional unit k, M or G
+    bool getSize(const SerializationInfo& si, const char* name, unsigned& value)
+    {
+      std::string s;
+      if (!si.getMember(name, s))
+        return false;
+
+      bool ok = true;
+      std::string::iterator it = getInt(s.begin(), s.end(), ok, value);
+      if (!ok)
+        throw std::runtime_error(std::string("failed to read ") + name + " (\"" + s + "\")");
+      if (it != s.end())
+      {
+        switch (*it)
+        {
+          case 'k':
+          case 'K':
+            value *= 1024;
+            break;
+
+          case 'm':
+          case 'M':
+            value *= 1024 * 1024;
+            break;
+
+          case 'g':
+          case 'G':
+            value *= 1024 * 1024 * 1024;
+            break;
+        }
+      }
+
+      return true;
+    }
+  }
+
+  void operator>>= (const SerializationInfo& si, LoggerManagerConfiguration::Impl& impl)
+  {
+    if (si.getMember("ringbuffer", impl._ringbuffer))
+    {
+      getSize(si, "ringbuffersize", impl._ringbuffersize);
+    }
+    else if (si.getMember("file", impl._fname))
+    {
+      if (getSize(si, "maxfilesize", impl._maxfilesize))
+        si.getMember("maxbackupindex") >>= impl._maxbackupindex;
+    }
+    else if (si.getMember("logport", impl._logport))
     {
       si.getMember("loghost", impl._loghost);
       si.getMember("broadcast", impl._broadcast);
+      getSize(si, "maxdatagram", impl._maxdatagram);
+
+      // log messages are sent in a background thread unless disabled
+      impl._async = true;
     }
     else
     {
@@ -542,6 +1347,64 @@ namespace cxxtools
         impl._tostdout = false;
     }
 
+    si.getMember("coarsetime", impl._format.coarseTime);
+    si.getMember("watch", impl._watch);
+
+    std::string format;
+    if (si.getMember("format", format))
+    {
+      if (format == "json")
+        impl._format.type = LogFormat::Json;
+      else if (format == "text")
+        impl._format.type = LogFormat::Text;
+      else if (format == "syslog")
+        impl._format.type = LogFormat::Syslog;
+      else
+        throw std::runtime_error("unknown log format \"" + format + '"');
+    }
+
+    if (impl._format.type == LogFormat::Syslog)
+    {
+      std::string facility;
+      if (si.getMember("facility", facility))
+        impl._format.facility = syslogFacility(facility);
+
+      char hostname[256];
+      if (::gethostname(hostname, sizeof(hostname)) == 0 && hostname[0] != '\0')
+      {
+        hostname[sizeof(hostname) - 1] = '\0';
+        impl._format.hostname = hostname;
+      }
+      else
+        impl._format.hostname = "-";
+
+      if (!si.getMember("appname", impl._format.appname) || impl._format.appname.empty())
+      {
+#ifdef __GLIBC__
+        impl._format.appname = program_invocation_short_name;
+#else
+        impl._format.appname = "-";
+#endif
+      }
+    }
+
+    si.getMember("async", impl._async);
+    if (impl._async)
+    {
+      si.getMember("asyncqueuesize", impl._asyncqueuesize);
+
+      std::string overflow;
+      if (si.getMember("asyncoverflow", overflow))
+      {
+        if (overflow == "block")
+          impl._asyncblock = true;
+        else if (overflow == "drop")
+          impl._asyncblock = false;
+        else
+          throw std::runtime_error("unknown overflow policy \"" + overflow + '"');
+      }
+    }
+
     std::string rootLevel;
     if (!si.getMember("rootlogger", rootLevel))
       impl._rootLevel = Logger::LOG_LEVEL_FATAL;
@@ -556,17 +1419,25 @@ namespace cxxtools
       Logger::log_level_type level;
       for( SerializationInfo::ConstIterator it = psi->begin(); it != psi->end(); ++it)
       {
-        it->getMember("category") >>= category;
+        SerializationInfo::Hint hint;
+        it->getMember("category", hint) >>= category;
         if (impl._logLevels.find(category) != impl._logLevels.end())
           throw std::runtime_error("level already set for category \"" + category + '"'); 
 
-        it->getMember("level") >>= levelstr;
+        it->getMember("level", hint) >>= levelstr;
         if (levelstr.empty())
           level = Logger::LOG_LEVEL_FATAL;
         else
           level = str2loglevel(levelstr, category);
 
         impl._logLevels[category] = level;
+
+        // an entry without limits must not hide the limits of the parent
+        LoggerManagerConfiguration::Impl::LogLimit limit;
+        bool hasLimit = it->getMember("ratelimit", limit.limit, hint);
+        bool hasSample = it->getMember("sample", limit.sample, hint);
+        if (hasLimit || hasSample)
+          impl._logLimits[category] = limit;
       }
     }
     else if ((psi = si.findMember("logger")) != 0)
@@ -587,6 +1458,22 @@ namespace cxxtools
         impl._logLevels[category] = level;
       }
     }
+
+    // rate limits and sampling in the form ratelimit.category=n and
+    // sample.category=fraction
+    if ((psi = si.findMember("ratelimit")) != 0)
+    {
+      for (SerializationInfo::ConstIterator it = psi->begin(); it != psi->end(); ++it)
+        if (!it->name().empty())
+          it->getValue(impl._logLimits[it->name()].limit);
+    }
+
+    if ((psi = si.findMember("sample")) != 0)
+    {
+      for (SerializationInfo::ConstIterator it = psi->begin(); it != psi->end(); ++it)
+        if (!it->name().empty())
+          it->getValue(impl._logLimits[it->name()].sample);
+    }
   }
 
   void operator>>= (const SerializationInfo& si, LoggerManagerConfiguration& loggerManagerConfiguration)
@@ -594,40 +1481,319 @@ namespace cxxtools
     si >>= *loggerManagerConfiguration.impl();
   }
 
+  //////////////////////////////////////////////////////////////////////
+  // LoggerRegistry
+  //
+  namespace
+  {
+    // Holds the loggers and the current log levels. Loggers are created
+    // once per category and kept until the registry is destroyed, so that
+    // the pointers cached by log_define stay valid.
+    class LoggerRegistry
+    {
+        typedef std::map<std::string, Logger*> Loggers;  // map category => logger
+
+        // loggers are looked up with a read lock; the configuration is
+        // changed with the write lock
+        Loggers _loggers;
+        std::vector<LogLimiter*> _limiters;
+        LoggerManagerConfiguration _config;
+        ReadWriteMutex _mutex;
+
+        void updateLoggers(bool limiters);
+
+      public:
+        ~LoggerRegistry();
+
+        Logger* getLogger(const std::string& category);
+
+        void configure(const LoggerManagerConfiguration& config);
+        void setLogLevel(const std::string& category, Logger::log_level_type level);
+
+        Logger::log_level_type rootLevel();
+        Logger::log_level_type logLevel(const std::string& category);
+    };
+
+    LoggerRegistry::~LoggerRegistry()
+    {
+      for (Loggers::const_iterator it = _loggers.begin(); it != _loggers.end(); ++it)
+        delete it->second;
+
+      for (unsigned n = 0; n < _limiters.size(); ++n)
+        delete _limiters[n];
+    }
+
+    Logger* LoggerRegistry::getLogger(const std::string& category)
+    {
+      {
+        ReadLock lock(_mutex);
+        Loggers::const_iterator it = _loggers.find(category);
+        if (it != _loggers.end())
+          return it->second;
+      }
+
+      WriteLock lock(_mutex);
+
+      // check again, since another thread may have added it meanwhile
+      Loggers::iterator it = _loggers.lower_bound(category);
+      if (it != _loggers.end() && it->first == category)
+        return it->second;
+
+      Logger* logger = new Logger(category, _config.logLevel(category), _config.impl()->logLimiter(category));
+      _loggers.insert(it, Loggers::value_type(category, logger));
+
+      return logger;
+    }
+
+    // sets the levels and optionally the limiters of the existing loggers
+    // from the configuration; replaced limiters are kept, since other
+    // threads may still use them
+    void LoggerRegistry::updateLoggers(bool limiters)
+    {
+      for (Loggers::const_iterator it = _loggers.begin(); it != _loggers.end(); ++it)
+      {
+        it->second->setLogLevel(_config.logLevel(it->first));
+        if (limiters)
+        {
+          LogLimiter* limiter = it->second->setLimiter(_config.impl()->logLimiter(it->first));
+          if (limiter)
+            _limiters.push_back(limiter);
+        }
+      }
+    }
+
+    void LoggerRegistry::configure(const LoggerManagerConfiguration& config)
+    {
+      WriteLock lock(_mutex);
+      _config.impl()->setLevels(*config.impl());
+      updateLoggers(true);
+    }
+
+    void LoggerRegistry::setLogLevel(const std::string& category, Logger::log_level_type level)
+    {
+      WriteLock lock(_mutex);
+      _config.impl()->setLogLevel(category, level);
+      updateLoggers(false);
+    }
+
+    Logger::log_level_type LoggerRegistry::rootLevel()
+    {
+      ReadLock lock(_mutex);
+      return _config.rootLevel();
+    }
+
+    Logger::log_level_type LoggerRegistry::logLevel(const std::string& category)
+    {
+      ReadLock lock(_mutex);
+      return _config.logLevel(category);
+    }
+
+    LoggerRegistry& loggerRegistry()
+    {
+      static LoggerRegistry registry;
+      return registry;
+    }
+
+    bool readConfiguration(const std::string& fname, LoggerManagerConfiguration& config)
+    {
+      std::ifstream in(fname.c_str());
+      if (!in)
+        return false;
+
+      if (fname.size() >= 11 && fname.compare(fname.size() - 11, 11, ".properties") == 0)
+      {
+        PropertiesDeserializer d(in);
+        d.deserialize(config);
+      }
+      else
+      {
+        xml::XmlDeserializer d(in);
+        d.deserialize(config);
+      }
+
+      return true;
+    }
+
+    time_t modificationTime(const std::string& fname)
+    {
+      struct stat st;
+      return ::stat(fname.c_str(), &st) == 0 ? st.st_mtime : 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////
+    // ConfigWatcher - checks the configuration file periodically and
+    // applies changed log levels and limits
+    //
+    class ConfigWatcher
+    {
+        std::string _fname;
+        unsigned _interval;
+        time_t _mtime;
+        bool _running;
+        Mutex _mutex;
+        Condition _stop;
+        AttachedThread _thread;
+
+        void run();
+
+      public:
+        ConfigWatcher(const std::string& fname, unsigned interval);
+        ~ConfigWatcher();
+    };
+
+    ConfigWatcher* configWatcher = 0;
+
+    ConfigWatcher::ConfigWatcher(const std::string& fname, unsigned interval)
+      : _fname(fname),
+        _interval(interval),
+        _mtime(modificationTime(fname)),
+        _running(true),
+        _thread(callable(*this, &ConfigWatcher::run))
+    {
+      _thread.start();
+    }
+
+    ConfigWatcher::~ConfigWatcher()
+    {
+      {
+        MutexLock lock(_mutex);
+        _running = false;
+        _stop.signal();
+      }
+
+      _thread.join();
+    }
+
+    void ConfigWatcher::run()
+    {
+      MutexLock lock(_mutex);
+      while (true)
+      {
+        _stop.wait(lock, _interval * 1000);
+        if (!_running)
+          break;
+
+        time_t mtime = modificationTime(_fname);
+        if (mtime == _mtime)
+          continue;
+
+        _mtime = mtime;
+
+        try
+        {
+          LoggerManagerConfiguration config;
+          if (readConfiguration(_fname, config))
+            LoggerManager::getInstance().reconfigure(config);
+        }
+        catch (const std::exception& e)
+        {
+          std::cerr << "failed to reload logging configuration: " << e.what() << std::endl;
+        }
+      }
+    }
+  }
+
+  namespace
+  {
+    //////////////////////////////////////////////////////////////////////
+    // suppressed messages of the log limiters
+    //
+    LogLimiter::Clock logClock = ::time;
+
+    // limiters with suppressed messages, which are not reported yet; the
+    // reporter thread reports them, when no message starts a new second
+    Mutex suppressedMutex;
+    std::vector<LogLimiter*> suppressedLimiters;
+    Condition suppressedAdded;
+    AttachedThread* suppressedReporter = 0;
+    bool suppressedReporterStopped = false;
+
+    void runSuppressedReporter()
+    {
+      MutexLock lock(suppressedMutex);
+      while (!suppressedReporterStopped)
+      {
+        if (suppressedLimiters.empty())
+          suppressedAdded.wait(lock);
+        else
+        {
+          suppressedAdded.wait(lock, 1000);
+          lock.unlock();
+          LogLimiter::reportSuppressed();
+          lock.lock();
+        }
+      }
+    }
+
+    // called from ~LoggerManager; the remaining messages are reported
+    void stopSuppressedReporter()
+    {
+      AttachedThread* thread;
+
+      {
+        MutexLock lock(suppressedMutex);
+        suppressedReporterStopped = true;
+        suppressedAdded.signal();
+        thread = suppressedReporter;
+        suppressedReporter = 0;
+      }
+
+      delete thread;
+      LogLimiter::reportSuppressed(true);
+    }
+  }
+
   //////////////////////////////////////////////////////////////////////
   // LoggerManager
   //
   class LoggerManager::Impl
   {
       SmartPtr<LogAppender> _appender;
+      AsyncAppender* _asyncAppender;
+      RingBufferAppender* _ringBufferAppender;
       LoggerManagerConfiguration _config;
-      typedef std::map<std::string, Logger*> Loggers;  // map category => logger
-      Loggers _loggers;
 
       Impl(const Impl&);
       Impl& operator=(const Impl&);
 
     public:
       explicit Impl(const LoggerManagerConfiguration& config);
-      ~Impl();
 
-      Logger* getLogger(const std::string& category);
       LogAppender& appender()
       { return *_appender; }
+
+      // returns the appender, when logging is asynchronous and 0 otherwise
+      AsyncAppender* asyncAppender()
+      { return _asyncAppender; }
+
+      // returns the appender, when logging to a ring buffer and 0 otherwise
+      RingBufferAppender* ringBufferAppender()
+      { return _ringBufferAppender; }
     
-      Logger::log_level_type rootLevel() const
-      { return _config.rootLevel(); }
-      Logger::log_level_type logLevel(const std::string& category) const
-      { return _config.logLevel(category); }
+      const LogFormat& format() const
+      { return _config.impl()->format(); }
+
+      // true, when log entries are written as json objects
+      bool json() const
+      { return _config.impl()->json(); }
   };
 
   LoggerManager::Impl::Impl(const LoggerManagerConfiguration& config)
+    : _asyncAppender(0),
+      _ringBufferAppender(0)
   {
-    if (config.impl()->fname().empty())
+    if (!config.impl()->ringbuffer().empty())
+    {
+      // the ring buffer does not block, so it is never asynchronous
+      _ringBufferAppender = new RingBufferAppender(config.impl()->ringbuffer(), config.impl()->ringbuffersize());
+      _appender = _ringBufferAppender;
+    }
+    else if (config.impl()->fname().empty())
     {
       if (config.impl()->logport() != 0)
       {
-        _appender = new UdpAppender(config.impl()->loghost(), config.impl()->logport(), config.impl()->broadcast());
+        _appender = new UdpAppender(config.impl()->loghost(), config.impl()->logport(), config.impl()->broadcast(),
+                                    config.impl()->maxdatagram(), config.impl()->format().type != LogFormat::Syslog);
       }
       else
       {
@@ -643,26 +1809,44 @@ namespace cxxtools
       _appender = new RollingFileAppender(config.impl()->fname(), config.impl()->maxfilesize(), config.impl()->maxbackupindex());
     }
 
-    _config = config;
-  }
+    if (config.impl()->async() && _ringBufferAppender == 0)
+    {
+      _asyncAppender = new AsyncAppender(_appender.getPointer(), config.impl()->asyncqueuesize(), config.impl()->asyncblock(),
+                                         config.impl()->format());
+      _appender = _asyncAppender;
+    }
 
-  LoggerManager::Impl::~Impl()
-  {
-    for (Loggers::iterator it = _loggers.begin(); it != _loggers.end(); ++it)
-      delete it->second;
+    _config = config;
   }
 
   bool LoggerManager::_enabled = false;
 
   LoggerManager::LoggerManager()
   {
+    // the registry is created first, so that it is destroyed after the
+    // logger manager and the loggers stay valid as long as logging is
+    // enabled
+    loggerRegistry();
   }
 
   LoggerManager::~LoggerManager()
   {
-    MutexLock lock(logMutex);
-    delete _impl;
-    _enabled = false;
+    delete configWatcher;
+    configWatcher = 0;
+
+    stopSuppressedReporter();
+
+    Impl* impl;
+
+    {
+      WriteLock lock(implMutex);
+      impl = _impl;
+      _impl = 0;
+      _enabled = false;
+    }
+
+    // an asynchronous appender writes the pending messages when destroyed
+    delete impl;
   }
 
   LoggerManager& LoggerManager::getInstance()
@@ -671,108 +1855,273 @@ namespace cxxtools
     return loggerManager;
   }
 
-  void LoggerManager::logInit()
+  void LoggerManager::logInit()
+  {
+    std::string logXml = "log.xml";
+
+    if (FileInfo::exists(logXml))
+    {
+      logInit(logXml);
+    }
+    else
+    {
+      std::string logProperties = "log.properties";
+      if (FileInfo::exists(logProperties))
+        logInit(logProperties);
+    }
+  }
+
+  void LoggerManager::logInit(const std::string& fname)
+  {
+    try
+    {
+      LoggerManagerConfiguration config;
+      if (readConfiguration(fname, config))
+      {
+        getInstance().configure(config);
+
+        delete configWatcher;
+        configWatcher = 0;
+        if (config.impl()->watch() > 0)
+          configWatcher = new ConfigWatcher(fname, config.impl()->watch());
+      }
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << "failed to initialize logging: " << e.what() << std::endl;
+    }
+  }
+
+  void LoggerManager::logInit(const cxxtools::SerializationInfo& si)
+  {
+    LoggerManagerConfiguration config;
+    si >>= config;
+    getInstance().configure(config);
+  }
+
+  void LoggerManager::configure(const LoggerManagerConfiguration& config)
+  {
+    Impl* p = new Impl(config);
+    loggerRegistry().configure(config);
+
+    {
+      WriteLock lock(implMutex);
+      std::swap(_impl, p);
+      _enabled = true;
+    }
+
+    // the previous appenders are destroyed, when no message is written
+    // any more
+    delete p;
+  }
+
+  void LoggerManager::reconfigure(const LoggerManagerConfiguration& config)
+  {
+    loggerRegistry().configure(config);
+  }
+
+  void LoggerManager::setLogLevel(const std::string& category, Logger::log_level_type level)
+  {
+    loggerRegistry().setLogLevel(category, level);
+  }
+
+  unsigned long LoggerManager::mutexWaits()
+  {
+    return static_cast<unsigned long>(atomicGet(cxxtools::mutexWaits));
+  }
+
+  unsigned long LoggerManager::mutexWaitTime()
+  {
+    return static_cast<unsigned long>(atomicGet(cxxtools::mutexWaitTime));
+  }
+
+  Logger::log_level_type LoggerManager::rootLevel() const
+  {
+    return loggerRegistry().rootLevel();
+  }
+
+  Logger::log_level_type LoggerManager::logLevel(const std::string& category) const
+  {
+    return loggerRegistry().logLevel(category);
+  }
+
+  Logger* LoggerManager::getLogger(const std::string& category)
   {
-    std::string logXml = "log.xml";
-
-    if (FileInfo::exists(logXml))
-    {
-      logInit(logXml);
-    }
-    else
-    {
-      std::string logProperties = "log.properties";
-      if (FileInfo::exists(logProperties))
-        logInit(logProperties);
-    }
+    if (_impl == 0)
+      return 0;
+    return loggerRegistry().getLogger(category);
   }
 
-  void LoggerManager::logInit(const std::string& fname)
+  //////////////////////////////////////////////////////////////////////
+  // LogMessage
+  //
+  namespace
   {
-    std::ifstream in(fname.c_str());
-    if (in)
+    // index of the stream slot, which points to the LogMessage::Impl
+    // of the stream, so that LogField can add json fields
+    const int logFieldIndex = std::ios_base::xalloc();
+
+    // appends to a string, which keeps its capacity between messages
+    class LogStreamBuf : public std::streambuf
     {
-      try
-      {
-        if (fname.size() >= 11 && fname.compare(fname.size() - 11, 11, ".properties") == 0)
+        std::string& _str;
+
+      public:
+        explicit LogStreamBuf(std::string& str)
+          : _str(str)
+        { }
+
+      protected:
+        int_type overflow(int_type ch)
         {
-          PropertiesDeserializer d(in);
-          LoggerManagerConfiguration config;
-          d.deserialize(config);
-          getInstance().configure(config);
+          if (!traits_type::eq_int_type(ch, traits_type::eof()))
+            _str += traits_type::to_char_type(ch);
+          return traits_type::not_eof(ch);
         }
-        else
+
+        std::streamsize xsputn(const char* s, std::streamsize n)
         {
-          xml::XmlDeserializer d(in);
-          LoggerManagerConfiguration config;
-          d.deserialize(config);
-          getInstance().configure(config);
+          _str.append(s, n);
+          return n;
         }
-      }
-      catch (const std::exception& e)
+    };
+
+    // Integers are formatted without the locale facets of the stream, when
+    // no format flags are set.
+    bool defaultIntFormat(const std::ostream& out)
+    {
+      return out.good()
+          && out.width() == 0
+          && (out.flags() & (std::ios::hex | std::ios::oct | std::ios::showpos)) == 0;
+    }
+
+    void writeSigned(std::streambuf* sb, long v)
+    {
+      char digits[24];
+      char* end = digits + sizeof(digits);
+      char* p;
+      if (v < 0)
       {
-        std::cerr << "failed to initialize logging: " << e.what() << std::endl;
+        p = formatUnsigned(end, -static_cast<unsigned long long>(v));
+        *--p = '-';
       }
+      else
+        p = formatUnsigned(end, v);
+      sb->sputn(p, end - p);
+    }
+
+    void writeUnsigned(std::streambuf* sb, unsigned long v)
+    {
+      char digits[24];
+      char* end = digits + sizeof(digits);
+      char* p = formatUnsigned(end, v);
+      sb->sputn(p, end - p);
     }
   }
 
-  void LoggerManager::logInit(const cxxtools::SerializationInfo& si)
+  //////////////////////////////////////////////////////////////////////
+  // LogStream
+  //
+  LogStream& LogStream::operator<< (int n)
   {
-    LoggerManagerConfiguration config;
-    si >>= config;
-    getInstance().configure(config);
+    if (defaultIntFormat(*this))
+      writeSigned(rdbuf(), n);
+    else
+      static_cast<std::ostream&>(*this) << n;
+    return *this;
   }
 
-  void LoggerManager::configure(const LoggerManagerConfiguration& config)
+  LogStream& LogStream::operator<< (long n)
   {
-    Impl* p = new Impl(config);
-    delete _impl;
-    _impl = p;
-    _enabled = true;
+    if (defaultIntFormat(*this))
+      writeSigned(rdbuf(), n);
+    else
+      static_cast<std::ostream&>(*this) << n;
+    return *this;
   }
 
-  Logger::log_level_type LoggerManager::rootLevel() const
+  LogStream& LogStream::operator<< (unsigned n)
   {
-    return _impl->rootLevel();
+    if (defaultIntFormat(*this))
+      writeUnsigned(rdbuf(), n);
+    else
+      static_cast<std::ostream&>(*this) << n;
+    return *this;
   }
 
-  Logger::log_level_type LoggerManager::logLevel(const std::string& category) const
+  LogStream& LogStream::operator<< (unsigned long n)
   {
-    return _impl->logLevel(category);
+    if (defaultIntFormat(*this))
+      writeUnsigned(rdbuf(), n);
+    else
+      static_cast<std::ostream&>(*this) << n;
+    return *this;
   }
 
-  Logger* LoggerManager::getLogger(const std::string& category)
+  LogStream& LogStream::operator<< (char ch)
   {
-    if (_impl == 0)
-      return 0;
-    return _impl->getLogger(category);
+    if (good() && width() == 0)
+      rdbuf()->sputc(ch);
+    else
+      static_cast<std::ostream&>(*this) << ch;
+    return *this;
   }
 
-  Logger* LoggerManager::Impl::getLogger(const std::string& category)
+  LogStream& LogStream::operator<< (signed char ch)
   {
-    MutexLock lock(loggersMutex);
+    return *this << static_cast<char>(ch);
+  }
 
-    // check for existing loggers
-    Loggers::iterator it = _loggers.find(category);
-    if (it != _loggers.end())
-      return it->second;
+  LogStream& LogStream::operator<< (unsigned char ch)
+  {
+    return *this << static_cast<char>(ch);
+  }
 
-    Logger* ret = new Logger(category, logLevel(category));
-    _loggers[category] = ret;
+  LogStream& LogStream::operator<< (const char* s)
+  {
+    if (s != 0 && good() && width() == 0)
+      rdbuf()->sputn(s, strlen(s));
+    else
+      static_cast<std::ostream&>(*this) << s;
+    return *this;
+  }
 
-    return ret;
+  LogStream& LogStream::operator<< (const std::string& s)
+  {
+    if (good() && width() == 0)
+      rdbuf()->sputn(s.data(), s.size());
+    else
+      static_cast<std::ostream&>(*this) << s;
+    return *this;
   }
 
   //////////////////////////////////////////////////////////////////////
-  // LogMessage
+  // The buffers of a log message are kept per thread and reused, so that
+  // logging does not allocate memory, once they have grown large enough.
+  // A message, which is logged while another one of the same thread is
+  // built, e.g. from an output operator, gets its own buffers.
   //
   class LogMessage::Impl
   {
       Logger* _logger;
       const char* _level;
-      std::ostringstream _msg;
+      std::string _text;
+      LogStreamBuf _streambuf;
+      LogStream _msg;
+      std::string _fields;
+      std::string _entry;
+      bool _inUse;
 
     public:
+      Impl()
+        : _streambuf(_text),
+          _msg(&_streambuf),
+          _inUse(false)
+      { _msg.pword(logFieldIndex) = this; }
+
+      static Impl* getInstance();
+      static void releaseInstance(Impl* impl);
+
       void setLogger(Logger* logger)
       { _logger = logger; }
 
@@ -781,33 +2130,184 @@ namespace cxxtools
 
       void finish();
 
-      std::ostringstream& out()
+      LogStream& out()
       { return _msg; }
 
       std::string str()
-      { return _msg.str(); }
+      { return _text; }
+
+      // appends the field as json member
+      void addField(const LogField& field);
 
       void clear()
       {
         _msg.clear();
-        _msg.str(std::string());
+        _msg.flags(std::ios::dec | std::ios::skipws);
+        _msg.width(0);
+        _msg.precision(6);
+        _msg.fill(' ');
+        _text.clear();
+        _fields.clear();
       }
   };
 
   namespace
   {
-    LPool<LogMessage::Impl> logMessageImplPool;
+    pthread_key_t logMessageKey;
+    pthread_once_t logMessageOnce = PTHREAD_ONCE_INIT;
+
+    void deleteLogMessage(void* p)
+    {
+      delete static_cast<LogMessage::Impl*>(p);
+    }
+
+    void createLogMessageKey()
+    {
+      pthread_key_create(&logMessageKey, deleteLogMessage);
+    }
+  }
+
+  LogMessage::Impl* LogMessage::Impl::getInstance()
+  {
+    pthread_once(&logMessageOnce, createLogMessageKey);
+
+    Impl* impl = static_cast<Impl*>(pthread_getspecific(logMessageKey));
+    if (impl == 0)
+    {
+      impl = new Impl();
+      pthread_setspecific(logMessageKey, impl);
+    }
+    else if (impl->_inUse)
+    {
+      return new Impl();
+    }
+
+    impl->_inUse = true;
+    return impl;
+  }
+
+  void LogMessage::Impl::releaseInstance(Impl* impl)
+  {
+    if (impl->_inUse)
+    {
+      impl->clear();
+      impl->_inUse = false;
+    }
+    else
+    {
+      delete impl;
+    }
+  }
+
+  namespace
+  {
+    // formats the log entry into msg and passes it to the appender; msg
+    // may be swapped with another buffer
+    void putLogMessage(std::string& msg, const char* level, const std::string& category, const char* state,
+                       const std::string& text, const std::string& fields = std::string())
+    {
+      if (!LoggerManager::isEnabled())
+        return;
+
+      ReadLock implLock(implMutex);
+
+      LoggerManager::Impl* manager = LoggerManager::getInstance().impl();
+      if (manager == 0)
+        return;
+
+      msg.clear();
+      formatLogEntry(msg, level, category, state, text, fields, manager->format());
+
+      AsyncAppender* asyncAppender = manager->asyncAppender();
+      if (asyncAppender)
+      {
+        // the message is written in the background; fatal messages are
+        // written immediately
+        asyncAppender->putMessage(msg, level[0] == 'F');
+        return;
+      }
+
+      RingBufferAppender* ringBufferAppender = manager->ringBufferAppender();
+      if (ringBufferAppender)
+      {
+        // writing to the ring buffer is lock free
+        ringBufferAppender->putMessage(msg);
+        return;
+      }
+
+      ScopedAtomicIncrementer inc(mutexWaitCount);
+
+      // the time is only measured, when the mutex is held by another thread
+      if (!logMutex.tryLock())
+      {
+        struct timeval t0;
+        struct timeval t1;
+        gettimeofday(&t0, 0);
+        logMutex.lock();
+        gettimeofday(&t1, 0);
+
+        atomicIncrement(mutexWaits);
+        atomicExchangeAdd(mutexWaitTime, (t1.tv_sec - t0.tv_sec) * 1000000 + (t1.tv_usec - t0.tv_usec));
+      }
+
+      MutexLock lock(logMutex, false, true);
+
+      LogAppender& appender = manager->appender();
+      appender.putMessage(msg);
+      appender.finish((atomicGet(mutexWaitCount) <= 1));
+    }
+  }
+
+  unsigned dumpLogRingBuffer(const std::string& fname, std::ostream& out)
+  {
+    RingBuffer buffer(fname);
+
+    uint64_t end = ringPosGet(buffer.header().pos);
+    uint64_t pos = end > buffer.size() ? end - buffer.size() : 0;
+
+    unsigned count = 0;
+    std::string msg;
+    while (end - pos >= ringRecordHeaderSize)
+    {
+      uint32_t head[2];
+      buffer.read(pos, head, sizeof(head));
+      uint64_t recordPos = ringPosGet(buffer.recordPos(pos));
+
+      if (head[0] != ringRecordMagic
+        || recordPos != pos
+        || head[1] > end - pos - ringRecordHeaderSize)
+      {
+        // incomplete or overwritten record; search the next one
+        pos += 8;
+        continue;
+      }
+
+      msg.resize(head[1]);
+      if (head[1] > 0)
+        buffer.read(pos + ringRecordHeaderSize, &msg[0], head[1]);
+
+      // skip the record, when it was overwritten while reading
+      if (ringPosGet(buffer.recordPos(pos)) == pos)
+      {
+        out << msg << '\n';
+        ++count;
+      }
+
+      pos += (ringRecordHeaderSize + head[1] + 7) & ~uint64_t(7);
+    }
+
+    return count;
   }
 
   LogMessage::LogMessage(Logger* logger, const char* level)
-    : _impl(logMessageImplPool.getInstance())
+    : _impl(Impl::getInstance())
   {
     _impl->setLogger(logger);
     _impl->setLevel(level);
   }
 
   LogMessage::LogMessage(Logger* logger, Logger::log_level_type level)
-    : _impl(logMessageImplPool.getInstance())
+    : _impl(Impl::getInstance())
   {
     _impl->setLogger(logger);
     _impl->setLevel(level >= Logger::LOG_LEVEL_TRACE ? "TRACE"
@@ -823,14 +2323,14 @@ namespace cxxtools
     if (_impl)
     {
       _impl->finish();
-      logMessageImplPool.releaseInstance(_impl);
+      Impl::releaseInstance(_impl);
     }
   }
 
   void LogMessage::finish()
   {
     _impl->finish();
-    logMessageImplPool.releaseInstance(_impl);
+    Impl::releaseInstance(_impl);
     _impl = 0;
   }
 
@@ -838,30 +2338,242 @@ namespace cxxtools
   {
     try
     {
-      ScopedAtomicIncrementer inc(mutexWaitCount);
-      MutexLock lock(logMutex);
+      putLogMessage(_entry, _level, _logger->getCategory(), "", _text, _fields);
+    }
+    catch (const std::exception&)
+    {
+    }
 
-      if (!LoggerManager::isEnabled())
+    clear();
+  }
+
+  LogStream& LogMessage::out()
+  {
+    return _impl->out();
+  }
+
+  void LogMessage::Impl::addField(const LogField& field)
+  {
+    _fields += ",\"";
+    jsonStringOut(_fields, field.key(), strlen(field.key()));
+    _fields += "\":";
+
+    switch (field.type())
+    {
+      case LogField::StringType:
+        _fields += '"';
+        jsonStringOut(_fields, field.stringValue(), field.stringLength());
+        _fields += '"';
+        break;
+
+      case LogField::IntType:
+        if (field.intValue() < 0)
+        {
+          _fields += '-';
+          putUnsigned(_fields, -static_cast<unsigned long long>(field.intValue()));
+        }
+        else
+          putUnsigned(_fields, field.intValue());
+        break;
+
+      case LogField::UnsignedType:
+        putUnsigned(_fields, field.unsignedValue());
+        break;
+
+      case LogField::FloatType:
+        {
+          double d = field.floatValue();
+          if (d != d || d - d != 0)  // nan and inf are not valid json
+            _fields += "null";
+          else
+            putFloat(std::back_insert_iterator<std::string>(_fields), d);
+        }
+        break;
+
+      case LogField::BoolType:
+        _fields += field.boolValue() ? "true" : "false";
+        break;
+    }
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // LogLimiter
+  //
+  LogLimiter::LogLimiter(unsigned limit, double sample)
+    : _limit(limit),
+      _sample(sample >= 1.0 ? 0x100000000ull
+            : sample <= 0.0 ? 0
+            : static_cast<unsigned long long>(sample * 0x100000000ull)),
+      _second(0),
+      _count(0),
+      _suppressed(0),
+      _sequence(0),
+      _pending(false),
+      _logger(0),
+      _file(0),
+      _line(0)
+  { }
+
+  LogLimiter::~LogLimiter()
+  {
+    MutexLock lock(suppressedMutex);
+    if (_pending)
+      suppressedLimiters.erase(std::find(suppressedLimiters.begin(), suppressedLimiters.end(), this));
+  }
+
+  void LogLimiter::suppress(Logger* logger, const char* file, int line)
+  {
+    // the first suppressed message registers the limiter for the report
+    if (atomicIncrement(_suppressed) != 1)
+      return;
+
+    MutexLock lock(suppressedMutex);
+    if (_pending)
+      return;
+
+    _pending = true;
+    _logger = logger;
+    _file = file;
+    _line = line;
+    suppressedLimiters.push_back(this);
+
+    if (suppressedReporter == 0 && !suppressedReporterStopped)
+    {
+      suppressedReporter = new AttachedThread(callable(runSuppressedReporter));
+      suppressedReporter->start();
+    }
+    else
+      suppressedAdded.signal();
+  }
+
+  void LogLimiter::report()
+  {
+    Logger* logger;
+    const char* file;
+    int line;
+    atomic_t suppressed;
+
+    {
+      MutexLock lock(suppressedMutex);
+      if (!_pending)
         return;
 
-      std::string msg;
-      logentry(msg, _level, _logger->getCategory());
-      msg += _msg.str();
+      _pending = false;
+      suppressedLimiters.erase(std::find(suppressedLimiters.begin(), suppressedLimiters.end(), this));
+      logger = _logger;
+      file = _file;
+      line = _line;
+      suppressed = atomicExchange(_suppressed, 0);
+    }
 
-      LogAppender& appender = LoggerManager::getInstance().impl()->appender();
-      appender.putMessage(msg);
-      appender.finish((atomicGet(mutexWaitCount) <= 1));
+    if (suppressed > 0)
+    {
+      LogMessage msg(logger, Logger::LOG_LEVEL_WARN);
+      msg.out() << suppressed << " log messages suppressed";
+      if (file)
+        msg.out() << " at " << file << ':' << line;
+      msg.finish();
     }
-    catch (const std::exception&)
+  }
+
+  void LogLimiter::reportSuppressed(bool all)
+  {
+    atomic_t now = static_cast<atomic_t>(logClock(0));
+
+    std::vector<LogLimiter*> limiters;
+
     {
+      MutexLock lock(suppressedMutex);
+      for (unsigned n = 0; n < suppressedLimiters.size(); ++n)
+        if (all || atomicGet(suppressedLimiters[n]->_second) != now)
+          limiters.push_back(suppressedLimiters[n]);
     }
 
-    clear();
+    // limiters are only destroyed with their logger or at exit, so they
+    // are still valid here
+    for (unsigned n = 0; n < limiters.size(); ++n)
+      limiters[n]->report();
   }
 
-  std::ostream& LogMessage::out()
+  void LogLimiter::setClock(Clock clock)
   {
-    return _impl->out();
+    logClock = clock ? clock : ::time;
+  }
+
+  bool LogLimiter::pass(Logger* logger, const char* file, int line)
+  {
+    atomic_t now = static_cast<atomic_t>(logClock(0));
+    atomic_t second = atomicGet(_second);
+    if (now != second && atomicCompareExchange(_second, now, second) == second)
+    {
+      // the first message in a new second reports the suppressed
+      // messages of the previous seconds
+      atomicSet(_count, 0);
+      report();
+    }
+
+    // sampling with a multiplicative hash of a sequence number spreads
+    // the logged messages evenly
+    if (_sample <= 0xffffffffull)
+    {
+      uint32_t h = static_cast<uint32_t>(atomicIncrement(_sequence)) * 2654435761u;
+      if (h >= _sample)
+      {
+        suppress(logger, file, line);
+        return false;
+      }
+    }
+
+    if (_limit > 0 && atomicIncrement(_count) > static_cast<atomic_t>(_limit))
+    {
+      suppress(logger, file, line);
+      return false;
+    }
+
+    return true;
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  // LogField
+  //
+  LogField::LogField(const char* key, const char* value)
+    : _key(key),
+      _type(StringType),
+      _str(value),
+      _len(strlen(value))
+  { }
+
+  std::ostream& operator<< (std::ostream& out, const LogField& field)
+  {
+    LogMessage::Impl* impl = static_cast<LogMessage::Impl*>(out.pword(logFieldIndex));
+    if (impl != 0 && LoggerManager::isEnabled())
+    {
+      bool json;
+
+      {
+        ReadLock implLock(implMutex);
+        LoggerManager::Impl* manager = LoggerManager::getInstance().impl();
+        json = manager != 0 && manager->json();
+      }
+
+      if (json)
+      {
+        impl->addField(field);
+        return out;
+      }
+    }
+
+    out << ' ' << field.key() << '=';
+    switch (field.type())
+    {
+      case LogField::StringType:   out.write(field.stringValue(), field.stringLength()); break;
+      case LogField::IntType:      out << field.intValue(); break;
+      case LogField::UnsignedType: out << field.unsignedValue(); break;
+      case LogField::FloatType:    out << field.floatValue(); break;
+      case LogField::BoolType:     out << (field.boolValue() ? "true" : "false"); break;
+    }
+
+    return out;
   }
 
   std::string LogMessage::str() const
@@ -943,20 +2655,8 @@ namespace cxxtools
   {
     try
     {
-      ScopedAtomicIncrementer inc(mutexWaitCount);
-      MutexLock lock(logMutex);
-
-      if (!LoggerManager::isEnabled())
-        return;
-
       std::string msg;
-      logentry(msg, "TRACE", _logger->getCategory());
-      msg += state;
-      msg += _msg.str();
-
-      LogAppender& appender = LoggerManager::getInstance().impl()->appender();
-      appender.putMessage(msg);
-      appender.finish((atomicGet(mutexWaitCount) <= 1));
+      putLogMessage(msg, "TRACE", _logger->getCategory(), state, _msg.str());
     }
     catch (const std::exception&)
     {
@@ -38,6 +38,7 @@ SerializationInfo::SerializationInfo()
 : _parent(0)
 , _category(Void)
 , _t(t_none)
+, _used(0)
 { }
 
 
@@ -48,7 +49,8 @@ SerializationInfo::SerializationInfo(const SerializationInfo& si)
 , _type(si._type)
 , _u(si._u)
 , _t(si._t)
-, _nodes(si._nodes)
+, _nodes(si._nodes.begin(), si._nodes.begin() + si._used)
+, _used(si._used)
 {
     switch (_t)
     {
@@ -66,11 +68,15 @@ SerializationInfo::SerializationInfo(const SerializationInfo& si)
 
 SerializationInfo& SerializationInfo::operator=(const SerializationInfo& si)
 {
+    if (this == &si)
+        return *this;
+
     _parent = si._parent;
     _category = si._category;
     _name = si._name;
     _type = si._type;
-    _nodes = si._nodes;
+    _nodes.assign(si._nodes.begin(), si._nodes.begin() + si._used);
+    _used = si._used;
 
     if (si._t == t_string)
         _setString( si._String() );
@@ -95,9 +101,14 @@ void SerializationInfo::reserve(size_t n)
 
 SerializationInfo& SerializationInfo::addMember(const std::string& name)
 {
-    _nodes.resize(_nodes.size() + 1);
-    _nodes.back().setParent(*this);
-    _nodes.back().setName(name);
+    if (_used < _nodes.size())
+        _nodes[_used].recycle();
+    else
+        _nodes.resize(_used + 1);
+
+    SerializationInfo& member = _nodes[_used++];
+    member.setParent(*this);
+    member.setName(name);
 
     // category Array overrides Object (is this a hack?)
     // This is needed for xmldeserialization. In the xml file the root node of a array
@@ -107,13 +118,13 @@ SerializationInfo& SerializationInfo::addMember(const std::string& name)
     if (_category != Array)
         _category = Object;
 
-    return _nodes.back();
+    return member;
 }
 
 
 SerializationInfo::Iterator SerializationInfo::begin()
 {
-    if(_nodes.size() == 0)
+    if(_used == 0)
         return 0;
 
     return &( _nodes[0] );
@@ -122,16 +133,16 @@ SerializationInfo::Iterator SerializationInfo::begin()
 
 SerializationInfo::Iterator SerializationInfo::end()
 {
-    if(_nodes.size() == 0)
+    if(_used == 0)
         return 0;
 
-    return &_nodes[0] + _nodes.size();
+    return &_nodes[0] + _used;
 }
 
 
 SerializationInfo::ConstIterator SerializationInfo::begin() const
 {
-    if(_nodes.size() == 0)
+    if(_used == 0)
         return 0;
 
     return &( _nodes[0] );
@@ -140,32 +151,39 @@ SerializationInfo::ConstIterator SerializationInfo::begin() const
 
 SerializationInfo::ConstIterator SerializationInfo::end() const
 {
-    if(_nodes.size() == 0)
+    if(_used == 0)
         return 0;
 
-    return &_nodes[0] + _nodes.size();
+    return &_nodes[0] + _used;
 }
 
 
 const SerializationInfo& SerializationInfo::getMember(const std::string& name) const
 {
-    Nodes::const_iterator it = _nodes.begin();
-    for(; it != _nodes.end(); ++it)
-    {
-        if( it->name() == name )
-            return *it;
-    }
+    const SerializationInfo* si = findMember(name);
+    if (si == 0)
+        throw SerializationMemberNotFound(name);
+
+    return *si;
+}
+
+
+const SerializationInfo& SerializationInfo::getMember(const std::string& name, Hint& hint) const
+{
+    const SerializationInfo* si = findMember(name, hint);
+    if (si == 0)
+        throw SerializationMemberNotFound(name);
 
-    throw SerializationMemberNotFound(name);
+    return *si;
 }
 
 
 const SerializationInfo& SerializationInfo::getMember(unsigned idx) const
 {
-    if (idx >= _nodes.size())
+    if (idx >= _used)
     {
         std::ostringstream msg;
-        msg << "requested member index " << idx << " exceeds number of members " << _nodes.size();
+        msg << "requested member index " << idx << " exceeds number of members " << _used;
         throw std::range_error(msg.str());
     }
 
@@ -175,11 +193,10 @@ const SerializationInfo& SerializationInfo::getMember(unsigned idx) const
 
 const SerializationInfo* SerializationInfo::findMember(const std::string& name) const
 {
-    Nodes::const_iterator it = _nodes.begin();
-    for(; it != _nodes.end(); ++it)
+    for (Nodes::size_type n = 0; n < _used; ++n)
     {
-        if( it->name() == name )
-            return &(*it);
+        if (_nodes[n].name() == name)
+            return &_nodes[n];
     }
 
     return 0;
@@ -188,22 +205,51 @@ const SerializationInfo* SerializationInfo::findMember(const std::string& name)
 
 SerializationInfo* SerializationInfo::findMember(const std::string& name)
 {
-    Nodes::iterator it = _nodes.begin();
-    for(; it != _nodes.end(); ++it)
+    return const_cast<SerializationInfo*>(
+        static_cast<const SerializationInfo*>(this)->findMember(name));
+}
+
+
+const SerializationInfo* SerializationInfo::findMember(const std::string& name, Hint& hint) const
+{
+    // Start searching at the hint and wrap around to the beginning.
+    Nodes::size_type start = hint._pos < _used ? hint._pos : 0;
+
+    for (Nodes::size_type n = start; n < _used; ++n)
     {
-        if( it->name() == name )
-            return &(*it);
+        if (_nodes[n].name() == name)
+        {
+            hint._pos = n + 1;
+            return &_nodes[n];
+        }
+    }
+
+    for (Nodes::size_type n = 0; n < start; ++n)
+    {
+        if (_nodes[n].name() == name)
+        {
+            hint._pos = n + 1;
+            return &_nodes[n];
+        }
     }
 
     return 0;
 }
 
+
+SerializationInfo* SerializationInfo::findMember(const std::string& name, Hint& hint)
+{
+    return const_cast<SerializationInfo*>(
+        static_cast<const SerializationInfo*>(this)->findMember(name, hint));
+}
+
 void SerializationInfo::clear()
 {
     _category = Void;
     _name.clear();
     _type.clear();
     _nodes.clear();
+    _used = 0;
     switch (_t)
     {
         case t_string: _String().clear(); break;
@@ -212,6 +258,30 @@ void SerializationInfo::clear()
     }
 }
 
+void SerializationInfo::recycle()
+{
+    _category = Void;
+    _name.clear();
+    _type.clear();
+    _releaseValue();
+    _t = t_none;
+
+    // do not keep more nodes than needed for similar data
+    Nodes::size_type keep = 2 * _used + 16;
+    if (_nodes.size() > keep)
+        _nodes.erase(_nodes.begin() + keep, _nodes.end());
+
+    _used = 0;
+}
+
+void SerializationInfo::shrink()
+{
+    _nodes.erase(_nodes.begin() + _used, _nodes.end());
+    for (Nodes::iterator it = _nodes.begin(); it != _nodes.end(); ++it)
+        it->shrink();
+}
+
+
 void SerializationInfo::swap(SerializationInfo& si)
 {
     if (this == &si)
@@ -308,6 +378,7 @@ void SerializationInfo::swap(SerializationInfo& si)
     }
 
     _nodes.swap(si._nodes);
+    std::swap(_used, si._used);
 }
 
 void SerializationInfo::dump(std::ostream& out, const std::string& praefix) const
@@ -345,10 +416,10 @@ void SerializationInfo::dump(std::ostream& out, const std::string& praefix) cons
 
     if (!_type.empty())
         out << praefix << "typeName = " << _type << '\n';
-    if (!_nodes.empty())
+    if (_used > 0)
     {
         std::string p = praefix + '\t';
-        for (std::vector<SerializationInfo>::size_type n = 0; n < _nodes.size(); ++n)
+        for (std::vector<SerializationInfo>::size_type n = 0; n < _used; ++n)
         {
             out << praefix << "node[" << n << "]\n";
             _nodes[n].dump(out, p);
@@ -431,6 +502,22 @@ void SerializationInfo::_setString8(const char* value)
     _category = Value;
 }
 
+void SerializationInfo::_setString8(const char* value, std::size_t len)
+{
+    if (_t != t_string8)
+    {
+        _releaseValue();
+        new (_String8Ptr()) std::string(value, len);
+        _t = t_string8;
+    }
+    else
+    {
+        _String8().assign(value, len);
+    }
+
+    _category = Value;
+}
+
 void SerializationInfo::_setChar(char value)
 {
     if (_t != t_char)
@@ -702,7 +789,13 @@ long double SerializationInfo::_getFloat(const char* type, long double max) cons
 
         case t_string:  try
                         {
-                            ret = convert<long double>(_String());
+                            // parse with the precision of the target type
+                            if (max <= std::numeric_limits<float>::max())
+                                ret = convert<float>(_String());
+                            else if (max <= std::numeric_limits<double>::max())
+                                ret = convert<double>(_String());
+                            else
+                                ret = convert<long double>(_String());
                         }
                         catch (const ConversionError&)
                         {
@@ -712,7 +805,13 @@ long double SerializationInfo::_getFloat(const char* type, long double max) cons
 
         case t_string8: try
                         {
-                            ret = convert<long double>(_String8());
+                            // parse with the precision of the target type
+                            if (max <= std::numeric_limits<float>::max())
+                                ret = convert<float>(_String8());
+                            else if (max <= std::numeric_limits<double>::max())
+                                ret = convert<double>(_String8());
+                            else
+                                ret = convert<long double>(_String8());
                         }
                         catch (const ConversionError&)
                         {
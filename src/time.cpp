@@ -111,23 +111,24 @@ void operator >>=(const SerializationInfo& si, Time& time)
     if (si.category() == cxxtools::SerializationInfo::Object)
     {
         unsigned short hour, min, sec, msec;
+        cxxtools::SerializationInfo::Hint hint;
 
-        si.getMember("hour") >>= hour;
+        si.getMember("hour", hint) >>= hour;
 
         const cxxtools::SerializationInfo* p;
 
-        if ((p = si.findMember("minute")) != 0)
+        if ((p = si.findMember("minute", hint)) != 0)
             *p >>= min;
         else
-            si.getMember("min") >>= min;
+            si.getMember("min", hint) >>= min;
 
-        if ((p = si.findMember("second")) != 0)
+        if ((p = si.findMember("second", hint)) != 0)
             *p >>= sec;
         else
-            si.getMember("sec") >>= sec;
+            si.getMember("sec", hint) >>= sec;
 
-        if ((p = si.findMember("millisecond")) != 0
-            || (p = si.findMember("msec")) != 0)
+        if ((p = si.findMember("millisecond", hint)) != 0
+            || (p = si.findMember("msec", hint)) != 0)
             *p >>= msec;
         else
             msec = 0;
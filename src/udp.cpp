@@ -26,6 +26,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include "config.h"
 #include <cxxtools/net/addrinfo.h>
 #include "addrinfoimpl.h"
 #include <cxxtools/net/udp.h>
@@ -104,6 +105,47 @@ namespace net
     return send(message.data(), message.size(), flags);
   }
 
+  UdpSender::size_type UdpSender::sendBatch(const std::string* messages, size_type count,
+    int flags) const
+  {
+#ifdef HAVE_SENDMMSG
+    static const unsigned maxBatch = 64;
+    struct mmsghdr msgs[maxBatch];
+    struct iovec iov[maxBatch];
+
+    size_type sent = 0;
+    while (sent < count)
+    {
+      unsigned n = count - sent < maxBatch ? count - sent : maxBatch;
+
+      memset(msgs, 0, n * sizeof(msgs[0]));
+      for (unsigned i = 0; i < n; ++i)
+      {
+        iov[i].iov_base = const_cast<char*>(messages[sent + i].data());
+        iov[i].iov_len = messages[sent + i].size();
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+      }
+
+      int ret = ::sendmmsg(getFd(), msgs, n, flags);
+      if (ret < 0)
+      {
+        if (sent > 0)
+          break;
+        throw SystemError("sendmmsg");
+      }
+
+      sent += ret;
+    }
+
+    return sent;
+#else
+    for (size_type n = 0; n < count; ++n)
+      send(messages[n], flags);
+    return count;
+#endif
+  }
+
   UdpSender::size_type UdpSender::recv(void* buffer, size_type length,
     int flags) const
   {
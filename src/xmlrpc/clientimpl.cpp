@@ -51,8 +51,9 @@ inline void operator >>=(const cxxtools::SerializationInfo& si, RemoteException&
 {
     int faultCode;
     std::string faultString;
-    si.getMember("faultCode") >>= faultCode;
-    si.getMember("faultString") >>= faultString;
+    SerializationInfo::Hint hint;
+    si.getMember("faultCode", hint) >>= faultCode;
+    si.getMember("faultString", hint) >>= faultString;
     fault.rc(faultCode);
     fault.text(faultString);
 }
@@ -34,6 +34,7 @@
 #include <cxxtools/serializationerror.h>
 #include <cxxtools/deserializerbase.h>
 #include <cxxtools/composer.h>
+#include <cxxtools/convert.h>
 
 namespace cxxtools
 {
@@ -47,6 +48,30 @@ namespace
     {
         SerializationError::doThrow(msg);
     }
+
+    // Integers are parsed here, so that they need not be converted from
+    // strings later. Values, which do not parse, are kept as strings.
+    // Doubles are kept as text, so that they are converted with the
+    // precision of the target type.
+    void setScalarValue(DeserializerBase& deserializer, const String& type, const String& value)
+    {
+        if (type == L"int" || type == L"i4")
+        {
+            std::string s = value.narrow();
+            const char* b = s.data();
+            const char* e = b + s.size();
+            bool ok = false;
+
+            DeserializerBase::int_type i;
+            if (getInt(b, e, ok, i) == e && ok)
+            {
+                deserializer.setValue(i);
+                return;
+            }
+        }
+
+        deserializer.setValue(value);
+    }
 }
 
 void Scanner::begin(DeserializerBase& handler, IComposer& composer)
@@ -300,7 +325,7 @@ bool Scanner::advance(const cxxtools::xml::Node& node)
                 const xml::Characters& chars = static_cast<const xml::Characters&>(node);
                 _state = OnScalar;
 
-                _deserializer->setValue( chars.content() );
+                setScalarValue(*_deserializer, _type, chars.content());
             }
             else if(node.type() == xml::Node::EndElement) // no content, for example empty strings
             {
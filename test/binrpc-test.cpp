@@ -32,6 +32,14 @@
 #include "cxxtools/remoteexception.h"
 #include "cxxtools/remoteprocedure.h"
 #include "cxxtools/eventloop.h"
+#include "cxxtools/hedgedclient.h"
+#include "cxxtools/balancingclient.h"
+#include "cxxtools/ioerror.h"
+#include "cxxtools/thread.h"
+#include "cxxtools/mutex.h"
+#include "cxxtools/condition.h"
+#include "cxxtools/atomicity.h"
+#include "cxxtools/clock.h"
 #include "cxxtools/log.h"
 #include <stdlib.h>
 #include <sstream>
@@ -76,13 +84,41 @@ class BinRpcTest : public cxxtools::unit::TestSuite
     private:
         cxxtools::EventLoop _loop;
         cxxtools::bin::RpcServer* _server;
-        unsigned _count;
+        // incremented by the server threads
+        cxxtools::atomic_t _count;
         unsigned short _port;
 
+        // blocks server methods until opened by the test
+        cxxtools::Mutex _gateMutex;
+        cxxtools::Condition _gateOpened;
+        bool _gateOpen;
+
+        void closeGate()
+        {
+            cxxtools::MutexLock lock(_gateMutex);
+            _gateOpen = false;
+        }
+
+        void openGate()
+        {
+            cxxtools::MutexLock lock(_gateMutex);
+            _gateOpen = true;
+            _gateOpened.broadcast();
+        }
+
+        void waitGate()
+        {
+            cxxtools::MutexLock lock(_gateMutex);
+            while (!_gateOpen)
+                _gateOpened.wait(lock);
+        }
+
     public:
         BinRpcTest()
         : cxxtools::unit::TestSuite("binrpc"),
-            _port(7003)
+            _count(0),
+            _port(7003),
+            _gateOpen(true)
         {
             registerMethod("Nothing", *this, &BinRpcTest::Nothing);
             registerMethod("Boolean", *this, &BinRpcTest::Boolean);
@@ -105,6 +141,16 @@ class BinRpcTest : public cxxtools::unit::TestSuite
             registerMethod("CallbackException", *this, &BinRpcTest::CallbackException);
             registerMethod("ConnectError", *this, &BinRpcTest::ConnectError);
             registerMethod("BigRequest", *this, &BinRpcTest::BigRequest);
+            registerMethod("EventDriven", *this, &BinRpcTest::EventDriven);
+            registerMethod("EventDrivenFault", *this, &BinRpcTest::EventDrivenFault);
+            registerMethod("Compression", *this, &BinRpcTest::Compression);
+            registerMethod("FrameSizeLimit", *this, &BinRpcTest::FrameSizeLimit);
+            registerMethod("Dictionary", *this, &BinRpcTest::Dictionary);
+            registerMethod("Deadline", *this, &BinRpcTest::Deadline);
+            registerMethod("Hedged", *this, &BinRpcTest::Hedged);
+            registerMethod("HedgedFailover", *this, &BinRpcTest::HedgedFailover);
+            registerMethod("Balancing", *this, &BinRpcTest::Balancing);
+            registerMethod("BalancingMaxIdle", *this, &BinRpcTest::BalancingMaxIdle);
 
             char* PORT = getenv("UTEST_PORT");
             if (PORT)
@@ -131,6 +177,7 @@ class BinRpcTest : public cxxtools::unit::TestSuite
 
         void tearDown()
         {
+            openGate();
             delete _server;
         }
 
@@ -166,15 +213,15 @@ class BinRpcTest : public cxxtools::unit::TestSuite
 
             multiply.begin();
 
-            _count = 0;
+            cxxtools::atomicSet(_count, 0);
             CXXTOOLS_UNIT_ASSERT_THROW(_loop.run(), std::runtime_error);
-            CXXTOOLS_UNIT_ASSERT_EQUALS(_count, 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::atomicGet(_count), 1);
         }
 
         void onExceptionCallback(const cxxtools::RemoteResult<bool>& r)
         {
             log_warn("exception callback");
-            ++_count;
+            cxxtools::atomicIncrement(_count);
             _loop.exit();
             throw std::runtime_error("my error");
         }
@@ -676,6 +723,362 @@ class BinRpcTest : public cxxtools::unit::TestSuite
             return v.size();
         }
 
+        ////////////////////////////////////////////////////////////
+        // EventDriven
+        //
+        void EventDriven()
+        {
+            _server->eventDriven(true);
+            _server->registerMethod("multiply", *this, &BinRpcTest::multiplyInt);
+
+            cxxtools::bin::RpcClient client(_loop, "", _port);
+            cxxtools::RemoteProcedure<int, int, int> multiply(client, "multiply");
+
+            multiply.begin(2, 3);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(multiply.end(2000), 6);
+
+            multiply.begin(4, 5);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(multiply.end(2000), 20);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // EventDrivenFault
+        //
+        void EventDrivenFault()
+        {
+            _server->eventDriven(true);
+            _server->registerMethod("multiply", *this, &BinRpcTest::throwFault);
+
+            cxxtools::bin::RpcClient client(_loop, "", _port);
+            cxxtools::RemoteProcedure<bool> multiply(client, "multiply");
+            multiply.begin();
+
+            try
+            {
+                multiply.end(2000);
+                CXXTOOLS_UNIT_ASSERT_MSG(false, "cxxtools::RemoteException exception expected");
+            }
+            catch (const cxxtools::RemoteException& e)
+            {
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.rc(), 7);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.text(), "Fault");
+            }
+        }
+
+
+        ////////////////////////////////////////////////////////////
+        // Compression
+        //
+        void Compression()
+        {
+            _server->registerMethod("fill", *this, &BinRpcTest::fill);
+            _server->registerMethod("countSize", *this, &BinRpcTest::countSize);
+
+            cxxtools::bin::RpcClient client(_loop, "", _port);
+            client.compressionThreshold(100);
+
+            cxxtools::RemoteProcedure<std::vector<int>, int, int> fill(client, "fill");
+            cxxtools::RemoteProcedure<unsigned, std::vector<int> > countSize(client, "countSize");
+
+            // small request and big reply
+            fill.begin(5000, 42);
+            std::vector<int> v = fill.end(2000);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(v.size(), 5000);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(v[4999], 42);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(client.compressionStatistics().frames, 1);
+
+            // big request and small reply
+            countSize.begin(v);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(countSize.end(2000), 5000);
+
+            cxxtools::bin::CompressionStatistics clientStatistics = client.compressionStatistics();
+            cxxtools::bin::CompressionStatistics serverStatistics = _server->compressionStatistics();
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(clientStatistics.frames, 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(serverStatistics.frames, 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(clientStatistics.uncompressedBytes, serverStatistics.uncompressedBytes);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(clientStatistics.compressedBytes, serverStatistics.compressedBytes);
+            CXXTOOLS_UNIT_ASSERT(clientStatistics.ratio() > 1);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // FrameSizeLimit
+        //
+        void FrameSizeLimit()
+        {
+            _server->registerMethod("countSize", *this, &BinRpcTest::countSize);
+            _server->maxFrameSize(1000);
+
+            std::vector<int> v(5000, 42);
+
+            {
+                cxxtools::bin::RpcClient client(_loop, "", _port);
+                client.compressionThreshold(100);
+
+                cxxtools::RemoteProcedure<unsigned, std::vector<int> > countSize(client, "countSize");
+
+                countSize.begin(v);
+                CXXTOOLS_UNIT_ASSERT_THROW(countSize.end(2000), std::exception);
+            }
+
+            // frames within the limit are accepted
+            cxxtools::bin::RpcClient client(_loop, "", _port);
+            client.compressionThreshold(100);
+
+            cxxtools::RemoteProcedure<unsigned, std::vector<int> > countSize(client, "countSize");
+
+            v.resize(100);
+            countSize.begin(v);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(countSize.end(2000), 100);
+        }
+
+        std::vector<int> fill(int count, int value)
+        {
+            return std::vector<int>(count, value);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Dictionary
+        //
+        void Dictionary()
+        {
+            _server->registerMethod("multiply", *this, &BinRpcTest::multiplyColors);
+
+            cxxtools::bin::RpcClient client(_loop, "", _port);
+            client.useDictionary(true);
+
+            cxxtools::RemoteProcedure<std::vector<Color>, std::vector<Color>, int> multiply(client, "multiply");
+
+            std::vector<Color> v;
+            for (int n = 0; n < 100; ++n)
+            {
+                Color c;
+                c.red = n;
+                c.green = n + 1;
+                c.blue = n + 2;
+                v.push_back(c);
+            }
+
+            multiply.begin(v, 2);
+            std::vector<Color> r = multiply.end(2000);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(r.size(), 100);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(r[0].red, 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(r[99].red, 198);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(r[99].green, 200);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(r[99].blue, 202);
+
+            // the connection is reused without dictionary
+            client.useDictionary(false);
+            multiply.begin(v, 3);
+            r = multiply.end(2000);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(r.size(), 100);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(r[99].blue, 303);
+        }
+
+        std::vector<Color> multiplyColors(const std::vector<Color>& v, int f)
+        {
+            std::vector<Color> r(v);
+            for (unsigned n = 0; n < r.size(); ++n)
+            {
+                r[n].red *= f;
+                r[n].green *= f;
+                r[n].blue *= f;
+            }
+            return r;
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Deadline
+        //
+        void Deadline()
+        {
+            _server->eventDriven(true);
+            _server->maxThreads(1);
+            _server->registerMethod("block", *this, &BinRpcTest::block);
+
+            cxxtools::bin::RpcClient client1(_loop, "", _port);
+            cxxtools::bin::RpcClient client2(_loop, "", _port);
+            client2.deadline(1);
+
+            cxxtools::RemoteProcedure<int, int> block1(client1, "block");
+            cxxtools::RemoteProcedure<int, int> block2(client2, "block");
+
+            cxxtools::atomicSet(_count, 0);
+            closeGate();
+
+            // occupy the only thread of the server until the gate is opened
+            block1.begin(1);
+            while (cxxtools::atomicGet(_count) == 0)
+                _loop.wait(10);
+
+            // the second request waits in the queue of the server until its
+            // deadline of 1 ms is over
+            block2.begin(2);
+            cxxtools::Clock clock;
+            clock.start();
+            while (clock.stop().totalMSecs() < 100)
+                _loop.wait(10);
+
+            openGate();
+
+            try
+            {
+                block2.end(2000);
+                CXXTOOLS_UNIT_ASSERT_MSG(false, "cxxtools::RemoteException exception expected");
+            }
+            catch (const cxxtools::RemoteException& e)
+            {
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.text(), "deadline exceeded");
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(block1.end(2000), 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::atomicGet(_count), 1);
+
+            client2.deadline(0);
+            block2.begin(3);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(block2.end(2000), 3);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::atomicGet(_count), 2);
+        }
+
+        int block(int n)
+        {
+            cxxtools::atomicIncrement(_count);
+            waitGate();
+            return n;
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Hedged
+        //
+        void Hedged()
+        {
+            _server->listen("", _port + 1);
+            _server->registerMethod("replica", *this, &BinRpcTest::replica);
+
+            cxxtools::bin::RpcClient client1(_loop, "", _port);
+            cxxtools::bin::RpcClient client2(_loop, "", _port + 1);
+            cxxtools::HedgedClient client(_loop, client1, client2);
+            client.minHedgeDelay(1);
+
+            cxxtools::RemoteProcedure<int> replica(client, "replica");
+
+            cxxtools::atomicSet(_count, 0);
+            closeGate();
+
+            // the first request blocks, so that the hedged request wins
+            replica.begin();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(replica.end(2000), 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(client.hedgedCalls(), 1);
+
+            openGate();
+
+            // no hedged request is sent, before the primary replies
+            client.minHedgeDelay(60000);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(replica(), 3);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(client.hedgedCalls(), 1);
+        }
+
+        int replica()
+        {
+            int count = static_cast<int>(cxxtools::atomicIncrement(_count));
+            if (count == 1)
+                waitGate();
+            return count;
+        }
+
+        ////////////////////////////////////////////////////////////
+        // HedgedFailover
+        //
+        void HedgedFailover()
+        {
+            _server->registerMethod("multiply", *this, &BinRpcTest::multiplyInt);
+
+            // nobody listens on the port of the primary
+            cxxtools::bin::RpcClient client1(_loop, "", _port + 1);
+            cxxtools::bin::RpcClient client2(_loop, "", _port);
+            cxxtools::HedgedClient client(_loop, client1, client2);
+
+            // the hedge delay is never reached, so the secondary is only
+            // called since the primary failed
+            client.minHedgeDelay(60000);
+
+            cxxtools::RemoteProcedure<int, int, int> multiply(client, "multiply");
+
+            multiply.begin(2, 3);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(multiply.end(2000), 6);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(client.hedgedCalls(), 1);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // Balancing
+        //
+        void Balancing()
+        {
+            _server->listen("", _port + 1);
+            _server->registerMethod("multiply", *this, &BinRpcTest::multiplyInt);
+
+            cxxtools::BasicLoadBalancer<cxxtools::bin::RpcClient> balancer(_loop);
+            balancer.addEndpoint("", _port);
+            balancer.addEndpoint("", _port + 1);
+            // nobody listens on that port
+            balancer.addEndpoint("", _port + 2);
+            balancer.failureThreshold(1);
+
+            cxxtools::BalancingClient client(balancer);
+            cxxtools::RemoteProcedure<int, int, int> multiply(client, "multiply");
+
+            unsigned failures = 0;
+            for (int n = 0; n < 20; ++n)
+            {
+                try
+                {
+                    multiply.begin(n, 3);
+                    CXXTOOLS_UNIT_ASSERT_EQUALS(multiply.end(2000), n * 3);
+                }
+                catch (const cxxtools::IOError&)
+                {
+                    ++failures;
+                }
+            }
+
+            CXXTOOLS_UNIT_ASSERT(failures <= 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(balancer.endpointInfo(2).failures, failures);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(balancer.endpointInfo(2).ejected, (failures > 0));
+            CXXTOOLS_UNIT_ASSERT(balancer.endpointInfo(0).requests > 0);
+            CXXTOOLS_UNIT_ASSERT(balancer.endpointInfo(1).requests > 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(balancer.endpointInfo(0).outstanding, 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(balancer.endpointInfo(1).outstanding, 0);
+
+            // the calls are sequential, so one connection per endpoint is
+            // enough and the failed connection is not kept
+            CXXTOOLS_UNIT_ASSERT(balancer.endpointInfo(0).connections <= 1);
+            CXXTOOLS_UNIT_ASSERT(balancer.endpointInfo(1).connections <= 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(balancer.endpointInfo(2).connections, 0);
+        }
+
+        void BalancingMaxIdle()
+        {
+            _server->registerMethod("multiply", *this, &BinRpcTest::multiplyInt);
+
+            cxxtools::BasicLoadBalancer<cxxtools::bin::RpcClient> balancer(_loop);
+            balancer.addEndpoint("", _port);
+            balancer.maxIdle(0);
+
+            cxxtools::BalancingClient client(balancer);
+            cxxtools::RemoteProcedure<int, int, int> multiply(client, "multiply");
+
+            for (int n = 0; n < 3; ++n)
+            {
+                multiply.begin(n, 3);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(multiply.end(2000), n * 3);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(balancer.endpointInfo(0).connections, 0);
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(balancer.endpointInfo(0).requests, 3);
+        }
+
 };
 
 cxxtools::unit::RegisterTest<BinRpcTest> register_BinRpcTest;
@@ -70,6 +70,19 @@ namespace
         si.setTypeName("TestObject");
     }
 
+    void formatValue(cxxtools::Formatter& formatter, const TestObject& obj, const std::string& name)
+    {
+        formatter.beginObject(name, "TestObject");
+        cxxtools::formatMember(formatter, "intValue", obj.intValue);
+        cxxtools::formatMember(formatter, "stringValue", obj.stringValue);
+        cxxtools::formatMember(formatter, "doubleValue", obj.doubleValue);
+        cxxtools::formatMember(formatter, "boolValue", obj.boolValue);
+        formatter.beginMember("nullValue");
+        formatter.addNull("nullValue", std::string());
+        formatter.finishMember();
+        formatter.finishObject();
+    }
+
     bool operator== (const TestObject& obj1, const TestObject& obj2)
     {
         return obj1.intValue == obj2.intValue
@@ -124,6 +137,10 @@ class BinSerializerTest : public cxxtools::unit::TestSuite
             registerMethod("testComplexObject", *this, &BinSerializerTest::testComplexObject);
             registerMethod("testObjectVector", *this, &BinSerializerTest::testObjectVector);
             registerMethod("testBinaryData", *this, &BinSerializerTest::testBinaryData);
+            registerMethod("testSerializeDirect", *this, &BinSerializerTest::testSerializeDirect);
+            registerMethod("testDeserializeElements", *this, &BinSerializerTest::testDeserializeElements);
+            registerMethod("testPackedArrays", *this, &BinSerializerTest::testPackedArrays);
+            registerMethod("testDictionary", *this, &BinSerializerTest::testDictionary);
         }
 
         void testScalar()
@@ -400,6 +417,162 @@ class BinSerializerTest : public cxxtools::unit::TestSuite
             CXXTOOLS_UNIT_ASSERT(v == v2);
 
         }
+        void testSerializeDirect()
+        {
+            std::vector<TestObject2> obj;
+            obj.resize(2);
+            obj[0].intValue = 17;
+            obj[0].stringValue = "foobar";
+            obj[0].doubleValue = 3.125;
+            obj[0].boolValue = true;
+            obj[0].setValue.insert(4);
+            obj[0].mapValue[5] = "five";
+            obj[1].intValue = 18;
+            obj[1].stringValue = "hi there";
+            obj[1].doubleValue = -17.25;
+            obj[1].boolValue = false;
+
+            std::map<std::string, std::vector<TestObject> > m;
+            m["a"].resize(3);
+            m["a"][1].intValue = -5;
+            m["a"][2].stringValue = "x";
+
+            std::ostringstream tree;
+            cxxtools::bin::Serializer treeSerializer(tree);
+            treeSerializer.serialize(obj, "obj");
+            treeSerializer.serialize(m, "m");
+
+            std::ostringstream direct;
+            cxxtools::bin::Serializer directSerializer(direct);
+            directSerializer.serializeDirect(obj, "obj");
+            directSerializer.serializeDirect(m, "m");
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(tree.str(), direct.str());
+        }
+
+        void testDeserializeElements()
+        {
+            std::vector<TestObject> obj;
+            obj.resize(3);
+            obj[0].intValue = 17;
+            obj[0].stringValue = "foobar";
+            obj[0].doubleValue = 3.125;
+            obj[0].boolValue = true;
+            obj[0].nullValue = true;
+            obj[1].intValue = 18;
+            obj[1].stringValue = "hi there";
+            obj[1].doubleValue = -17.25;
+            obj[1].boolValue = false;
+            obj[1].nullValue = true;
+            obj[2] = obj[0];
+
+            std::stringstream data;
+            cxxtools::bin::Serializer serializer(data);
+            serializer.serializeDirect(obj);
+
+            cxxtools::bin::Deserializer deserializer(data);
+            std::vector<TestObject> obj2;
+            deserializer.deserializeElements(obj2);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(obj2.size(), 3);
+            CXXTOOLS_UNIT_ASSERT(obj == obj2);
+            CXXTOOLS_UNIT_ASSERT(deserializer.si()->memberCount() <= 1);
+        }
+
+        void testPackedArrays()
+        {
+            std::vector<int32_t> i32;
+            std::vector<int64_t> i64;
+            std::vector<float> f;
+            std::vector<double> d;
+            for (int n = 0; n < 1000; ++n)
+            {
+                i32.push_back(n * 7919 - 100000);
+                i64.push_back(static_cast<int64_t>(n) * 1000000007 * (n % 2 ? -1 : 1));
+                f.push_back(n / 8.0f);
+                d.push_back(n / 3.0);
+            }
+
+            std::stringstream data;
+            cxxtools::bin::Serializer serializer(data);
+            serializer.serializeDirect(i32);
+            serializer.serializeDirect(i64);
+            serializer.serializeDirect(f);
+            serializer.serializeDirect(d);
+            serializer.serializeDirect(std::vector<double>());
+
+            // type code, count and the values
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data.str().size(), 5 * 5 + 1000 * (4 + 8 + 4 + 8));
+
+            std::vector<int32_t> i32r;
+            std::vector<int64_t> i64r;
+            std::vector<float> fr;
+            std::vector<double> dr;
+            std::vector<double> er(1);
+
+            cxxtools::bin::Deserializer(data).deserialize(i32r);
+            cxxtools::bin::Deserializer(data).deserialize(i64r);
+            cxxtools::bin::Deserializer(data).deserialize(fr);
+            cxxtools::bin::Deserializer(data).deserialize(dr);
+            cxxtools::bin::Deserializer(data).deserialize(er);
+
+            CXXTOOLS_UNIT_ASSERT(i32 == i32r);
+            CXXTOOLS_UNIT_ASSERT(i64 == i64r);
+            CXXTOOLS_UNIT_ASSERT(f == fr);
+            CXXTOOLS_UNIT_ASSERT(d == dr);
+            CXXTOOLS_UNIT_ASSERT(er.empty());
+
+            // packed arrays as members of an object
+            std::map<std::string, std::vector<double> > m;
+            m["a"] = d;
+            m["b"].push_back(-1.5);
+
+            std::stringstream data2;
+            cxxtools::bin::Serializer(data2).serializeDirect(m, "m");
+
+            std::map<std::string, std::vector<double> > m2;
+            cxxtools::bin::Deserializer(data2).deserialize(m2);
+            CXXTOOLS_UNIT_ASSERT(m == m2);
+        }
+
+        void testDictionary()
+        {
+            std::vector<TestObject2> v;
+            TestObject2 obj;
+            for (int n = 0; n < 100; ++n)
+            {
+                obj.intValue = n;
+                obj.stringValue = "foo";
+                obj.doubleValue = n / 4.0;
+                obj.boolValue = n & 1;
+                obj.nullValue = true;
+                obj.setValue.insert(n);
+                obj.mapValue[n] = "bar";
+                v.push_back(obj);
+            }
+
+            std::stringstream plain;
+            cxxtools::bin::Serializer(plain).serialize(v, "v");
+
+            std::stringstream data;
+            cxxtools::bin::Serializer serializer(data);
+            serializer.useDictionary(true);
+            serializer.serialize(v, "v");
+            serializer.serialize(v, "v");
+
+            CXXTOOLS_UNIT_ASSERT(data.str().size() < plain.str().size() * 2);
+
+            // the dictionary is valid within one top level value only
+            std::vector<TestObject2> v2;
+            std::vector<TestObject2> v3;
+            cxxtools::bin::Deserializer deserializer(data);
+            deserializer.deserialize(v2);
+            deserializer.deserialize(v3);
+
+            CXXTOOLS_UNIT_ASSERT(v == v2);
+            CXXTOOLS_UNIT_ASSERT(v == v3);
+        }
+
 };
 
 cxxtools::unit::RegisterTest<BinSerializerTest> register_BinSerializerTest;
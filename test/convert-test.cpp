@@ -33,6 +33,7 @@
 #include "cxxtools/log.h"
 #include <limits>
 #include <string.h>
+#include <stdlib.h>
 
 log_define("cxxtools.test.convert")
 
@@ -57,6 +58,9 @@ class ConvertTest : public cxxtools::unit::TestSuite
             registerMethod("infTest", *this, &ConvertTest::infTest);
             registerMethod("emptyTest", *this, &ConvertTest::emptyTest);
             registerMethod("floatTest", *this, &ConvertTest::floatTest);
+            registerMethod("shortestFloatTest", *this, &ConvertTest::shortestFloatTest);
+            registerMethod("exactFloatTest", *this, &ConvertTest::exactFloatTest);
+            registerMethod("intRangeTest", *this, &ConvertTest::intRangeTest);
         }
 
         void successTest()
@@ -281,6 +285,68 @@ class ConvertTest : public cxxtools::unit::TestSuite
           t(12);
         }
 
+        void shortestFloatTest()
+        {
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<std::string>(0.1), "0.1");
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<std::string>(0.1 + 0.2), "0.30000000000000004");
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<std::string>(-2.5), "-2.5");
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<std::string>(1e6), "1000000");
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<std::string>(0.1f), "0.1");
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<std::string>(static_cast<long double>(0.1)), "0.1");
+
+          double values[] = { 3.141592653579893, 1.0 / 3.0, 2.2250738585072014e-308, 1.7976931348623157e308, 5e-324, 123456789.55555555 };
+          for (unsigned n = 0; n < sizeof(values) / sizeof(values[0]); ++n)
+          {
+            std::string s = cxxtools::convert<std::string>(values[n]);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(strtod(s.c_str(), 0), values[n]);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<double>(s), values[n]);
+          }
+        }
+
+        void exactFloatTest()
+        {
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<double>("0.30000000000000004"), 0.1 + 0.2);
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<double>(std::string("2.2250738585072014e-308")), std::numeric_limits<double>::min());
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<double>(cxxtools::String(L"1.7976931348623157e308")), std::numeric_limits<double>::max());
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<double>("4.9406564584124654e-324"), std::numeric_limits<double>::denorm_min());
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<float>("0.1"), 0.1f);
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<float>("3.4028235e38"), std::numeric_limits<float>::max());
+
+          // halfway between two doubles: round to even, unless any digit follows
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<double>("9007199254740993"), 9007199254740992.0);
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<double>("9007199254740993.000000000000000000001"), 9007199254740994.0);
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<double>("-0.000000000000000000000000000000000000000000000001234567890123456789012345"), -1.234567890123456789012345e-48);
+
+          CXXTOOLS_UNIT_ASSERT_THROW(cxxtools::convert<double>("1e"), cxxtools::ConversionError);
+          CXXTOOLS_UNIT_ASSERT_THROW(cxxtools::convert<double>("1.5x"), cxxtools::ConversionError);
+
+          // non const buffers use the same parser
+          char buffer[] = "0.30000000000000004";
+          char* end = buffer + strlen(buffer);
+          bool ok = false;
+          double d = 0;
+          CXXTOOLS_UNIT_ASSERT(cxxtools::getFloat(buffer, end, ok, d) == end);
+          CXXTOOLS_UNIT_ASSERT(ok);
+          CXXTOOLS_UNIT_ASSERT_EQUALS(d, 0.1 + 0.2);
+
+          float f = 0;
+          CXXTOOLS_UNIT_ASSERT(cxxtools::getFloat(buffer, end, ok, f) == end);
+          CXXTOOLS_UNIT_ASSERT(ok);
+          CXXTOOLS_UNIT_ASSERT_EQUALS(f, 0.3f);
+        }
+
+        void intRangeTest()
+        {
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<int>("-2147483648"), std::numeric_limits<int>::min());
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<int>(" 2147483647 "), std::numeric_limits<int>::max());
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<unsigned long>(std::string("123456789")), 123456789ul);
+          CXXTOOLS_UNIT_ASSERT_EQUALS(cxxtools::convert<short>(cxxtools::String(L"-32768")), std::numeric_limits<short>::min());
+          CXXTOOLS_UNIT_ASSERT_THROW(cxxtools::convert<int>("2147483648"), cxxtools::ConversionError);
+          CXXTOOLS_UNIT_ASSERT_THROW(cxxtools::convert<unsigned>("-1"), cxxtools::ConversionError);
+          CXXTOOLS_UNIT_ASSERT_THROW(cxxtools::convert<unsigned short>(cxxtools::String(L"65536")), cxxtools::ConversionError);
+          CXXTOOLS_UNIT_ASSERT_THROW(cxxtools::convert<long>("123456789012345678901234567890"), cxxtools::ConversionError);
+        }
+
 };
 
 cxxtools::unit::RegisterTest<ConvertTest> register_ConvertTest;
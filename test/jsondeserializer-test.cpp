@@ -29,7 +29,14 @@
 #include "cxxtools/unit/testsuite.h"
 #include "cxxtools/unit/registertest.h"
 #include "cxxtools/jsondeserializer.h"
+#include "cxxtools/jsonserializer.h"
+#include "cxxtools/jsonformatter.h"
+#include "cxxtools/jsonutf8parser.h"
+#include "cxxtools/serializationerror.h"
+#include "cxxtools/convert.h"
 #include "cxxtools/log.h"
+#include <limits>
+#include <cstring>
 
 //log_define("cxxtools.test.jsondeserializer")
 //
@@ -97,6 +104,8 @@ class JsonDeserializerTest : public cxxtools::unit::TestSuite
             : cxxtools::unit::TestSuite("jsondeserializer")
         {
             registerMethod("testInt", *this, &JsonDeserializerTest::testInt);
+            registerMethod("testNumbers", *this, &JsonDeserializerTest::testNumbers);
+            registerMethod("testFloatPrecision", *this, &JsonDeserializerTest::testFloatPrecision);
             registerMethod("testObject", *this, &JsonDeserializerTest::testObject);
             registerMethod("testEmptyObject", *this, &JsonDeserializerTest::testEmptyObject);
             registerMethod("testArray", *this, &JsonDeserializerTest::testArray);
@@ -105,6 +114,12 @@ class JsonDeserializerTest : public cxxtools::unit::TestSuite
             registerMethod("testComplexObject", *this, &JsonDeserializerTest::testComplexObject);
             registerMethod("testCommentLine", *this, &JsonDeserializerTest::testCommentLine);
             registerMethod("testCommentMultiline", *this, &JsonDeserializerTest::testCommentMultiline);
+            registerMethod("testDeserializeElements", *this, &JsonDeserializerTest::testDeserializeElements);
+            registerMethod("testUtf8Buffer", *this, &JsonDeserializerTest::testUtf8Buffer);
+            registerMethod("testUtf8BufferStrings", *this, &JsonDeserializerTest::testUtf8BufferStrings);
+            registerMethod("testUtf8BufferErrors", *this, &JsonDeserializerTest::testUtf8BufferErrors);
+            registerMethod("testUtf8ParserReuse", *this, &JsonDeserializerTest::testUtf8ParserReuse);
+            registerMethod("testUtf8ParserFormatter", *this, &JsonDeserializerTest::testUtf8ParserFormatter);
         }
 
         void testInt()
@@ -118,6 +133,69 @@ class JsonDeserializerTest : public cxxtools::unit::TestSuite
             CXXTOOLS_UNIT_ASSERT_EQUALS(data, -4711);
         }
 
+        void testNumbers()
+        {
+            std::vector<cxxtools::SerializationInfo> data;
+            std::istringstream in("[ 18446744073709551615, -9223372036854775808, 0.30000000000000004, 1e-310, 123456789012345678901234 ]");
+
+            cxxtools::JsonDeserializer deserializer(in);
+            deserializer.deserialize(data);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data.size(), 5);
+
+            unsigned long long u = 0;
+            data[0] >>= u;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(u, 18446744073709551615ull);
+
+            long long i = 0;
+            data[1] >>= i;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(i, std::numeric_limits<long long>::min());
+
+            double d = 0;
+            data[2] >>= d;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(d, 0.1 + 0.2);
+
+            data[3] >>= d;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(d, 1e-310);
+
+            std::string s;
+            data[4] >>= s;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(s, "123456789012345678901234");
+        }
+
+        void checkFloatPrecision(const std::vector<cxxtools::SerializationInfo>& data)
+        {
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data.size(), 2);
+
+            // rounding to double first would give exactly the half way
+            // value between two floats and then round to even
+            float f = 0;
+            data[0] >>= f;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(f, 1.0f + std::numeric_limits<float>::epsilon());
+
+            long double ld = 0;
+            data[1].getValue(ld);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(ld, cxxtools::convert<long double>(std::string("0.1")));
+            if (std::numeric_limits<long double>::digits > std::numeric_limits<double>::digits)
+                CXXTOOLS_UNIT_ASSERT(ld != static_cast<long double>(0.1));
+        }
+
+        void testFloatPrecision()
+        {
+            std::string json = "[ 1.0000000596046447753906250001, 0.1 ]";
+
+            std::vector<cxxtools::SerializationInfo> data;
+            std::istringstream in(json);
+            cxxtools::JsonDeserializer deserializer(in);
+            deserializer.deserialize(data);
+            checkFloatPrecision(data);
+
+            data.clear();
+            cxxtools::JsonDeserializer deserializer2(json.data(), json.size());
+            deserializer2.deserialize(data);
+            checkFloatPrecision(data);
+        }
+
         void testObject()
         {
             TestObject data;
@@ -279,6 +357,164 @@ class JsonDeserializerTest : public cxxtools::unit::TestSuite
             CXXTOOLS_UNIT_ASSERT_EQUALS(data.boolValue, true);
             CXXTOOLS_UNIT_ASSERT_EQUALS(data.nullValue, true);
         }
+        void testDeserializeElements()
+        {
+            std::istringstream in("["
+                "{\"intValue\": 17, \"stringValue\": \"foo\", \"doubleValue\": 1.5, \"boolValue\": true, \"nullValue\": null,"
+                " \"setValue\": [5, 7], \"structValue\": {\"n\": 3, \"s\": \"sss\"}},"
+                "{\"intValue\": 18, \"stringValue\": \"bar\", \"doubleValue\": 2.5, \"boolValue\": false, \"nullValue\": 1,"
+                " \"setValue\": [], \"structValue\": {\"n\": 4, \"s\": \"t\"}}"
+            "]");
+
+            std::vector<TestObject2> data;
+            cxxtools::JsonDeserializer deserializer(in);
+            deserializer.deserializeElements(data);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data.size(), 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[0].intValue, 17);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[0].stringValue, "foo");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[0].nullValue, true);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[0].setValue.size(), 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[0].structValue.n, 3);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[1].intValue, 18);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[1].stringValue, "bar");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[1].doubleValue, 2.5);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[1].nullValue, false);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[1].setValue.size(), 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[1].structValue.s, "t");
+        }
+
+
+        void testUtf8Buffer()
+        {
+            TestObject2 data;
+
+            std::string json(" {"
+                "\"intValue\": 17, "
+                "\"stringValue\":  \"foo bar\t\","
+                "\"doubleValue\": 1e3, "
+                "\"boolValue\"  :    TRUE, // comment\n"
+                "\"nullValue\"  :  null,"
+                "\"setValue\":[5,7,8],"
+                "/* another comment */"
+                "\"structValue\" : { \"n\":3,\"s\":\"sss\"}"
+            "} ");
+
+            cxxtools::JsonDeserializer deserializer(json.data(), json.size());
+            deserializer.deserialize(data);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data.intValue, 17);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data.stringValue, "foo bar\t");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data.doubleValue, 1000.0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data.boolValue, true);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data.nullValue, true);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data.setValue.size(), 3);
+            CXXTOOLS_UNIT_ASSERT(data.setValue.find(5) != data.setValue.end());
+            CXXTOOLS_UNIT_ASSERT(data.setValue.find(7) != data.setValue.end());
+            CXXTOOLS_UNIT_ASSERT(data.setValue.find(8) != data.setValue.end());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data.structValue.n, 3);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data.structValue.s, "sss");
+        }
+
+        void testUtf8BufferStrings()
+        {
+            // long enough to be scanned in blocks; utf-8 and escapes at
+            // various positions
+            std::string json("[ \"3\", \"\\t\\b\", \"\", \"\\u1e044\","
+                " \"a long string without any escape characters\","
+                " \"a long string \\\"with\\\" escapes \\/ \\n\","
+                " \"\xc3\xa4 utf-8 encoded characters \xe2\x82\xac\","
+                " \"surrogate pair \\ud83d\\ude00\" ]");
+
+            std::vector<cxxtools::String> data;
+            cxxtools::JsonDeserializer deserializer(json.data(), json.size());
+            deserializer.deserialize(data);
+
+            std::vector<cxxtools::String> expected;
+            std::istringstream in(json);
+            cxxtools::JsonDeserializer streamDeserializer(in);
+            streamDeserializer.deserialize(expected);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data.size(), 8);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[0], "3");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[1], "\t\b");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[2], "");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[3].size(), 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[3][0].value(), 0x1e04);
+            for (unsigned n = 0; n < 7; ++n)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(data[n], expected[n]);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[5], L"a long string \"with\" escapes / \n");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[6][0].value(), 0xe4);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[6][data[6].size() - 1].value(), 0x20ac);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(data[7][data[7].size() - 1].value(), 0x1f600);
+        }
+
+        void testUtf8BufferErrors()
+        {
+            const char* invalid[] = {
+                "[1, 2", "{\"a\" 1}", "[\"abc]", "{\"a\":1,}", "[1] x", "[unknown]", "\"\\x\""
+            };
+
+            for (unsigned n = 0; n < sizeof(invalid) / sizeof(invalid[0]); ++n)
+            {
+                cxxtools::SerializationInfo si;
+                cxxtools::JsonDeserializer deserializer(invalid[n], std::strlen(invalid[n]));
+                CXXTOOLS_UNIT_ASSERT_THROW(deserializer.deserialize(si), cxxtools::SerializationError);
+            }
+        }
+
+        void testUtf8ParserReuse()
+        {
+            // a failed parse deep in nested arrays must not count against
+            // the nesting limit of the next parse
+            std::string invalid(1000, '[');
+            invalid += 'x';
+            std::string valid = std::string(1000, '[') + std::string(1000, ']');
+
+            cxxtools::JsonUtf8Parser parser;
+            for (unsigned n = 0; n < 2; ++n)
+            {
+                cxxtools::DeserializerBase deserializer;
+                deserializer.begin();
+                CXXTOOLS_UNIT_ASSERT_THROW(parser.parse(invalid.data(), invalid.data() + invalid.size(), deserializer),
+                                           cxxtools::SerializationError);
+            }
+
+            cxxtools::DeserializerBase deserializer;
+            deserializer.begin();
+            const char* end = valid.data() + valid.size();
+            CXXTOOLS_UNIT_ASSERT(parser.parse(valid.data(), end, deserializer) == end);
+        }
+
+        void testUtf8ParserFormatter()
+        {
+            // feeding a formatter directly gives the same result as going
+            // through a SerializationInfo
+            std::string json("{\"a\":[1,-2,2.5,\"x\\ty\",true,null],\"b\":{\"c\":\"\xc3\xa4\"}}");
+
+            std::ostringstream direct;
+            {
+                cxxtools::TextOStream ts(direct, new cxxtools::Utf8Codec());
+                cxxtools::JsonFormatter formatter(ts);
+                cxxtools::JsonUtf8Parser parser;
+                const char* end = parser.parse(json.data(), json.data() + json.size(), formatter);
+                formatter.finish();
+                ts.flush();
+                CXXTOOLS_UNIT_ASSERT(end == json.data() + json.size());
+            }
+
+            cxxtools::SerializationInfo si;
+            std::istringstream in(json);
+            cxxtools::JsonDeserializer deserializer(in);
+            deserializer.deserialize(si);
+
+            std::ostringstream viaSi;
+            cxxtools::JsonSerializer serializer(viaSi);
+            serializer.serialize(si).finish();
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(direct.str(), viaSi.str());
+        }
 };
 
 cxxtools::unit::RegisterTest<JsonDeserializerTest> register_JsonDeserializerTest;
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include "cxxtools/jsonlinesreader.h"
+#include "cxxtools/jsonlineswriter.h"
+#include "cxxtools/serializationerror.h"
+#include <sstream>
+
+namespace
+{
+    struct Event
+    {
+        unsigned id;
+        std::string text;
+    };
+
+    inline void operator<<= (cxxtools::SerializationInfo& si, const Event& e)
+    {
+        si.addMember("id") <<= e.id;
+        si.addMember("text") <<= e.text;
+    }
+
+    inline void operator>>= (const cxxtools::SerializationInfo& si, Event& e)
+    {
+        si.getMember("id") >>= e.id;
+        si.getMember("text") >>= e.text;
+    }
+
+    std::string eventLines(unsigned count)
+    {
+        std::ostringstream data;
+        for (unsigned n = 0; n < count; ++n)
+            data << "{\"id\":" << n << ",\"text\":\"event " << n << "\"}\n";
+        return data.str();
+    }
+}
+
+class JsonLinesTest : public cxxtools::unit::TestSuite
+{
+    public:
+        JsonLinesTest()
+            : cxxtools::unit::TestSuite("jsonlines")
+        {
+            registerMethod("testRead", *this, &JsonLinesTest::testRead);
+            registerMethod("testReadParallel", *this, &JsonLinesTest::testReadParallel);
+            registerMethod("testErrors", *this, &JsonLinesTest::testErrors);
+            registerMethod("testErrorsParallel", *this, &JsonLinesTest::testErrorsParallel);
+            registerMethod("testWrite", *this, &JsonLinesTest::testWrite);
+        }
+
+        void testRead()
+        {
+            std::istringstream in("{\"id\": 1, \"text\": \"one\"}\n\n  \r\n{\"id\": 2, \"text\": \"two\"}\r\n[1,2]\n");
+            cxxtools::JsonLinesReader reader(in);
+
+            Event e;
+            CXXTOOLS_UNIT_ASSERT(reader.get(e));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(e.id, 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(e.text, "one");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.lineNumber(), 1);
+
+            CXXTOOLS_UNIT_ASSERT(reader.get(e));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(e.id, 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(e.text, "two");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.lineNumber(), 4);
+
+            const cxxtools::SerializationInfo* si = reader.next();
+            CXXTOOLS_UNIT_ASSERT(si != 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(si->category(), cxxtools::SerializationInfo::Array);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(si->memberCount(), 2);
+
+            CXXTOOLS_UNIT_ASSERT(reader.next() == 0);
+            CXXTOOLS_UNIT_ASSERT(!reader.get(e));
+        }
+
+        void testReadParallel()
+        {
+            std::istringstream in(eventLines(5000));
+            cxxtools::JsonLinesReader reader(in, 3);
+
+            Event e;
+            unsigned count = 0;
+            while (reader.get(e))
+            {
+                std::ostringstream text;
+                text << "event " << count;
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.id, count);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.text, text.str());
+                CXXTOOLS_UNIT_ASSERT_EQUALS(reader.lineNumber(), count + 1);
+                ++count;
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(count, 5000);
+            CXXTOOLS_UNIT_ASSERT(reader.next() == 0);
+        }
+
+        void testErrors()
+        {
+            std::istringstream in("{\"id\": 1, \"text\": \"one\"}\n{\"id\": 2, \n{\"id\": 3, \"text\": \"three\"} x\n{\"id\": 4, \"text\": \"four\"}\n");
+            cxxtools::JsonLinesReader reader(in);
+
+            Event e;
+            CXXTOOLS_UNIT_ASSERT(reader.get(e));
+            CXXTOOLS_UNIT_ASSERT_THROW(reader.get(e), cxxtools::SerializationError);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.lineNumber(), 2);
+            CXXTOOLS_UNIT_ASSERT_THROW(reader.get(e), cxxtools::SerializationError);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.lineNumber(), 3);
+            CXXTOOLS_UNIT_ASSERT(reader.get(e));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(e.id, 4);
+        }
+
+        void testErrorsParallel()
+        {
+            std::string data = eventLines(1000);
+            std::string::size_type pos = data.find("{\"id\":700,");
+            data[pos] = '[';
+
+            std::istringstream in(data);
+            cxxtools::JsonLinesReader reader(in, 2);
+
+            Event e;
+            unsigned count = 0;
+            unsigned errors = 0;
+            while (true)
+            {
+                try
+                {
+                    if (!reader.get(e))
+                        break;
+                    CXXTOOLS_UNIT_ASSERT_EQUALS(e.id, count);
+                }
+                catch (const cxxtools::SerializationError&)
+                {
+                    CXXTOOLS_UNIT_ASSERT_EQUALS(reader.lineNumber(), 701);
+                    ++errors;
+                }
+
+                ++count;
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(count, 1000);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(errors, 1);
+        }
+
+        void testWrite()
+        {
+            std::ostringstream out;
+
+            {
+                cxxtools::JsonLinesWriter writer(out);
+                for (unsigned n = 0; n < 3; ++n)
+                {
+                    Event e;
+                    e.id = n;
+                    e.text = "event \"x\"";
+                    writer.write(e);
+                }
+
+                std::vector<int> v;
+                v.push_back(1);
+                v.push_back(2);
+                writer.write(v);
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(out.str(),
+                "{\"id\":0,\"text\":\"event \\\"x\\\"\"}\n"
+                "{\"id\":1,\"text\":\"event \\\"x\\\"\"}\n"
+                "{\"id\":2,\"text\":\"event \\\"x\\\"\"}\n"
+                "[1,2]\n");
+
+            std::istringstream in(out.str());
+            cxxtools::JsonLinesReader reader(in);
+            Event e;
+            CXXTOOLS_UNIT_ASSERT(reader.get(e));
+            CXXTOOLS_UNIT_ASSERT(reader.get(e));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(e.id, 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(e.text, "event \"x\"");
+        }
+};
+
+cxxtools::unit::RegisterTest<JsonLinesTest> register_JsonLinesTest;
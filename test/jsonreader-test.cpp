@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include "cxxtools/jsonreader.h"
+#include "cxxtools/serializationerror.h"
+#include <sstream>
+
+namespace
+{
+    struct Record
+    {
+        int id;
+        std::string name;
+    };
+
+    inline void operator>>= (const cxxtools::SerializationInfo& si, Record& r)
+    {
+        si.getMember("id") >>= r.id;
+        si.getMember("name") >>= r.name;
+    }
+}
+
+class JsonReaderTest : public cxxtools::unit::TestSuite
+{
+    public:
+        JsonReaderTest()
+            : cxxtools::unit::TestSuite("jsonreader")
+        {
+            registerMethod("testEvents", *this, &JsonReaderTest::testEvents);
+            registerMethod("testStrings", *this, &JsonReaderTest::testStrings);
+            registerMethod("testSkip", *this, &JsonReaderTest::testSkip);
+            registerMethod("testGet", *this, &JsonReaderTest::testGet);
+            registerMethod("testSmallBuffer", *this, &JsonReaderTest::testSmallBuffer);
+            registerMethod("testMultipleValues", *this, &JsonReaderTest::testMultipleValues);
+            registerMethod("testErrors", *this, &JsonReaderTest::testErrors);
+        }
+
+        void testEvents()
+        {
+            std::istringstream in("{\"a\": [1, -2.5, true, null], // comment\n \"b\": {}, \"c\": [] /* x */ }");
+            cxxtools::JsonReader reader(in);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::BeginObject);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.depth(), 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::Key);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.str(), "a");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::BeginArray);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.depth(), 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::NumberValue);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.toInt(), 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::NumberValue);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.toDouble(), -2.5);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::BoolValue);
+            CXXTOOLS_UNIT_ASSERT(reader.toBool());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::NullValue);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::EndArray);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::Key);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.str(), "b");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::BeginObject);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::EndObject);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::Key);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::BeginArray);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::EndArray);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::EndObject);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.depth(), 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::End);
+        }
+
+        void testStrings()
+        {
+            std::istringstream in("[\"plain\", \"a\\\"b\\\\c\\n\", \"\\u00e4\\uD834\\uDD1E\", \"\xc3\xb6\"]");
+            cxxtools::JsonReader reader(in);
+
+            reader.next();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::StringValue);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.str(), "plain");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::StringValue);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.str(), "a\"b\\c\n");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::StringValue);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.str(), "\xc3\xa4\xf0\x9d\x84\x9e");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.toString().size(), 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::StringValue);
+            CXXTOOLS_UNIT_ASSERT(reader.toString() == cxxtools::String(1, cxxtools::Char(0xf6)));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::EndArray);
+        }
+
+        void testSkip()
+        {
+            std::istringstream in("{\"big\": {\"x\": [1, {\"y\": \"]}\\\"\"}], \"z\": \"{\"}, \"s\": 1, \"want\": 42}");
+            cxxtools::JsonReader reader(in);
+
+            reader.next();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::Key);
+            reader.skip();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::Key);
+            reader.skip();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::Key);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.str(), "want");
+            reader.next();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.toInt(), 42);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::EndObject);
+
+            std::istringstream in2("[[1, [2]], 3]");
+            cxxtools::JsonReader reader2(in2);
+            reader2.next();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader2.next(), cxxtools::JsonReader::BeginArray);
+            reader2.skip();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader2.event(), cxxtools::JsonReader::EndArray);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader2.depth(), 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader2.next(), cxxtools::JsonReader::NumberValue);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader2.toInt(), 3);
+        }
+
+        void testGet()
+        {
+            std::istringstream in("{\"total\": 2, \"records\": [{\"id\": 1, \"name\": \"one\"}, {\"id\": 2, \"name\": \"two\"}]}");
+            cxxtools::JsonReader reader(in);
+
+            reader.next();
+            reader.next();
+            cxxtools::SerializationInfo si;
+            reader.get(si);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(si.name(), "total");
+            unsigned total = 0;
+            si >>= total;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(total, 2);
+
+            reader.next();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::BeginArray);
+
+            std::vector<Record> records;
+            while (reader.next() != cxxtools::JsonReader::EndArray)
+            {
+                records.resize(records.size() + 1);
+                reader.get(records.back());
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(records.size(), 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(records[0].id, 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(records[0].name, "one");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(records[1].id, 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(records[1].name, "two");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::EndObject);
+        }
+
+        void testSmallBuffer()
+        {
+            std::ostringstream data;
+            data << '[';
+            for (unsigned n = 0; n < 1000; ++n)
+            {
+                if (n > 0)
+                    data << ", ";
+                data << "{\"id\": " << n << ", \"name\": \"record \\\"" << n << "\\\" with a longer text\"}";
+            }
+            data << ']';
+
+            std::istringstream in(data.str());
+            cxxtools::JsonReader reader(in, 16);
+
+            reader.next();
+            unsigned count = 0;
+            while (reader.next() != cxxtools::JsonReader::EndArray)
+            {
+                Record r;
+                reader.get(r);
+                std::ostringstream name;
+                name << "record \"" << count << "\" with a longer text";
+                CXXTOOLS_UNIT_ASSERT_EQUALS(r.id, count);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(r.name, name.str());
+                ++count;
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(count, 1000);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::End);
+        }
+
+        void testMultipleValues()
+        {
+            std::istringstream in("{\"id\": 1, \"name\": \"a\"}\n{\"id\": 2, \"name\": \"b\"}\n");
+            cxxtools::JsonReader reader(in);
+
+            Record r;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::BeginObject);
+            reader.get(r);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(r.id, 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::BeginObject);
+            reader.get(r);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(r.id, 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(r.name, "b");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(reader.next(), cxxtools::JsonReader::End);
+        }
+
+        void testErrors()
+        {
+            {
+                std::istringstream in("[1, 2");
+                cxxtools::JsonReader reader(in);
+                reader.next();
+                reader.next();
+                reader.next();
+                CXXTOOLS_UNIT_ASSERT_THROW(reader.next(), cxxtools::SerializationError);
+            }
+
+            {
+                std::istringstream in("{\"a\" 1}");
+                cxxtools::JsonReader reader(in);
+                reader.next();
+                reader.next();
+                CXXTOOLS_UNIT_ASSERT_THROW(reader.next(), cxxtools::SerializationError);
+            }
+
+            {
+                std::istringstream in("[1 2]");
+                cxxtools::JsonReader reader(in);
+                reader.next();
+                reader.next();
+                CXXTOOLS_UNIT_ASSERT_THROW(reader.next(), cxxtools::SerializationError);
+            }
+
+            {
+                std::istringstream in("[\"abc");
+                cxxtools::JsonReader reader(in);
+                reader.next();
+                CXXTOOLS_UNIT_ASSERT_THROW(reader.next(), cxxtools::SerializationError);
+            }
+
+            {
+                std::istringstream in("[nix]");
+                cxxtools::JsonReader reader(in);
+                reader.next();
+                CXXTOOLS_UNIT_ASSERT_THROW(reader.next(), cxxtools::SerializationError);
+            }
+        }
+};
+
+cxxtools::unit::RegisterTest<JsonReaderTest> register_JsonReaderTest;
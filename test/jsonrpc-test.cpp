@@ -104,6 +104,8 @@ class JsonRpcTest : public cxxtools::unit::TestSuite
             registerMethod("CallbackException", *this, &JsonRpcTest::CallbackException);
             registerMethod("ConnectError", *this, &JsonRpcTest::ConnectError);
             registerMethod("BigRequest", *this, &JsonRpcTest::BigRequest);
+            registerMethod("EventDriven", *this, &JsonRpcTest::EventDriven);
+            registerMethod("EventDrivenFault", *this, &JsonRpcTest::EventDrivenFault);
 
             char* PORT = getenv("UTEST_PORT");
             if (PORT)
@@ -655,6 +657,48 @@ class JsonRpcTest : public cxxtools::unit::TestSuite
             return v.size();
         }
 
+        ////////////////////////////////////////////////////////////
+        // EventDriven
+        //
+        void EventDriven()
+        {
+            _server->eventDriven(true);
+            _server->registerMethod("multiply", *this, &JsonRpcTest::multiplyInt);
+
+            cxxtools::json::RpcClient client(_loop, "", _port);
+            cxxtools::RemoteProcedure<int, int, int> multiply(client, "multiply");
+
+            multiply.begin(2, 3);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(multiply.end(2000), 6);
+
+            multiply.begin(4, 5);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(multiply.end(2000), 20);
+        }
+
+        ////////////////////////////////////////////////////////////
+        // EventDrivenFault
+        //
+        void EventDrivenFault()
+        {
+            _server->eventDriven(true);
+            _server->registerMethod("multiply", *this, &JsonRpcTest::throwFault);
+
+            cxxtools::json::RpcClient client(_loop, "", _port);
+            cxxtools::RemoteProcedure<bool> multiply(client, "multiply");
+            multiply.begin();
+
+            try
+            {
+                multiply.end(2000);
+                CXXTOOLS_UNIT_ASSERT_MSG(false, "cxxtools::RemoteException exception expected");
+            }
+            catch (const cxxtools::RemoteException& e)
+            {
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.rc(), 7);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(e.text(), "Fault");
+            }
+        }
+
 };
 
 cxxtools::unit::RegisterTest<JsonRpcTest> register_JsonRpcTest;
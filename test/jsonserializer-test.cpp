@@ -76,6 +76,7 @@ class JsonSerializerTest : public cxxtools::unit::TestSuite
             registerMethod("testMultipleObjects", *this, &JsonSerializerTest::testMultipleObjects);
             registerMethod("testPlainEmpty", *this, &JsonSerializerTest::testPlainEmpty);
             registerMethod("testEmptyObject", *this, &JsonSerializerTest::testEmptyObject);
+            registerMethod("testSerializeDirect", *this, &JsonSerializerTest::testSerializeDirect);
         }
 
         void testInt()
@@ -234,6 +235,35 @@ class JsonSerializerTest : public cxxtools::unit::TestSuite
             CXXTOOLS_UNIT_ASSERT_EQUALS(out.str(), "{}");
         }
 
+        void testSerializeDirect()
+        {
+            TestObject obj;
+            obj.intValue = 17;
+            obj.stringValue = "foobar";
+            obj.doubleValue = 1.5;
+
+            std::map<std::string, std::vector<int> > m;
+            m["a"].push_back(1);
+            m["a"].push_back(-2);
+            m["b"];
+
+            std::ostringstream tree;
+            cxxtools::JsonSerializer treeSerializer(tree);
+            treeSerializer.serialize(m, "m")
+                          .serialize(obj, "obj")
+                          .serialize(std::make_pair(3u, true), "p")
+                          .finish();
+
+            std::ostringstream direct;
+            cxxtools::JsonSerializer directSerializer(direct);
+            directSerializer.serializeDirect(m, "m")
+                            .serializeDirect(obj, "obj")
+                            .serializeDirect(std::make_pair(3u, true), "p")
+                            .finish();
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(tree.str(), direct.str());
+        }
+
 };
 
 cxxtools::unit::RegisterTest<JsonSerializerTest> register_JsonSerializerTest;
@@ -0,0 +1,766 @@
+/*
+ * Copyright (C) 2013 Tommi Maekitalo
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * As a special exception, you may use this file as part of a free
+ * software library without restriction. Specifically, if other files
+ * instantiate templates or use macros or inline functions from this
+ * file, or you compile this file and link it with other files to
+ * produce an executable, this file does not by itself cause the
+ * resulting executable to be covered by the GNU General Public
+ * License. This exception does not however invalidate any other
+ * reasons why the executable file might be covered by the GNU Library
+ * General Public License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "cxxtools/log.h"
+#include "cxxtools/serializationinfo.h"
+#include "cxxtools/convert.h"
+#include "cxxtools/jsondeserializer.h"
+#include "cxxtools/unit/testsuite.h"
+#include "cxxtools/unit/registertest.h"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+log_define("cxxtools.test.log")
+
+namespace
+{
+    // clock of the log limiters, so that the tests decide, when a new
+    // second starts
+    time_t now = 1000;
+
+    time_t testClock(time_t*)
+    {
+        return now;
+    }
+}
+
+namespace
+{
+    // logs a message, while it is written into another log message
+    struct Nested
+    {
+        unsigned n;
+        explicit Nested(unsigned n_) : n(n_) { }
+    };
+
+    std::ostream& operator<< (std::ostream& out, const Nested& nested)
+    {
+        log_info("nested " << nested.n << cxxtools::LogField("inner", nested.n));
+        return out << "outer " << nested.n;
+    }
+}
+
+class LogTest : public cxxtools::unit::TestSuite
+{
+        std::string _fname;
+
+        // configures logging to the test file; the file is truncated
+        void configure(cxxtools::SerializationInfo& si)
+        {
+            ::unlink(_fname.c_str());
+            si.addMember("file") <<= _fname;
+            si.addMember("rootlogger") <<= "INFO";
+            cxxtools::LoggerManager::logInit(si);
+        }
+
+        void configureAsync(unsigned queueSize, const char* overflow)
+        {
+            cxxtools::SerializationInfo si;
+            si.addMember("async") <<= true;
+            si.addMember("asyncqueuesize") <<= queueSize;
+            si.addMember("asyncoverflow") <<= overflow;
+            configure(si);
+        }
+
+        // other tests expect logging to be quiet
+        void quiet()
+        {
+            cxxtools::SerializationInfo si;
+            si.addMember("rootlogger") <<= "FATAL";
+            cxxtools::LoggerManager::logInit(si);
+        }
+
+        std::string ringFname() const
+        {
+            return _fname + ".ring";
+        }
+
+        void configureRingBuffer()
+        {
+            cxxtools::SerializationInfo si;
+            si.addMember("ringbuffer") <<= ringFname();
+            si.addMember("ringbuffersize") <<= "4k";
+            si.addMember("rootlogger") <<= "INFO";
+            cxxtools::LoggerManager::logInit(si);
+        }
+
+        // returns the texts of the entries in the ring buffer; the entries
+        // must be the last consecutive messages up to the message last
+        std::vector<std::string> dumpRingBuffer(unsigned last)
+        {
+            std::ostringstream out;
+            unsigned count = cxxtools::dumpLogRingBuffer(ringFname(), out);
+
+            std::vector<std::string> result;
+            std::istringstream in(out.str());
+            std::string line;
+            while (std::getline(in, line))
+            {
+                std::string::size_type p = line.find(" - ");
+                CXXTOOLS_UNIT_ASSERT(p != std::string::npos);
+                result.push_back(line.substr(p + 3));
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(result.size(), count);
+            CXXTOOLS_UNIT_ASSERT(count > 0 && count <= last + 1);
+            for (unsigned n = 0; n < count; ++n)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(result[n], "message " + cxxtools::convert<std::string>(last + 1 - count + n));
+
+            return result;
+        }
+
+        static bool endsWith(const std::string& s, const std::string& suffix)
+        {
+            return s.size() >= suffix.size()
+                && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+        }
+
+        // returns the lines of the test file
+        std::vector<std::string> lines()
+        {
+            std::vector<std::string> result;
+            std::ifstream in(_fname.c_str());
+            std::string line;
+            while (std::getline(in, line))
+                result.push_back(line);
+            return result;
+        }
+
+        // returns the texts of the log entries in the test file
+        std::vector<std::string> texts()
+        {
+            std::vector<std::string> l = lines();
+            std::vector<std::string> result;
+            for (unsigned n = 0; n < l.size(); ++n)
+            {
+                std::string::size_type p = l[n].find(" - ");
+                if (p != std::string::npos)
+                    result.push_back(l[n].substr(p + 3));
+            }
+            return result;
+        }
+
+    public:
+        LogTest()
+        : cxxtools::unit::TestSuite("log"),
+          _fname("/tmp/cxxtools-log-test-" + cxxtools::convert<std::string>(::getpid()) + ".log")
+        {
+            registerMethod("asyncOrder", *this, &LogTest::asyncOrder);
+            registerMethod("asyncBlock", *this, &LogTest::asyncBlock);
+            registerMethod("asyncDrop", *this, &LogTest::asyncDrop);
+            registerMethod("asyncFatalFlush", *this, &LogTest::asyncFatalFlush);
+            registerMethod("jsonEntry", *this, &LogTest::jsonEntry);
+            registerMethod("jsonFields", *this, &LogTest::jsonFields);
+            registerMethod("textFields", *this, &LogTest::textFields);
+            registerMethod("rateLimit", *this, &LogTest::rateLimit);
+            registerMethod("sample", *this, &LogTest::sample);
+            registerMethod("callSiteLimit", *this, &LogTest::callSiteLimit);
+            registerMethod("inheritedLimit", *this, &LogTest::inheritedLimit);
+            registerMethod("setLogLevel", *this, &LogTest::setLogLevel);
+            registerMethod("reconfigure", *this, &LogTest::reconfigure);
+            registerMethod("ringBuffer", *this, &LogTest::ringBuffer);
+            registerMethod("ringBufferLargePosition", *this, &LogTest::ringBufferLargePosition);
+            registerMethod("streamNumbers", *this, &LogTest::streamNumbers);
+            registerMethod("streamFormat", *this, &LogTest::streamFormat);
+            registerMethod("nestedMessage", *this, &LogTest::nestedMessage);
+            registerMethod("fieldsReused", *this, &LogTest::fieldsReused);
+        }
+
+        void tearDown()
+        {
+            cxxtools::LogLimiter::setClock(0);
+            quiet();
+            ::unlink(_fname.c_str());
+            ::unlink(ringFname().c_str());
+        }
+
+        void asyncOrder()
+        {
+            configureAsync(1000, "block");
+
+            for (unsigned n = 0; n < 100; ++n)
+                log_info("message " << n);
+            log_debug("not logged");
+
+            // reconfiguring destroys the asynchronous appender, which
+            // writes the pending messages
+            quiet();
+
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t.size(), 100);
+            for (unsigned n = 0; n < t.size(); ++n)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(t[n], "message " + cxxtools::convert<std::string>(n));
+        }
+
+        void asyncBlock()
+        {
+            // with a queue of one message each message waits for the writer
+            configureAsync(1, "block");
+
+            for (unsigned n = 0; n < 1000; ++n)
+                log_warn("message " << n);
+
+            quiet();
+
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t.size(), 1000);
+            for (unsigned n = 0; n < t.size(); ++n)
+                CXXTOOLS_UNIT_ASSERT_EQUALS(t[n], "message " + cxxtools::convert<std::string>(n));
+        }
+
+        void asyncDrop()
+        {
+            configureAsync(1, "drop");
+
+            const unsigned count = 10000;
+            for (unsigned n = 0; n < count; ++n)
+                log_info("message " << n);
+
+            // fatal messages are never dropped and the dropped messages
+            // are reported before the fatal message is passed back
+            log_fatal("done");
+
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT(!t.empty());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t.back(), "done");
+
+            // each message is either written or counted as dropped and the
+            // written messages keep their order
+            unsigned written = 0;
+            unsigned dropped = 0;
+            unsigned last = 0;
+            for (unsigned n = 0; n + 1 < t.size(); ++n)
+            {
+                if (t[n].compare(0, 8, "message ") == 0)
+                {
+                    unsigned num = cxxtools::convert<unsigned>(t[n].substr(8));
+                    CXXTOOLS_UNIT_ASSERT(written == 0 || num > last);
+                    last = num;
+                    ++written;
+                }
+                else
+                {
+                    std::string::size_type p = t[n].find(" log messages dropped");
+                    CXXTOOLS_UNIT_ASSERT(p != std::string::npos);
+                    dropped += cxxtools::convert<unsigned>(t[n].substr(0, p));
+                }
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(written + dropped, count);
+        }
+
+        void asyncFatalFlush()
+        {
+            // the writer thread runs in the background; the fatal message
+            // and the messages before must be written, when log_fatal returns
+            configureAsync(1000, "drop");
+
+            log_info("message");
+            log_fatal("fatal");
+
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t.size(), 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[0], "message");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[1], "fatal");
+        }
+
+        void jsonEntry()
+        {
+            cxxtools::SerializationInfo si;
+            si.addMember("format") <<= "json";
+            configure(si);
+
+            log_info("say \"hello\"\n\tto \\ \x01 and \xc3\xa4");
+            quiet();
+
+            std::vector<std::string> l = lines();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(l.size(), 1);
+            CXXTOOLS_UNIT_ASSERT(l[0].find("\"message\":\"say \\\"hello\\\"\\n\\tto \\\\ \\u0001 and \xc3\xa4\"") != std::string::npos);
+
+            cxxtools::SerializationInfo entry;
+            cxxtools::JsonDeserializer deserializer(l[0].data(), l[0].size());
+            deserializer.deserialize(entry);
+
+            std::string value;
+            entry.getMember("level") >>= value;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value, "INFO");
+            entry.getMember("category") >>= value;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value, "cxxtools.test.log");
+            // the deserializer decodes utf-8 and the string gets latin-1
+            entry.getMember("message") >>= value;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value, "say \"hello\"\n\tto \\ \x01 and \xe4");
+
+            unsigned long pid = 0;
+            entry.getMember("pid") >>= pid;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(pid, static_cast<unsigned long>(::getpid()));
+
+            // time in the form yyyy-mm-ddThh:mm:ss.fffff+hh:mm
+            entry.getMember("time") >>= value;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value.size(), 31);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value[10], 'T');
+            CXXTOOLS_UNIT_ASSERT(value[25] == '+' || value[25] == '-');
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value[28], ':');
+        }
+
+        void jsonFields()
+        {
+            cxxtools::SerializationInfo si;
+            si.addMember("format") <<= "json";
+            configure(si);
+
+            log_info("request"
+                << cxxtools::LogField("user", std::string("jo\"e"))
+                << cxxtools::LogField("key\n", "v")
+                << cxxtools::LogField("int", -42)
+                << cxxtools::LogField("min", -9223372036854775807LL - 1)
+                << cxxtools::LogField("unsigned", 18446744073709551615ULL)
+                << cxxtools::LogField("float", 0.25)
+                << cxxtools::LogField("nan", 0.0 / 0.0)
+                << cxxtools::LogField("bool", true));
+            quiet();
+
+            std::vector<std::string> l = lines();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(l.size(), 1);
+            CXXTOOLS_UNIT_ASSERT(l[0].find("\"message\":\"request\",\"user\":\"jo\\\"e\",\"key\\n\":\"v\","
+                "\"int\":-42,\"min\":-9223372036854775808,\"unsigned\":18446744073709551615,"
+                "\"float\":0.25,\"nan\":null,\"bool\":true}") != std::string::npos);
+
+            cxxtools::SerializationInfo entry;
+            cxxtools::JsonDeserializer deserializer(l[0].data(), l[0].size());
+            deserializer.deserialize(entry);
+
+            std::string s;
+            entry.getMember("user") >>= s;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(s, "jo\"e");
+            CXXTOOLS_UNIT_ASSERT(entry.findMember("key\n") != 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(entry.getMember("int").typeName(), "int");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(entry.getMember("float").typeName(), "double");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(entry.getMember("bool").typeName(), "bool");
+            CXXTOOLS_UNIT_ASSERT(entry.getMember("nan").isNull());
+        }
+
+        void textFields()
+        {
+            // without the json format fields are appended as key=value
+            cxxtools::SerializationInfo si;
+            configure(si);
+
+            log_info("request"
+                << cxxtools::LogField("user", "joe")
+                << cxxtools::LogField("int", -42)
+                << cxxtools::LogField("unsigned", 7u)
+                << cxxtools::LogField("float", 0.25)
+                << cxxtools::LogField("bool", false));
+            quiet();
+
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t.size(), 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[0], "request user=joe int=-42 unsigned=7 float=0.25 bool=false");
+        }
+
+        void rateLimit()
+        {
+            cxxtools::LogLimiter::setClock(testClock);
+            cxxtools::SerializationInfo si;
+            si.addMember("ratelimit").addMember("cxxtools.test.log") <<= 3;
+            configure(si);
+
+            for (unsigned n = 0; n < 10; ++n)
+                log_info("message " << n);
+
+            // the next message in a new second reports the suppressed ones
+            ++now;
+            log_info("next second");
+
+            // the last burst is reported without another message
+            for (unsigned n = 0; n < 5; ++n)
+                log_info("burst " << n);
+            ++now;
+            cxxtools::LogLimiter::reportSuppressed();
+
+            quiet();
+
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t.size(), 8);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[0], "message 0");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[2], "message 2");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[3], "7 log messages suppressed");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[4], "next second");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[5], "burst 0");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[6], "burst 1");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[7], "3 log messages suppressed");
+        }
+
+        void sample()
+        {
+            cxxtools::LogLimiter::setClock(testClock);
+            cxxtools::SerializationInfo si;
+            si.addMember("sample").addMember("cxxtools.test.log") <<= 0.25;
+            configure(si);
+
+            for (unsigned n = 0; n < 1000; ++n)
+                log_info("message " << n);
+            ++now;
+            cxxtools::LogLimiter::reportSuppressed();
+
+            quiet();
+
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT(!t.empty());
+
+            // the sampled messages are spread evenly
+            unsigned logged = t.size() - 1;
+            CXXTOOLS_UNIT_ASSERT(logged >= 240 && logged <= 260);
+
+            std::string::size_type p = t.back().find(" log messages suppressed");
+            CXXTOOLS_UNIT_ASSERT(p != std::string::npos);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(logged + cxxtools::convert<unsigned>(t.back().substr(0, p)), 1000);
+        }
+
+        void inheritedLimit()
+        {
+            // a category listed only to set its level keeps the limit of
+            // the parent category
+            cxxtools::LogLimiter::setClock(testClock);
+            cxxtools::SerializationInfo si;
+            si.addMember("ratelimit").addMember("cxxtools.test") <<= 3;
+            cxxtools::SerializationInfo& logger = si.addMember("loggers").addMember(std::string());
+            logger.addMember("category") <<= "cxxtools.test.log";
+            logger.addMember("level") <<= "DEBUG";
+            configure(si);
+
+            for (unsigned n = 0; n < 10; ++n)
+                log_debug("message " << n);
+            ++now;
+            cxxtools::LogLimiter::reportSuppressed();
+
+            quiet();
+
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t.size(), 4);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[0], "message 0");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[2], "message 2");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[3], "7 log messages suppressed");
+        }
+
+        void callSiteLimit()
+        {
+            cxxtools::LogLimiter::setClock(testClock);
+            cxxtools::SerializationInfo si;
+            configure(si);
+
+            int line = 0;
+            for (unsigned n = 0; n < 5; ++n)
+            {
+                line = __LINE__; log_info_limit(2, "limited " << n);
+                log_info("unlimited " << n);
+            }
+
+            ++now;
+            cxxtools::LogLimiter::reportSuppressed();
+
+            quiet();
+
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t.size(), 8);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[0], "limited 0");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[1], "unlimited 0");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[2], "limited 1");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[3], "unlimited 1");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[4], "unlimited 2");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[6], "unlimited 4");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[7], "3 log messages suppressed at " __FILE__ ":"
+                + cxxtools::convert<std::string>(line));
+        }
+
+        void setLogLevel()
+        {
+            cxxtools::SerializationInfo si;
+            configure(si);
+
+            cxxtools::Logger* logger = getLogger();
+            CXXTOOLS_UNIT_ASSERT(logger != 0);
+            log_debug("debug 1");
+
+            cxxtools::LoggerManager::getInstance().setLogLevel("cxxtools.test", cxxtools::Logger::LOG_LEVEL_DEBUG);
+            CXXTOOLS_UNIT_ASSERT(getLogger() == logger);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(logger->getLogLevel(), cxxtools::Logger::LOG_LEVEL_DEBUG);
+            log_debug("debug 2");
+
+            // the root level does not override the level of the parent category
+            cxxtools::LoggerManager::getInstance().setLogLevel("", cxxtools::Logger::LOG_LEVEL_ERROR);
+            log_debug("debug 3");
+
+            cxxtools::LoggerManager::getInstance().setLogLevel("cxxtools.test", cxxtools::Logger::LOG_LEVEL_WARN);
+            CXXTOOLS_UNIT_ASSERT(getLogger() == logger);
+            log_info("info");
+            log_warn("warn");
+
+            quiet();
+
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t.size(), 3);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[0], "debug 2");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[1], "debug 3");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[2], "warn");
+        }
+
+        void reconfigure()
+        {
+            cxxtools::SerializationInfo si;
+            configure(si);
+
+            cxxtools::Logger* logger = getLogger();
+            CXXTOOLS_UNIT_ASSERT(logger != 0);
+
+            // loggers created later are kept as well
+            std::vector<cxxtools::Logger*> loggers;
+            for (unsigned n = 0; n < 100; ++n)
+                loggers.push_back(cxxtools::LoggerManager::getInstance().getLogger(
+                    "cxxtools.test.log.sub" + cxxtools::convert<std::string>(n)));
+
+            cxxtools::SerializationInfo levels;
+            levels.addMember("rootlogger") <<= "INFO";
+            cxxtools::SerializationInfo& l = levels.addMember("logger");
+            l.addMember("cxxtools.test.log") <<= "ERROR";
+            l.addMember("cxxtools.test.log.sub7") <<= "DEBUG";
+
+            cxxtools::LoggerManagerConfiguration config;
+            levels >>= config;
+            cxxtools::LoggerManager::getInstance().reconfigure(config);
+
+            CXXTOOLS_UNIT_ASSERT(getLogger() == logger);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(logger->getLogLevel(), cxxtools::Logger::LOG_LEVEL_ERROR);
+
+            for (unsigned n = 0; n < loggers.size(); ++n)
+            {
+                std::string category = "cxxtools.test.log.sub" + cxxtools::convert<std::string>(n);
+                CXXTOOLS_UNIT_ASSERT(cxxtools::LoggerManager::getInstance().getLogger(category) == loggers[n]);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(loggers[n]->getLogLevel(),
+                    (n == 7 ? cxxtools::Logger::LOG_LEVEL_DEBUG : cxxtools::Logger::LOG_LEVEL_ERROR));
+            }
+
+            log_warn("warn");
+            log_error("error");
+
+            quiet();
+
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t.size(), 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[0], "error");
+        }
+
+        void ringBuffer()
+        {
+            ::unlink(ringFname().c_str());
+            configureRingBuffer();
+
+            for (unsigned n = 0; n < 10; ++n)
+                log_info("message " << n);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(dumpRingBuffer(9).size(), 10);
+
+            // a record takes about 100 bytes, so the buffer of 4k wraps
+            // around several times
+            for (unsigned n = 10; n < 500; ++n)
+                log_info("message " << n);
+
+            std::vector<std::string> t = dumpRingBuffer(499);
+            CXXTOOLS_UNIT_ASSERT(t.size() > 20 && t.size() < 50);
+
+            // a new appender continues the existing buffer
+            configureRingBuffer();
+            log_info("message 500");
+            dumpRingBuffer(500);
+        }
+
+        void ringBufferLargePosition()
+        {
+            // create a buffer, which position is just below 4 GB, so
+            // that the position exceeds 32 bits while writing
+            std::vector<char> data(4096 + 4096);
+            memcpy(&data[0], "cxxring", 8);
+            uint32_t size = 4096;
+            memcpy(&data[8], &size, sizeof(size));
+            uint64_t pos = 0xffffff00ull;
+            memcpy(&data[16], &pos, sizeof(pos));
+
+            {
+                std::ofstream f(ringFname().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+                f.write(&data[0], data.size());
+            }
+
+            configureRingBuffer();
+
+            for (unsigned n = 0; n < 100; ++n)
+                log_info("message " << n);
+
+            std::vector<std::string> t = dumpRingBuffer(99);
+            CXXTOOLS_UNIT_ASSERT(t.size() > 20 && t.size() < 50);
+
+            quiet();
+
+            std::ifstream f(ringFname().c_str(), std::ios::in | std::ios::binary);
+            f.read(&data[0], 24);
+            memcpy(&pos, &data[16], sizeof(pos));
+            CXXTOOLS_UNIT_ASSERT(pos > 0x100000000ull);
+        }
+
+        void streamNumbers()
+        {
+            cxxtools::SerializationInfo si;
+            configure(si);
+
+            log_info(0 << ' ' << -1 << ' ' << 42 << ' ' << INT_MIN << ' ' << INT_MAX
+                << ' ' << -123456789L << ' ' << LONG_MIN << ' ' << LONG_MAX
+                << ' ' << 0u << ' ' << UINT_MAX << ' ' << ULONG_MAX);
+            quiet();
+
+            std::ostringstream expected;
+            expected << 0 << ' ' << -1 << ' ' << 42 << ' ' << INT_MIN << ' ' << INT_MAX
+                << ' ' << -123456789L << ' ' << LONG_MIN << ' ' << LONG_MAX
+                << ' ' << 0u << ' ' << UINT_MAX << ' ' << ULONG_MAX;
+
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t.size(), 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[0], expected.str());
+        }
+
+        void streamFormat()
+        {
+            cxxtools::SerializationInfo si;
+            configure(si);
+
+            // a manipulator returns std::ostream, so the flags are set on
+            // the LogStream directly to reach its fallbacks
+            {
+                cxxtools::LogMessage msg(getLogger(), "INFO");
+                cxxtools::LogStream& out = msg.out();
+                out.setf(std::ios::hex, std::ios::basefield);
+                out << 255;
+                out << ' ';
+                out << 255u;
+                out << ' ';
+                out << -1L;
+                out << ' ';
+                out.setf(std::ios::oct, std::ios::basefield);
+                out << 8ul;
+                out.setf(std::ios::dec, std::ios::basefield);
+                out << ' ';
+                out.setf(std::ios::showpos);
+                out << 7;
+                out.unsetf(std::ios::showpos);
+                out << ' ';
+                out.width(5);
+                out << 42;
+                out << '|';
+                out.width(4);
+                out << "ab";
+                out << '|';
+                out.width(3);
+                out << 'c';
+                out << '|';
+                out.fill('0');
+                out.width(4);
+                out << std::string("s");
+                out << '|';
+                out.width(4);
+                out << -5L;
+                msg.finish();
+            }
+
+            // the flags are reset for the next message
+            log_info(255 << ' ' << 7 << "ab" << 'c');
+            quiet();
+
+            std::ostringstream expected;
+            expected << std::hex << 255 << ' ' << 255u << ' ' << -1L
+                << ' ' << std::oct << 8ul << std::dec
+                << ' ' << std::showpos << 7 << std::noshowpos
+                << ' ' << std::setw(5) << 42 << '|' << std::setw(4) << "ab" << '|'
+                << std::setw(3) << 'c' << '|' << std::setfill('0') << std::setw(4) << std::string("s")
+                << '|' << std::setw(4) << -5L;
+
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t.size(), 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[0], expected.str());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[1], "255 7abc");
+        }
+
+        void nestedMessage()
+        {
+            cxxtools::SerializationInfo si;
+            configure(si);
+
+            log_info("before " << Nested(1) << " after " << Nested(2) << " end");
+            log_info("next " << 3);
+            quiet();
+
+            // the nested messages are complete before the outer message
+            std::vector<std::string> t = texts();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t.size(), 4);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[0], "nested 1 inner=1");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[1], "nested 2 inner=2");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[2], "before outer 1 after outer 2 end");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(t[3], "next 3");
+        }
+
+        void fieldsReused()
+        {
+            cxxtools::SerializationInfo si;
+            si.addMember("format") <<= "json";
+            configure(si);
+
+            // the buffers of the thread are reused; the fields of a
+            // message must not show up in the next one
+            log_info("first" << cxxtools::LogField("a", 1));
+            log_info("second" << cxxtools::LogField("b", "x"));
+            log_info("third");
+            log_info("outer " << Nested(4) << cxxtools::LogField("c", true));
+            quiet();
+
+            std::vector<std::string> l = lines();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(l.size(), 5);
+
+            CXXTOOLS_UNIT_ASSERT(endsWith(l[0], "\"message\":\"first\",\"a\":1}"));
+            CXXTOOLS_UNIT_ASSERT(endsWith(l[1], "\"message\":\"second\",\"b\":\"x\"}"));
+            CXXTOOLS_UNIT_ASSERT(endsWith(l[2], "\"message\":\"third\"}"));
+            CXXTOOLS_UNIT_ASSERT(endsWith(l[3], "\"message\":\"nested 4\",\"inner\":4}"));
+            CXXTOOLS_UNIT_ASSERT(endsWith(l[4], "\"message\":\"outer outer 4\",\"c\":true}"));
+        }
+};
+
+cxxtools::unit::RegisterTest<LogTest> register_LogTest;
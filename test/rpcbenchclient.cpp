@@ -27,6 +27,8 @@
  */
 
 #include <iostream>
+#include <fstream>
+#include <vector>
 #include <cxxtools/log.h>
 #include <cxxtools/arg.h>
 #include <cxxtools/remoteprocedure.h>
@@ -34,21 +36,153 @@
 #include <cxxtools/bin/rpcclient.h>
 #include <cxxtools/json/rpcclient.h>
 #include <cxxtools/json/httpclient.h>
+#include <cxxtools/jsonserializer.h>
 #include <cxxtools/thread.h>
 #include <cxxtools/mutex.h>
 #include <cxxtools/clock.h>
 #include <cxxtools/timespan.h>
 #include <cxxtools/atomicity.h>
 
+////////////////////////////////////////////////////////////////////////
+// Histogram of latencies in microseconds.
+//
+// Values below 128 are counted exactly. Larger values are put into
+// buckets of 64 per power of 2, so that the relative error of a reported
+// value is below 1.6%, like in a HdrHistogram with 2 significant digits.
+//
+class LatencyHistogram
+{
+    static const unsigned subBuckets = 64;
+
+    std::vector<uint64_t> _counts;
+    uint64_t _total;
+    uint64_t _min;
+    uint64_t _max;
+    double _sum;
+
+    static unsigned bucketIndex(uint64_t value)
+    {
+      if (value < 2 * subBuckets)
+        return static_cast<unsigned>(value);
+
+      unsigned shift = 0;
+      while ((value >> shift) >= 2 * subBuckets)
+        ++shift;
+
+      return shift * subBuckets + static_cast<unsigned>(value >> shift);
+    }
+
+    static uint64_t bucketValue(unsigned index)
+    {
+      if (index < 2 * subBuckets)
+        return index;
+
+      unsigned shift = index / subBuckets - 1;
+      uint64_t top = index - shift * subBuckets;
+
+      // report the upper bound of the bucket
+      return ((top + 1) << shift) - 1;
+    }
+
+  public:
+    LatencyHistogram()
+      : _total(0),
+        _min(0),
+        _max(0),
+        _sum(0)
+    { }
+
+    void record(uint64_t usecs)
+    {
+      unsigned idx = bucketIndex(usecs);
+      if (idx >= _counts.size())
+        _counts.resize(idx + 1);
+
+      ++_counts[idx];
+
+      if (_total == 0 || usecs < _min)
+        _min = usecs;
+      if (usecs > _max)
+        _max = usecs;
+
+      ++_total;
+      _sum += usecs;
+    }
+
+    void add(const LatencyHistogram& h)
+    {
+      if (h._counts.size() > _counts.size())
+        _counts.resize(h._counts.size());
+
+      for (unsigned n = 0; n < h._counts.size(); ++n)
+        _counts[n] += h._counts[n];
+
+      if (h._total > 0)
+      {
+        if (_total == 0 || h._min < _min)
+          _min = h._min;
+        if (h._max > _max)
+          _max = h._max;
+      }
+
+      _total += h._total;
+      _sum += h._sum;
+    }
+
+    uint64_t total() const
+    { return _total; }
+
+    uint64_t min() const
+    { return _min; }
+
+    uint64_t max() const
+    { return _max; }
+
+    double mean() const
+    { return _total == 0 ? 0 : _sum / _total; }
+
+    // returns the latency, below which p percent of the values are
+    uint64_t percentile(double p) const
+    {
+      if (_total == 0)
+        return 0;
+
+      uint64_t limit = static_cast<uint64_t>(p / 100.0 * _total + 0.5);
+      if (limit < 1)
+        limit = 1;
+
+      uint64_t count = 0;
+      for (unsigned n = 0; n < _counts.size(); ++n)
+      {
+        count += _counts[n];
+        if (count >= limit)
+        {
+          uint64_t v = bucketValue(n);
+          return v > _max ? _max : v;
+        }
+      }
+
+      return _max;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////
+// BenchClient
+//
 class BenchClient
 {
     void exec();
+    void call(cxxtools::RemoteProcedure<std::string, std::string>& echo,
+              cxxtools::RemoteProcedure<std::vector<int>, int, int>& seq);
 
     cxxtools::RemoteClient* client;
     cxxtools::AttachedThread thread;
+    LatencyHistogram _histogram;
 
     static unsigned _numRequests;
     static unsigned _vectorSize;
+    static std::string _message;
+    static double _rate;
     static cxxtools::atomic_t _requestsStarted;
     static cxxtools::atomic_t _requestsFinished;
     static cxxtools::atomic_t _requestsFailed;
@@ -74,6 +208,20 @@ class BenchClient
     static void vectorSize(unsigned n)
     { _vectorSize = n; }
 
+    static unsigned messageSize()
+    { return _message.size(); }
+
+    static void messageSize(unsigned n)
+    { _message.assign(n, 'x'); }
+
+    // number of requests per second and thread in open loop mode;
+    // 0 runs a closed loop, where the next request is sent immediately
+    static double rate()
+    { return _rate; }
+
+    static void rate(double r)
+    { _rate = r; }
+
     static unsigned requestsStarted()
     { return static_cast<unsigned>(cxxtools::atomicGet(_requestsStarted)); }
 
@@ -83,6 +231,9 @@ class BenchClient
     static unsigned requestsFailed()
     { return static_cast<unsigned>(cxxtools::atomicGet(_requestsFailed)); }
 
+    const LatencyHistogram& histogram() const
+    { return _histogram; }
+
     void start()
     { thread.start(); }
 
@@ -95,52 +246,140 @@ cxxtools::atomic_t BenchClient::_requestsFinished(0);
 cxxtools::atomic_t BenchClient::_requestsFailed(0);
 unsigned BenchClient::_numRequests = 0;
 unsigned BenchClient::_vectorSize = 0;
+std::string BenchClient::_message = "hi";
+double BenchClient::_rate = 0;
 typedef std::vector<BenchClient*> BenchClients;
 
 static cxxtools::Mutex mutex;
 
+void BenchClient::call(cxxtools::RemoteProcedure<std::string, std::string>& echo,
+                       cxxtools::RemoteProcedure<std::vector<int>, int, int>& seq)
+{
+  try
+  {
+    if (_vectorSize > 0)
+    {
+      std::vector<int> ret = seq(1, _vectorSize);
+      cxxtools::atomicIncrement(_requestsFinished);
+      if (ret.size() != _vectorSize)
+      {
+        std::cerr << "wrong response result size " << ret.size() << std::endl;
+        cxxtools::atomicIncrement(_requestsFailed);
+      }
+    }
+    else
+    {
+      std::string ret = echo(_message);
+      cxxtools::atomicIncrement(_requestsFinished);
+      if (ret != _message)
+      {
+        std::cerr << "wrong response result \"" << ret << '"' << std::endl;
+        cxxtools::atomicIncrement(_requestsFailed);
+      }
+    }
+  }
+  catch (const std::exception& e)
+  {
+    {
+      cxxtools::MutexLock lock(mutex);
+      std::cerr << "request failed with error message \"" << e.what() << '"' << std::endl;
+    }
+
+    cxxtools::atomicIncrement(_requestsFailed);
+  }
+}
+
 void BenchClient::exec()
 {
   cxxtools::RemoteProcedure<std::string, std::string> echo(*client, "echo");
   cxxtools::RemoteProcedure<std::vector<int>, int, int> seq(*client, "seq");
 
+  // the clock is used as a monotonic time source; stop returns the time
+  // since start without stopping it
+  cxxtools::Clock clock;
+  clock.start();
+
+  double interval = _rate > 0 ? 1e6 / _rate : 0;
+  unsigned count = 0;
+
   while (static_cast<unsigned>(cxxtools::atomicIncrement(_requestsStarted)) <= _numRequests)
   {
-    try
+    int64_t startTime;
+
+    if (interval > 0)
     {
-      if (_vectorSize > 0)
+      // In open loop mode the latency is measured from the time, the
+      // request was scheduled, so that a slow reply is also accounted to
+      // the requests, which were delayed by it.
+      startTime = static_cast<int64_t>(count++ * interval);
+
+      int64_t now;
+      while ((now = clock.stop().totalUSecs()) < startTime)
       {
-        std::vector<int> ret = seq(1, _vectorSize);
-        cxxtools::atomicIncrement(_requestsFinished);
-        if (ret.size() != _vectorSize)
-        {
-          std::cerr << "wrong response result size " << ret.size() << std::endl;
-          cxxtools::atomicIncrement(_requestsFailed);
-        }
-      }
-      else
-      {
-        std::string ret = echo("hi");
-        cxxtools::atomicIncrement(_requestsFinished);
-        if (ret != "hi")
-        {
-          std::cerr << "wrong response result \"" << ret << '"' << std::endl;
-          cxxtools::atomicIncrement(_requestsFailed);
-        }
+        if (startTime - now >= 1000)
+          cxxtools::Thread::sleep(static_cast<unsigned>((startTime - now) / 1000));
+        else
+          cxxtools::Thread::yield();
       }
     }
-    catch (const std::exception& e)
+    else
     {
-      {
-        cxxtools::MutexLock lock(mutex);
-        std::cerr << "request failed with error message \"" << e.what() << '"' << std::endl;
-      }
-
-      cxxtools::atomicIncrement(_requestsFailed);
+      startTime = clock.stop().totalUSecs();
     }
+
+    call(echo, seq);
+
+    _histogram.record(static_cast<uint64_t>(clock.stop().totalUSecs() - startTime));
   }
 }
 
+////////////////////////////////////////////////////////////////////////
+// Result
+//
+struct Result
+{
+  std::string protocol;
+  std::string mode;
+  unsigned threads;
+  double rate;
+  unsigned vectorSize;
+  unsigned messageSize;
+  unsigned requests;
+  unsigned finished;
+  unsigned failed;
+  double seconds;
+  double throughput;
+  LatencyHistogram histogram;
+};
+
+void operator<<= (cxxtools::SerializationInfo& si, const LatencyHistogram& h)
+{
+  si.addMember("count") <<= h.total();
+  si.addMember("min") <<= h.min();
+  si.addMember("mean") <<= h.mean();
+  si.addMember("p50") <<= h.percentile(50);
+  si.addMember("p90") <<= h.percentile(90);
+  si.addMember("p99") <<= h.percentile(99);
+  si.addMember("p999") <<= h.percentile(99.9);
+  si.addMember("max") <<= h.max();
+}
+
+void operator<<= (cxxtools::SerializationInfo& si, const Result& r)
+{
+  si.addMember("protocol") <<= r.protocol;
+  si.addMember("mode") <<= r.mode;
+  si.addMember("threads") <<= r.threads;
+  si.addMember("rate") <<= r.rate;
+  si.addMember("vectorSize") <<= r.vectorSize;
+  si.addMember("messageSize") <<= r.messageSize;
+  si.addMember("requests") <<= r.requests;
+  si.addMember("finished") <<= r.finished;
+  si.addMember("failed") <<= r.failed;
+  si.addMember("seconds") <<= r.seconds;
+  si.addMember("throughput") <<= r.throughput;
+  si.addMember("latencyUSecs") <<= r.histogram;
+}
+
 int main(int argc, char* argv[])
 {
   try
@@ -154,8 +393,11 @@ int main(int argc, char* argv[])
     cxxtools::Arg<bool> json(argc, argv, 'j');
     cxxtools::Arg<bool> jsonhttp(argc, argv, 'J');
     cxxtools::Arg<unsigned short> port(argc, argv, 'p', binary ? 7003 : json ? 7004 : 7002);
+    cxxtools::Arg<double> rate(argc, argv, 'r', 0);
+    cxxtools::Arg<std::string> output(argc, argv, 'o');
     BenchClient::numRequests(cxxtools::Arg<unsigned>(argc, argv, 'n', 10000));
     BenchClient::vectorSize(cxxtools::Arg<unsigned>(argc, argv, 'v', 0));
+    BenchClient::messageSize(cxxtools::Arg<unsigned>(argc, argv, 's', 2));
 
     if (!xmlrpc && !binary && !json && !jsonhttp)
     {
@@ -169,11 +411,18 @@ int main(int argc, char* argv[])
                      "   -J         use json rpc over http protocol\n"
                      "   -t number  set number of threads (default: 4)\n"
                      "   -n number  set number of requests (default: 10000)\n"
+                     "   -v number  request a vector of integers of this size instead of echoing a string\n"
+                     "   -s number  set size of the echoed string (default: 2)\n"
+                     "   -r number  send a fixed rate of requests per second (open loop, default: closed loop)\n"
+                     "   -o file    write results in json format to file (\"-\" for stdout)\n"
                      "one protocol must be selected\n"
                   << std::endl;
         return -1;
     }
 
+    if (rate > 0)
+      BenchClient::rate(rate / threads);
+
     BenchClients clients;
 
     while (clients.size() < threads)
@@ -202,8 +451,48 @@ int main(int argc, char* argv[])
 
     cxxtools::Timespan t = cl.stop();
 
-    std::cout << BenchClient::numRequests() << " requests in " << t.totalMSecs()/1e3 << " s => " << (BenchClient::requestsStarted() / (t.totalMSecs()/1e3)) << "#/s\n"
-              << BenchClient::requestsFinished() << " finished " << BenchClient::requestsFailed() << " failed" << std::endl;
+    Result result;
+    result.protocol = binary ? "bin" : json ? "json" : jsonhttp ? "jsonhttp" : "xmlrpc";
+    result.mode = rate > 0 ? "open" : "closed";
+    result.threads = threads;
+    result.rate = rate;
+    result.vectorSize = BenchClient::vectorSize();
+    result.messageSize = BenchClient::messageSize();
+    result.requests = BenchClient::numRequests();
+    result.finished = BenchClient::requestsFinished();
+    result.failed = BenchClient::requestsFailed();
+    result.seconds = t.totalMSecs() / 1e3;
+    result.throughput = result.finished / result.seconds;
+
+    for (BenchClients::iterator it = clients.begin(); it != clients.end(); ++it)
+      result.histogram.add((*it)->histogram());
+
+    std::cout << result.requests << " requests in " << result.seconds << " s => " << result.throughput << "#/s\n"
+              << result.finished << " finished " << result.failed << " failed\n"
+              << "latency (usecs): min " << result.histogram.min()
+              << " mean " << result.histogram.mean()
+              << " p50 " << result.histogram.percentile(50)
+              << " p90 " << result.histogram.percentile(90)
+              << " p99 " << result.histogram.percentile(99)
+              << " p999 " << result.histogram.percentile(99.9)
+              << " max " << result.histogram.max() << std::endl;
+
+    if (output.isSet())
+    {
+      std::ofstream file;
+      if (output.getValue() != "-")
+      {
+        file.open(output.getValue().c_str());
+        if (!file)
+          throw std::runtime_error("failed to open output file \"" + output.getValue() + '"');
+      }
+
+      std::ostream& out = file.is_open() ? file : std::cout;
+      cxxtools::JsonSerializer serializer(out);
+      serializer.beautify(true);
+      serializer.serialize(result).finish();
+      out << std::endl;
+    }
 
     for (BenchClients::iterator it = clients.begin(); it != clients.end(); ++it)
       delete *it;
@@ -213,4 +502,3 @@ int main(int argc, char* argv[])
     std::cerr << e.what() << std::endl;
   }
 }
-
@@ -62,6 +62,7 @@ int main(int argc, char* argv[])
     cxxtools::Arg<unsigned short> jport(argc, argv, 'j', 7004);
     cxxtools::Arg<unsigned> threads(argc, argv, 't', 4);
     cxxtools::Arg<unsigned> maxThreads(argc, argv, 'T', 200);
+    cxxtools::Arg<bool> eventDriven(argc, argv, 'e');
 
     std::cout << "rpc echo server running on port " << port.getValue() << "\n\n"
                  "options:\n\n"
@@ -71,6 +72,7 @@ int main(int argc, char* argv[])
                  "   -j number  set port number run json rpc server (default: 7004)\n"
                  "   -t number  set minimum number of threads (default: 4)\n"
                  "   -T number  set maximum number of threads (default: 200)\n"
+                 "   -e         run binary and json rpc server event driven with a pool of maximum threads\n"
               << std::endl;
 
     cxxtools::EventLoop loop;
@@ -86,11 +88,13 @@ int main(int argc, char* argv[])
     cxxtools::bin::RpcServer binServer(loop, ip, bport);
     binServer.minThreads(threads);
     binServer.maxThreads(maxThreads);
-    binServer.addService("", service);
+    binServer.eventDriven(eventDriven);
+    binServer.addService(service);
 
     cxxtools::json::RpcServer jsonServer(loop, ip, jport);
     jsonServer.minThreads(threads);
     jsonServer.maxThreads(maxThreads);
+    jsonServer.eventDriven(eventDriven);
     jsonServer.addService("", service);
 
     cxxtools::json::HttpService jsonhttpService;
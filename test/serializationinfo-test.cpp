@@ -58,6 +58,10 @@ class SerializationInfoTest : public cxxtools::unit::TestSuite
             registerMethod("testSiSwap", *this, &SerializationInfoTest::testSiSwap);
             registerMethod("testStringToBool", *this, &SerializationInfoTest::testStringToBool);
             registerMethod("testRangeCheck", *this, &SerializationInfoTest::testRangeCheck);
+            registerMethod("testFindMember", *this, &SerializationInfoTest::testFindMember);
+            registerMethod("testGetMemberHint", *this, &SerializationInfoTest::testGetMemberHint);
+            registerMethod("testRecycle", *this, &SerializationInfoTest::testRecycle);
+            registerMethod("testRecycleShrink", *this, &SerializationInfoTest::testRecycleShrink);
         }
 
         void testSiSet()
@@ -441,6 +445,199 @@ class SerializationInfoTest : public cxxtools::unit::TestSuite
             CXXTOOLS_UNIT_ASSERT_NOTHROW(siValue<long>(si));
         }
 
+        void testFindMember()
+        {
+            cxxtools::SerializationInfo si;
+            for (int n = 0; n < 100; ++n)
+                si.addMember(cxxtools::convert<std::string>(n)) <<= n;
+
+            int value;
+            cxxtools::SerializationInfo::Hint hint;
+            const cxxtools::SerializationInfo* p;
+
+            // in order
+            for (int n = 0; n < 100; ++n)
+            {
+                p = si.findMember(cxxtools::convert<std::string>(n), hint);
+                CXXTOOLS_UNIT_ASSERT(p != 0);
+                *p >>= value;
+                CXXTOOLS_UNIT_ASSERT_EQUALS(value, n);
+                CXXTOOLS_UNIT_ASSERT_EQUALS(hint.pos(), static_cast<size_t>(n + 1));
+            }
+
+            // reverse order
+            for (int n = 99; n >= 0; --n)
+            {
+                p = si.findMember(cxxtools::convert<std::string>(n), hint);
+                CXXTOOLS_UNIT_ASSERT(p != 0);
+                *p >>= value;
+                CXXTOOLS_UNIT_ASSERT_EQUALS(value, n);
+            }
+
+            // skipping members and wrapping around
+            hint = cxxtools::SerializationInfo::Hint();
+            si.findMember("50", hint);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(hint.pos(), 51);
+            p = si.findMember("10", hint);
+            CXXTOOLS_UNIT_ASSERT(p != 0);
+            *p >>= value;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value, 10);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(hint.pos(), 11);
+
+            // a member not found leaves the hint alone
+            CXXTOOLS_UNIT_ASSERT(si.findMember("100", hint) == 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(hint.pos(), 11);
+
+            // a hint out of range starts at the beginning
+            hint = cxxtools::SerializationInfo::Hint(1000);
+            CXXTOOLS_UNIT_ASSERT(si.findMember("0", hint) != 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(hint.pos(), 1);
+
+            // lookups without hint do not depend on previous lookups
+            si.getMember("99") >>= value;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value, 99);
+            si.getMember("0") >>= value;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value, 0);
+            CXXTOOLS_UNIT_ASSERT(si.findMember("100") == 0);
+            CXXTOOLS_UNIT_ASSERT_THROW(si.getMember("100"), cxxtools::SerializationMemberNotFound);
+        }
+
+        void testGetMemberHint()
+        {
+            // a wide object is read in the order it was written
+            const unsigned count = 1000;
+            cxxtools::SerializationInfo si;
+            for (unsigned n = 0; n < count; ++n)
+                si.addMember("m" + cxxtools::convert<std::string>(n)) <<= n;
+
+            cxxtools::SerializationInfo::Hint hint;
+            unsigned value;
+            for (unsigned n = 0; n < count; ++n)
+            {
+                // the search starts at the requested member, so each lookup
+                // takes a single comparison instead of n + 1
+                CXXTOOLS_UNIT_ASSERT_EQUALS(hint.pos(), n);
+                value = count;
+                CXXTOOLS_UNIT_ASSERT(si.getMember("m" + cxxtools::convert<std::string>(n), value, hint));
+                CXXTOOLS_UNIT_ASSERT_EQUALS(value, n);
+            }
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(hint.pos(), count);
+
+            // a member not found leaves value and hint alone
+            value = count;
+            CXXTOOLS_UNIT_ASSERT(!si.getMember("x", value, hint));
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value, count);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(hint.pos(), count);
+
+            // the throwing variant
+            hint = cxxtools::SerializationInfo::Hint();
+            si.getMember("m0", hint) >>= value;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value, 0);
+            si.getMember("m1", hint) >>= value;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value, 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(hint.pos(), 2);
+            CXXTOOLS_UNIT_ASSERT_THROW(si.getMember("x", hint), cxxtools::SerializationMemberNotFound);
+
+            // readers using a hint accept members in any order
+            cxxtools::SerializationInfo pair;
+            pair.addMember("second") <<= "two";
+            pair.addMember("first") <<= 1;
+            std::pair<int, std::string> p;
+            pair >>= p;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(p.first, 1);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(p.second, "two");
+        }
+
+        void testRecycle()
+        {
+            cxxtools::SerializationInfo si;
+            si.setTypeName("foo");
+            si.addMember("a") <<= 17;
+            si.addMember("b") <<= "hello";
+            si.addMember("c").addMember("d") <<= true;
+
+            si.recycle();
+            CXXTOOLS_UNIT_ASSERT(si.isNull());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(si.memberCount(), 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(si.typeName(), "");
+            CXXTOOLS_UNIT_ASSERT(si.begin() == si.end());
+            CXXTOOLS_UNIT_ASSERT(si.findMember("a") == 0);
+
+            si.addMember("x");
+            si.addMember("c");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(si.memberCount(), 2);
+
+            const cxxtools::SerializationInfo& x = si.getMember("x");
+            CXXTOOLS_UNIT_ASSERT(x.isNull());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(x.memberCount(), 0);
+
+            const cxxtools::SerializationInfo& c = si.getMember("c");
+            CXXTOOLS_UNIT_ASSERT(c.isNull());
+            CXXTOOLS_UNIT_ASSERT_EQUALS(c.memberCount(), 0);
+            CXXTOOLS_UNIT_ASSERT(c.findMember("d") == 0);
+
+            cxxtools::SerializationInfo si2(si);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(si2.memberCount(), 2);
+
+            const cxxtools::SerializationInfo& csi = si2;
+            unsigned count = 0;
+            for (cxxtools::SerializationInfo::ConstIterator it = csi.begin(); it != csi.end(); ++it)
+                ++count;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(count, 2);
+        }
+
+
+        void testRecycleShrink()
+        {
+            cxxtools::SerializationInfo si;
+            for (int n = 0; n < 100; ++n)
+                si.addMember(cxxtools::convert<std::string>(n)).addMember("v") <<= n;
+
+            // fewer members after recycle
+            si.recycle();
+            for (int n = 0; n < 3; ++n)
+                si.addMember(cxxtools::convert<std::string>(n)) <<= n * 2;
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(si.memberCount(), 3);
+            CXXTOOLS_UNIT_ASSERT(si.findMember("3") == 0);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(si.getMember("1").memberCount(), 0);
+
+            cxxtools::SerializationInfo si2(si);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(si2.memberCount(), 3);
+
+            // more members than kept after recycle
+            si.recycle();
+            for (int n = 0; n < 50; ++n)
+                si.addMember(cxxtools::convert<std::string>(n)) <<= n;
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(si.memberCount(), 50);
+            int value;
+            for (int n = 0; n < 50; ++n)
+            {
+                si.getMember(cxxtools::convert<std::string>(n)) >>= value;
+                CXXTOOLS_UNIT_ASSERT_EQUALS(value, n);
+            }
+
+            unsigned count = 0;
+            for (cxxtools::SerializationInfo::Iterator it = si.begin(); it != si.end(); ++it)
+                ++count;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(count, 50);
+
+            // shrink keeps the members
+            si.recycle();
+            si.addMember("a").addMember("b") <<= 5;
+            si.shrink();
+            CXXTOOLS_UNIT_ASSERT_EQUALS(si.memberCount(), 1);
+            si.getMember("a").getMember("b") >>= value;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value, 5);
+
+            si.addMember("c") <<= 7;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(si.memberCount(), 2);
+            si.getMember("c") >>= value;
+            CXXTOOLS_UNIT_ASSERT_EQUALS(value, 7);
+        }
+
 };
 
 cxxtools::unit::RegisterTest<SerializationInfoTest> register_SerializationInfoTest;
@@ -68,6 +68,16 @@ namespace
         si.setTypeName("TestObject");
     }
 
+    void formatValue(cxxtools::Formatter& formatter, const TestObject& obj, const std::string& name)
+    {
+        formatter.beginObject(name, "TestObject");
+        cxxtools::formatMember(formatter, "intValue", obj.intValue);
+        cxxtools::formatMember(formatter, "stringValue", obj.stringValue);
+        cxxtools::formatMember(formatter, "doubleValue", obj.doubleValue);
+        cxxtools::formatMember(formatter, "boolValue", obj.boolValue);
+        formatter.finishObject();
+    }
+
     class JsonSerializer2 : public cxxtools::JsonSerializer
     {
         public:
@@ -88,7 +98,26 @@ namespace
                 cxxtools::JsonSerializer::serialize(v);
                 return *this;
             }
+
+            template <typename T>
+            JsonSerializer2& serializeDirect(const T& v, const std::string& name)
+            {
+                cxxtools::JsonSerializer::serializeDirect(v);
+                return *this;
+            }
     };
+
+    bool direct = false;
+    bool dictionary = false;
+
+    template <typename Serializer>
+    void setup(Serializer&)
+    { }
+
+    void setup(cxxtools::bin::Serializer& serializer)
+    {
+        serializer.useDictionary(dictionary);
+    }
 }
 
 template <typename T, typename Serializer, typename Deserializer>
@@ -97,10 +126,14 @@ void benchSerialization(const T& d, const char* fname = 0)
     std::stringstream data;
     Serializer serializer(data);
     Deserializer deserializer(data);
+    setup(serializer);
 
     cxxtools::Clock clock;
     clock.start();
-    serializer.serialize(d, "d");
+    if (direct)
+        serializer.serializeDirect(d, "d");
+    else
+        serializer.serialize(d, "d");
     serializer.finish();
     cxxtools::Timespan ts = clock.stop();
     if (fname)
@@ -111,7 +144,10 @@ void benchSerialization(const T& d, const char* fname = 0)
 
     T v2;
     clock.start();
-    deserializer.deserialize(v2);
+    if (direct)
+        deserializer.deserializeElements(v2);
+    else
+        deserializer.deserialize(v2);
     cxxtools::Timespan td = clock.stop();
 
     std::cout << "\tserialization: " << ts.toUSecs() / 1e6 << " sec\n"
@@ -168,6 +204,8 @@ int main(int argc, char* argv[])
         cxxtools::Arg<unsigned> D(argc, argv, 'D', nn);
         cxxtools::Arg<unsigned> C(argc, argv, 'C', nn);
         cxxtools::Arg<bool> fileoutput(argc, argv, 'f');
+        direct = cxxtools::Arg<bool>(argc, argv, 's');
+        dictionary = cxxtools::Arg<bool>(argc, argv, 'd');
 
         std::cout << "benchmark serializer with " << I.getValue() << " int vector " << D.getValue() << " double vector and " << C.getValue() << " custom vector iterations\n\n"
                      "options:\n"
@@ -175,7 +213,9 @@ int main(int argc, char* argv[])
                      "   -I <number>       specify number of iterations for int vector\n"
                      "   -D <number>       specify number of iterations for double vector\n"
                      "   -C <number>       specify number of iterations for custom object\n"
-                     "   -f                write serialized output to files\n" << std::endl;
+                     "   -f                write serialized output to files\n"
+                     "   -s                use serializeDirect and deserializeElements\n"
+                     "   -d                compress names in bin format with a dictionary\n" << std::endl;
 
         if (I.getValue() > 0)
             benchVector<int>("int", I, 1, fileoutput);
@@ -119,6 +119,7 @@ class XmlSerializerTest : public cxxtools::unit::TestSuite
             registerMethod("testComplexObject", *this, &XmlSerializerTest::testComplexObject);
             registerMethod("testObjectVector", *this, &XmlSerializerTest::testObjectVector);
             registerMethod("testBinaryData", *this, &XmlSerializerTest::testBinaryData);
+            registerMethod("testSerializeDirect", *this, &XmlSerializerTest::testSerializeDirect);
         }
 
         void testScalar()
@@ -386,6 +387,41 @@ class XmlSerializerTest : public cxxtools::unit::TestSuite
             CXXTOOLS_UNIT_ASSERT(v == v2);
 
         }
+        void testSerializeDirect()
+        {
+            std::vector<TestObject> obj;
+            obj.resize(2);
+            obj[0].intValue = 17;
+            obj[0].stringValue = "foobar";
+            obj[0].doubleValue = 3.125;
+            obj[0].boolValue = true;
+            obj[1].intValue = 18;
+            obj[1].stringValue = "hi there";
+            obj[1].doubleValue = -17.25;
+            obj[1].boolValue = false;
+
+            std::stringstream tree;
+            cxxtools::xml::XmlSerializer treeSerializer(tree);
+            treeSerializer.serialize(obj, "v");
+            treeSerializer.finish();
+
+            std::stringstream direct;
+            cxxtools::xml::XmlSerializer directSerializer(direct);
+            directSerializer.serializeDirect(obj, "v");
+            directSerializer.finish();
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(tree.str(), direct.str());
+
+            std::vector<TestObject> obj2;
+            cxxtools::xml::XmlDeserializer deserializer(direct);
+            deserializer.deserializeElements(obj2);
+
+            CXXTOOLS_UNIT_ASSERT_EQUALS(obj2.size(), 2);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(obj2[0].intValue, 17);
+            CXXTOOLS_UNIT_ASSERT_EQUALS(obj2[1].stringValue, "hi there");
+            CXXTOOLS_UNIT_ASSERT_EQUALS(obj2[1].doubleValue, -17.25);
+        }
+
 };
 
 cxxtools::unit::RegisterTest<XmlSerializerTest> register_XmlSerializerTest;